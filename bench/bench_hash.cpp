@@ -0,0 +1,128 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "hash/blake2b.hpp"
+#include "hash/sha512.hpp"
+
+#include <sse/crypto/hmac.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using sse::crypto::hash::blake2b;
+using sse::crypto::hash::sha512;
+
+constexpr size_t kLanes = sha512::kLanes;
+
+// Hash a state.range(0) bytes input with the hash function H
+template<class H>
+static void Hash_single(benchmark::State& state)
+{
+    const size_t               len = static_cast<size_t>(state.range(0));
+    std::vector<unsigned char> in(len, 0x42);
+    unsigned char              digest[H::kDigestSize];
+
+    for (auto _ : state) {
+        H::hash(in.data(), len, digest);
+        benchmark::DoNotOptimize(digest);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// Hash kLanes inputs of state.range(0) bytes with the multi-buffer SHA-512
+// implementation Impl
+template<sha512::x4_implementation Impl>
+static void Sha512_x4(benchmark::State& state)
+{
+    const sha512::x4_implementation previous = sha512::get_x4_implementation();
+    if (!sha512::set_x4_implementation(Impl)) {
+        state.SkipWithError("Implementation not supported by the CPU");
+        return;
+    }
+
+    const size_t len = static_cast<size_t>(state.range(0));
+    std::vector<std::vector<unsigned char>> in(
+        kLanes, std::vector<unsigned char>(len, 0x42));
+    unsigned char digests[kLanes][sha512::kDigestSize];
+
+    const unsigned char* in_ptrs[kLanes];
+    unsigned char*       digest_ptrs[kLanes];
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        in_ptrs[lane]     = in[lane].data();
+        digest_ptrs[lane] = digests[lane];
+    }
+
+    for (auto _ : state) {
+        sha512::hash_x4(in_ptrs, len, digest_ptrs);
+        benchmark::DoNotOptimize(digests);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * kLanes);
+
+    sha512::set_x4_implementation(previous);
+}
+
+// HMAC-SHA512 of kLanes 64 bytes inputs, one after the other
+static void HMac_sha512(benchmark::State& state)
+{
+    sse::crypto::HMac<sha512, 32> hmac;
+    unsigned char                 in[64] = {0};
+    unsigned char                 out[sha512::kDigestSize];
+
+    for (auto _ : state) {
+        for (size_t lane = 0; lane < kLanes; lane++) {
+            hmac.hmac(in, sizeof(in), out);
+            benchmark::DoNotOptimize(out);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kLanes);
+}
+
+// HMAC-SHA512 of kLanes 64 bytes inputs, with the multi-buffer implementation
+static void HMac_sha512_x4(benchmark::State& state)
+{
+    sse::crypto::HMac<sha512, 32> hmac;
+    unsigned char                 in[kLanes][64] = {{0}};
+    unsigned char                 out[kLanes][sha512::kDigestSize];
+
+    const unsigned char* in_ptrs[kLanes]  = {in[0], in[1], in[2], in[3]};
+    unsigned char*       out_ptrs[kLanes] = {out[0], out[1], out[2], out[3]};
+
+    for (auto _ : state) {
+        hmac.hmac_x4(in_ptrs, sizeof(in[0]), out_ptrs);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * kLanes);
+}
+
+BENCHMARK_TEMPLATE(Hash_single, blake2b)
+    ->RangeMultiplier(8)
+    ->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(Hash_single, sha512)
+    ->RangeMultiplier(8)
+    ->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(Sha512_x4, sha512::x4_implementation::portable)
+    ->RangeMultiplier(8)
+    ->Range(64, 1 << 20);
+BENCHMARK_TEMPLATE(Sha512_x4, sha512::x4_implementation::avx2)
+    ->RangeMultiplier(8)
+    ->Range(64, 1 << 20);
+BENCHMARK(HMac_sha512);
+BENCHMARK(HMac_sha512_x4);
@@ -0,0 +1,335 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "ppke/GMPpke.hpp"
+
+#include <sse/crypto/puncturable_enc.hpp>
+#include <sse/crypto/utils.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <map>
+#include <utility>
+#include <vector>
+
+using sse::crypto::Gmppke;
+using sse::crypto::GmppkePrivateKey;
+using sse::crypto::GmppkePublicKey;
+using sse::crypto::GmppkeSecretParameters;
+using sse::crypto::PuncturableDecryption;
+using sse::crypto::PuncturableEncryption;
+using sse::crypto::punct::ciphertext_type;
+using sse::crypto::punct::master_key_type;
+using sse::crypto::punct::punctured_key_type;
+using sse::crypto::punct::tag_type;
+
+// Largest number of punctures in the decryption benchmarks
+constexpr static int64_t kMaxPunctures = 4096;
+
+// The tags of the punctures and of the encryptions differ by their first byte
+static tag_type bench_tag(const uint8_t prefix, const uint64_t i)
+{
+    tag_type tag{};
+    tag[0] = prefix;
+    for (size_t j = 0; j < sizeof(i); j++) {
+        tag[8 + j] = static_cast<uint8_t>(i >> (8 * j));
+    }
+    return tag;
+}
+
+// All the benchmarks share the same encryptor, so that the punctured keys
+// can be reused from one benchmark to the other.
+static PuncturableEncryption& bench_encryptor()
+{
+    static PuncturableEncryption encryptor{master_key_type()};
+    return encryptor;
+}
+
+// Generating a key with thousands of punctures takes a while: only do it once
+static const punctured_key_type& punctured_key(const size_t n_punctures)
+{
+    static std::map<size_t, punctured_key_type> keys;
+
+    auto it = keys.find(n_punctures);
+    if (it == keys.end()) {
+        PuncturableEncryption& encryptor = bench_encryptor();
+
+        punctured_key_type key;
+        key.push_back(encryptor.initial_keyshare(n_punctures));
+        for (size_t p = 0; p < n_punctures; p++) {
+            key.push_back(encryptor.inc_puncture(p + 1, bench_tag(0xAA, p)));
+        }
+        it = keys.emplace(n_punctures, std::move(key)).first;
+    }
+    return it->second;
+}
+
+// Reports the average number of pairings, exponentiations and point
+// decompressions per iteration, since the before snapshot. The counters are
+// only reported when the library is compiled with ENABLE_STATISTICS.
+static void report_operations(benchmark::State&              state,
+                              const sse::crypto::Statistics& before)
+{
+    if (!sse::crypto::statistics_enabled()) {
+        return;
+    }
+
+    const sse::crypto::Statistics after = sse::crypto::statistics_snapshot();
+
+    state.counters["pairings"]
+        = benchmark::Counter(static_cast<double>(after.pairings
+                                                 - before.pairings),
+                             benchmark::Counter::kAvgIterations);
+    state.counters["exponentiations"]
+        = benchmark::Counter(static_cast<double>(after.exponentiations
+                                                 - before.exponentiations),
+                             benchmark::Counter::kAvgIterations);
+    state.counters["decompressions"]
+        = benchmark::Counter(static_cast<double>(after.decompressions
+                                                 - before.decompressions),
+                             benchmark::Counter::kAvgIterations);
+}
+
+// Randomized key generation of the underlying scheme
+static void PPKE_keygen(benchmark::State& state)
+{
+    Gmppke ppke;
+
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+    for (auto _ : state) {
+        GmppkePublicKey        pk;
+        GmppkePrivateKey       sk;
+        GmppkeSecretParameters sp;
+        ppke.keygen(pk, sk, sp);
+        benchmark::DoNotOptimize(sk);
+    }
+    report_operations(state, before);
+}
+
+BENCHMARK(PPKE_keygen)->Unit(benchmark::kMicrosecond);
+
+// Pseudo-random parameters generation, done by the constructor of
+// PuncturableEncryption
+static void PPKE_paramgen(benchmark::State& state)
+{
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+    for (auto _ : state) {
+        PuncturableEncryption encryptor{master_key_type()};
+        benchmark::DoNotOptimize(&encryptor);
+    }
+    report_operations(state, before);
+}
+
+BENCHMARK(PPKE_paramgen)->Unit(benchmark::kMicrosecond);
+
+static void PPKE_encrypt(benchmark::State& state)
+{
+    PuncturableEncryption& encryptor = bench_encryptor();
+
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+    uint64_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(encryptor.encrypt(i, bench_tag(0xBB, i)));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    report_operations(state, before);
+}
+
+BENCHMARK(PPKE_encrypt)->Unit(benchmark::kMicrosecond);
+
+// Batch encryption of state.range(0) messages, using state.range(1) threads
+static void PPKE_encrypt_batch(benchmark::State& state)
+{
+    PuncturableEncryption& encryptor = bench_encryptor();
+
+    std::vector<std::pair<uint64_t, tag_type>> messages;
+    for (uint64_t i = 0; i < static_cast<uint64_t>(state.range(0)); i++) {
+        messages.emplace_back(i, bench_tag(0xBB, i));
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(encryptor.encrypt_batch(
+            messages, static_cast<unsigned int>(state.range(1))));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(PPKE_encrypt_batch)
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(10)
+    ->Ranges({{1, 100000}, {1, 1}})
+    ->Args({100000, 4})
+    ->Args({100000, 0});
+
+static void PPKE_initial_keyshare(benchmark::State& state)
+{
+    PuncturableEncryption& encryptor = bench_encryptor();
+
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+    size_t d = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(encryptor.initial_keyshare(d));
+        d++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    report_operations(state, before);
+}
+
+BENCHMARK(PPKE_initial_keyshare)->Unit(benchmark::kMicrosecond);
+
+static void PPKE_inc_puncture(benchmark::State& state)
+{
+    PuncturableEncryption& encryptor = bench_encryptor();
+
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+    size_t d = 1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            encryptor.inc_puncture(d, bench_tag(0xAA, d - 1)));
+        d++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    report_operations(state, before);
+}
+
+BENCHMARK(PPKE_inc_puncture)->Unit(benchmark::kMicrosecond);
+
+// Decryption time as a function of the number of punctures (state.range(0)),
+// with (state.range(1) == 1) or without fixed-base tables
+static void PPKE_decrypt(benchmark::State& state)
+{
+    PuncturableEncryption& encryptor = bench_encryptor();
+    PuncturableDecryption  decryptor(
+        punctured_key(static_cast<size_t>(state.range(0))),
+        state.range(1) != 0);
+
+    std::vector<ciphertext_type> cts;
+    for (uint64_t i = 0; i < 16; i++) {
+        cts.push_back(encryptor.encrypt(i, bench_tag(0xBB, i)));
+    }
+
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+    size_t   i = 0;
+    uint64_t m;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decryptor.decrypt(cts[i % cts.size()], m));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    report_operations(state, before);
+}
+
+BENCHMARK(PPKE_decrypt)
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Ranges({{1, kMaxPunctures}, {0, 1}});
+
+// Decryption time with state.range(0) punctures, with the key shares split
+// between state.range(1) threads, whatever their number, with
+// (state.range(2) == 1) or without fixed-base tables. Used to choose the
+// minimum number of shares per thread (set_min_shares_per_thread): it is the
+// number of shares per thread above which splitting pays off.
+static void PPKE_parallel_decrypt(benchmark::State& state)
+{
+    PuncturableEncryption& encryptor = bench_encryptor();
+    PuncturableDecryption  decryptor(
+        punctured_key(static_cast<size_t>(state.range(0))),
+        state.range(2) != 0);
+    const auto n_threads = static_cast<unsigned int>(state.range(1));
+
+    const ciphertext_type ct = encryptor.encrypt(0, bench_tag(0xBB, 0));
+
+    PuncturableDecryption::set_min_shares_per_thread(1);
+
+    uint64_t m;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decryptor.decrypt(ct, m, n_threads));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    PuncturableDecryption::set_min_shares_per_thread(
+        Gmppke::kMinSharesPerThread);
+}
+
+BENCHMARK(PPKE_parallel_decrypt)
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(2)
+    ->Ranges({{2, 256}, {1, 4}, {0, 1}});
+
+// Construction of a decryptor with state.range(0) punctures, from the
+// punctured key (state.range(1) == 0) or from a snapshot, with
+// (state.range(2) == 1) or without fixed-base tables. With PPKE_decrypt, it
+// gives the number of decryptions after which the tables pay off.
+static void PPKE_load_decryptor(benchmark::State& state)
+{
+    const punctured_key_type& key
+        = punctured_key(static_cast<size_t>(state.range(0)));
+    const std::vector<uint8_t> snapshot = PuncturableDecryption(key).snapshot();
+    const bool                 tables   = state.range(2) != 0;
+
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+    for (auto _ : state) {
+        if (state.range(1) == 0) {
+            PuncturableDecryption decryptor(key, tables);
+            benchmark::DoNotOptimize(&decryptor);
+        } else {
+            PuncturableDecryption decryptor(snapshot, tables);
+            benchmark::DoNotOptimize(&decryptor);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (state.range(0) + 1));
+    report_operations(state, before);
+}
+
+BENCHMARK(PPKE_load_decryptor)
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Ranges({{1, kMaxPunctures}, {0, 1}, {0, 1}});
+
+// Decryption throughput when state.threads threads share a decryptor with
+// 64 punctures
+static void PPKE_concurrent_decrypt(benchmark::State& state)
+{
+    // initialized once, by the first thread
+    static PuncturableDecryption decryptor(punctured_key(64));
+
+    // every thread encrypts its own ciphertexts
+    PuncturableEncryption&       encryptor = bench_encryptor();
+    std::vector<ciphertext_type> cts;
+    for (uint64_t i = 0; i < 16; i++) {
+        cts.push_back(encryptor.encrypt(i, bench_tag(0xBB, i)));
+    }
+
+    size_t   i = 0;
+    uint64_t m;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decryptor.decrypt(cts[i % cts.size()], m));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(PPKE_concurrent_decrypt)
+    ->Unit(benchmark::kMillisecond)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
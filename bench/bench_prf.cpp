@@ -0,0 +1,58 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <sse/crypto/hash.hpp>
+#include <sse/crypto/hmac.hpp>
+#include <sse/crypto/keyed_hash.hpp>
+#include <sse/crypto/prf.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using sse::crypto::Hash;
+using sse::crypto::HMac;
+using sse::crypto::KeyedBlake2b;
+using sse::crypto::Prf;
+
+using HMacBlake2b = HMac<Hash, 32>;
+
+// Evaluate a Prf<NBYTES, PrfBase> on state.range(0) bytes inputs
+template<uint16_t NBYTES, class PrfBase>
+static void Prf_eval(benchmark::State& state)
+{
+    Prf<NBYTES, PrfBase>       prf;
+    std::vector<unsigned char> in(static_cast<size_t>(state.range(0)), 0x42);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(prf.prf(in.data(), in.size()));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(Prf_eval, 32, HMacBlake2b)
+    ->RangeMultiplier(8)
+    ->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(Prf_eval, 32, KeyedBlake2b)
+    ->RangeMultiplier(8)
+    ->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(Prf_eval, 1024, HMacBlake2b)->Arg(16);
+BENCHMARK_TEMPLATE(Prf_eval, 1024, KeyedBlake2b)->Arg(16);
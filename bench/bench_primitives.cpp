@@ -0,0 +1,223 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <sse/crypto/cipher.hpp>
+#include <sse/crypto/hash.hpp>
+#include <sse/crypto/hmac.hpp>
+#include <sse/crypto/key.hpp>
+#include <sse/crypto/prf.hpp>
+#include <sse/crypto/prg.hpp>
+#include <sse/crypto/prp.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+using sse::crypto::Cipher;
+using sse::crypto::Hash;
+using sse::crypto::HMac;
+using sse::crypto::Key;
+using sse::crypto::Prf;
+using sse::crypto::Prg;
+using sse::crypto::Prp;
+
+// Keyed objects are not thread-safe: every benchmark function builds its own
+// instance, so that each thread of a ->ThreadRange() run gets a private one.
+
+constexpr int64_t kMinInput = 8;
+constexpr int64_t kMaxInput = 1 << 16;
+
+// Prf<NBYTES>::prf on state.range(0) bytes inputs
+template<uint16_t NBYTES>
+static void Prf_prf(benchmark::State& state)
+{
+    Prf<NBYTES>                prf;
+    std::vector<unsigned char> in(static_cast<size_t>(state.range(0)), 0x42);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(prf.prf(in.data(), in.size()));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(Prf_prf, 16)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(Prf_prf, 32)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(Prf_prf, 64)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(Prf_prf, 128)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(Prf_prf, 1024)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+
+// HMac<Hash, 32>::hmac with a 64 bytes output on state.range(0) bytes inputs
+static void HMac_hmac(benchmark::State& state)
+{
+    HMac<Hash, 32>             hmac;
+    std::vector<unsigned char> in(static_cast<size_t>(state.range(0)), 0x42);
+    std::array<uint8_t, Hash::kDigestSize> out;
+
+    for (auto _ : state) {
+        hmac.hmac(in.data(), in.size(), out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(HMac_hmac)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+
+// Prg::derive of state.range(0) bytes
+static void Prg_derive(benchmark::State& state)
+{
+    Prg         prg(Key<Prg::kKeySize>{});
+    std::string out;
+
+    for (auto _ : state) {
+        prg.derive(0, static_cast<size_t>(state.range(0)), out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(Prg_derive)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+
+// Prg::derive_key of a single 32 bytes key
+static void Prg_derive_key(benchmark::State& state)
+{
+    Prg prg(Key<Prg::kKeySize>{});
+
+    for (auto _ : state) {
+        Key<32> k = prg.derive_key<32>(0);
+        benchmark::DoNotOptimize(&k);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * 32);
+}
+
+BENCHMARK(Prg_derive_key)->ThreadRange(1, 8);
+
+// Prg::derive_keys of state.range(0) 32 bytes keys
+static void Prg_derive_keys(benchmark::State& state)
+{
+    Prg            prg(Key<Prg::kKeySize>{});
+    const uint16_t n_keys = static_cast<uint16_t>(state.range(0));
+
+    for (auto _ : state) {
+        std::vector<Key<32>> keys = prg.derive_keys<32>(n_keys, 0);
+        benchmark::DoNotOptimize(keys.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 32);
+}
+
+BENCHMARK(Prg_derive_keys)
+    ->RangeMultiplier(8)
+    ->Range(1, 512)
+    ->ThreadRange(1, 8);
+
+// Cipher::encrypt of state.range(0) bytes plaintexts
+static void Cipher_encrypt(benchmark::State& state)
+{
+    Cipher      cipher(Key<Cipher::kKeySize>{});
+    std::string in(static_cast<size_t>(state.range(0)), 'a');
+    std::string out;
+
+    for (auto _ : state) {
+        cipher.encrypt(in, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(Cipher_encrypt)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+
+// Cipher::decrypt of the ciphertext of a state.range(0) bytes plaintext
+static void Cipher_decrypt(benchmark::State& state)
+{
+    Cipher      cipher(Key<Cipher::kKeySize>{});
+    std::string in(static_cast<size_t>(state.range(0)), 'a');
+    std::string ct;
+    std::string out;
+
+    cipher.encrypt(in, ct);
+
+    for (auto _ : state) {
+        cipher.decrypt(ct, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(Cipher_decrypt)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
+
+// Prp::encrypt of state.range(0) bytes buffers
+static void Prp_encrypt(benchmark::State& state)
+{
+    if (!Prp::is_available()) {
+        state.SkipWithError("AES hardware acceleration is not available");
+        return;
+    }
+
+    Prp                  prp(Key<Prp::kKeySize>{});
+    std::vector<uint8_t> in(static_cast<size_t>(state.range(0)), 0x42);
+    std::vector<uint8_t> out(in.size());
+
+    for (auto _ : state) {
+        prp.encrypt(
+            in.data(), static_cast<unsigned int>(in.size()), out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(Prp_encrypt)
+    ->RangeMultiplier(8)
+    ->Range(kMinInput, kMaxInput)
+    ->ThreadRange(1, 8);
@@ -0,0 +1,53 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <sse/crypto/random.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using sse::crypto::RandomSource;
+
+// Requests of state.range(0) bytes, from all the benchmark's threads
+template<RandomSource Source>
+static void Random_bytes(benchmark::State& state)
+{
+    // all the threads select the same source
+    sse::crypto::set_random_source(Source);
+
+    std::vector<unsigned char> buffer(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        sse::crypto::random_bytes(buffer.size(), buffer.data());
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(Random_bytes, RandomSource::System)
+    ->RangeMultiplier(4)
+    ->Range(16, 4096)
+    ->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(Random_bytes, RandomSource::BufferedChaCha20)
+    ->RangeMultiplier(4)
+    ->Range(16, 4096)
+    ->ThreadRange(1, 8);
@@ -18,15 +18,22 @@
 // along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include "mbedtls/bignum.h"
+#include "mbedtls/rsa.h"
+#include "mbedtls/rsa_io.h"
 #include "tdp_impl/tdp_impl_mbedtls.hpp"
 #include "tdp_impl/tdp_impl_openssl.hpp"
 
 #include <benchmark/benchmark.h>
 
+#include <vector>
+
 using sse::crypto::TdpImpl_mbedTLS;
 using sse::crypto::TdpInverseImpl_mbedTLS;
 using sse::crypto::TdpMultPoolImpl_mbedTLS;
 
+using tdp_message_type = std::array<uint8_t, sse::crypto::Tdp::kMessageSize>;
+
 #ifdef WITH_OPENSSL
 using sse::crypto::TdpImpl_OpenSSL;
 using sse::crypto::TdpInverseImpl_OpenSSL;
@@ -118,6 +125,96 @@ public:
 
 #define EVAL_MULT_BENCH(LIB) EVAL_MULT_BENCH_AUX(LIB, LIB##_Impl)
 
+// Baseline for the mbedTLS pool evaluation: generic modular exponentiation
+// with the exponent 65537^order, as done by the pool implementation when it
+// stored one RSA context per order.
+BENCHMARK_TEMPLATE_DEFINE_F(Tdp_Benchmark,
+                            mbedTLS_eval_mult_generic,
+                            mbedTLS_Impl)
+(benchmark::State& st)
+{
+    const std::string pk = tdp_.public_key();
+
+    mbedtls_rsa_context key;
+    mbedtls_mpi         e, x;
+    mbedtls_rsa_init(&key, 0, 0);
+    mbedtls_mpi_init(&e);
+    mbedtls_mpi_init(&x);
+
+    if (mbedtls_rsa_parse_public_key(
+            &key,
+            reinterpret_cast<const unsigned char*>(pk.c_str()),
+            pk.length() + 1)
+        != 0) {
+        st.SkipWithError("Unable to parse the public key");
+        mbedtls_mpi_free(&e);
+        mbedtls_mpi_free(&x);
+        mbedtls_rsa_free(&key);
+        return;
+    }
+
+    mbedtls_mpi_lset(&e, 1);
+    for (int64_t i = 0; i < st.range(0); i++) {
+        mbedtls_mpi_mul_mpi(&e, &e, &key.E);
+    }
+
+    auto in = tdp_.sample_array();
+    mbedtls_mpi_read_binary(&x, in.data(), in.size());
+
+    for (auto _ : st) {
+        mbedtls_mpi_exp_mod(&x, &x, &e, &key.N, &key.RN);
+    }
+    st.SetItemsProcessed(int64_t(st.iterations()));
+
+    mbedtls_mpi_free(&e);
+    mbedtls_mpi_free(&x);
+    mbedtls_rsa_free(&key);
+}
+BENCHMARK_REGISTER_F(Tdp_Benchmark, mbedTLS_eval_mult_generic)
+    ->RangeMultiplier(2)
+    ->Range(1, MAX_POOL_SIZE);
+
+
+// Compare the evaluation of a chain of TDP evaluations using successive calls
+// to eval, and using eval_iterated
+#define EVAL_CHAIN_BENCH_AUX(NAME, IMPL)                                       \
+    BENCHMARK_TEMPLATE_DEFINE_F(Tdp_Benchmark, NAME##_eval_chain, IMPL)        \
+    (benchmark::State & st)                                                    \
+    {                                                                          \
+        auto in = tdp_.sample_array();                                         \
+        for (auto _ : st) {                                                    \
+            auto out = in;                                                     \
+            for (int64_t i = 0; i < st.range(0); i++) {                        \
+                out = tdp_.eval(out);                                          \
+            }                                                                  \
+            benchmark::DoNotOptimize(out);                                     \
+        }                                                                      \
+        st.SetItemsProcessed(int64_t(st.iterations()) * st.range(0));          \
+    }                                                                          \
+    BENCHMARK_REGISTER_F(Tdp_Benchmark, NAME##_eval_chain)                     \
+        ->RangeMultiplier(8)                                                   \
+        ->Range(1, 4096);                                                      \
+                                                                               \
+    BENCHMARK_TEMPLATE_DEFINE_F(Tdp_Benchmark, NAME##_eval_iterated, IMPL)     \
+    (benchmark::State & st)                                                    \
+    {                                                                          \
+        auto in = tdp_.sample_array();                                         \
+        for (auto _ : st) {                                                    \
+            auto out = tdp_.eval_iterated(                                     \
+                in,                                                            \
+                static_cast<uint32_t>(st.range(0)),                            \
+                [](uint32_t, const tdp_message_type& v) {                      \
+                    benchmark::DoNotOptimize(v);                               \
+                });                                                            \
+            benchmark::DoNotOptimize(out);                                     \
+        }                                                                      \
+        st.SetItemsProcessed(int64_t(st.iterations()) * st.range(0));          \
+    }                                                                          \
+    BENCHMARK_REGISTER_F(Tdp_Benchmark, NAME##_eval_iterated)                  \
+        ->RangeMultiplier(8)                                                   \
+        ->Range(1, 4096);
+
+#define EVAL_CHAIN_BENCH(LIB) EVAL_CHAIN_BENCH_AUX(LIB, LIB##_Impl)
 
 #define INVERT_BENCH_AUX(NAME, IMPL)                                           \
     BENCHMARK_TEMPLATE_DEFINE_F(Tdp_Benchmark, NAME##_invert, IMPL)            \
@@ -132,6 +229,70 @@ public:
 
 #define INVERT_BENCH(LIB) INVERT_BENCH_AUX(LIB, LIB##_Impl)
 
+// Inversion of a batch of messages: one call to invert per message, versus a
+// single call to invert_batch
+#define INVERT_BATCH_BENCH_AUX(NAME, IMPL)                                     \
+    BENCHMARK_TEMPLATE_DEFINE_F(Tdp_Benchmark, NAME##_invert_loop, IMPL)       \
+    (benchmark::State & st)                                                    \
+    {                                                                          \
+        std::vector<tdp_message_type> in(st.range(0)), out(st.range(0));      \
+        for (auto& m : in) {                                                   \
+            m = tdp_.sample_array();                                           \
+        }                                                                      \
+        for (auto _ : st) {                                                    \
+            for (size_t i = 0; i < in.size(); i++) {                           \
+                out[i] = tdp_inv_.invert(in[i]);                               \
+            }                                                                  \
+            benchmark::DoNotOptimize(out.data());                              \
+        }                                                                      \
+        st.SetItemsProcessed(int64_t(st.iterations()) * st.range(0));          \
+    }                                                                          \
+    BENCHMARK_REGISTER_F(Tdp_Benchmark, NAME##_invert_loop)                    \
+        ->RangeMultiplier(4)                                                   \
+        ->Range(1, 256);                                                       \
+                                                                               \
+    BENCHMARK_TEMPLATE_DEFINE_F(Tdp_Benchmark, NAME##_invert_batch, IMPL)      \
+    (benchmark::State & st)                                                    \
+    {                                                                          \
+        std::vector<tdp_message_type> in(st.range(0)), out(st.range(0));      \
+        for (auto& m : in) {                                                   \
+            m = tdp_.sample_array();                                           \
+        }                                                                      \
+        for (auto _ : st) {                                                    \
+            tdp_inv_.invert_batch(in.data(), out.data(), in.size());           \
+            benchmark::DoNotOptimize(out.data());                              \
+        }                                                                      \
+        st.SetItemsProcessed(int64_t(st.iterations()) * st.range(0));          \
+    }                                                                          \
+    BENCHMARK_REGISTER_F(Tdp_Benchmark, NAME##_invert_batch)                   \
+        ->RangeMultiplier(4)                                                   \
+        ->Range(1, 256);
+
+#define INVERT_BATCH_BENCH(LIB) INVERT_BATCH_BENCH_AUX(LIB, LIB##_Impl)
+
+// Multi-threaded invert_batch, for a batch of 1024 messages
+static void Tdp_invert_batch_threads(benchmark::State& state)
+{
+    static const sse::crypto::TdpInverse tdp_inv;
+
+    std::vector<tdp_message_type> in(1024);
+    for (auto& m : in) {
+        m = tdp_inv.sample_array();
+    }
+
+    for (auto _ : state) {
+        auto out = tdp_inv.invert_batch(
+            in, static_cast<unsigned int>(state.range(0)));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * in.size());
+}
+BENCHMARK(Tdp_invert_batch_threads)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
 #define INVERT_MULT_BENCH_AUX(NAME, IMPL)                                      \
     BENCHMARK_TEMPLATE_DEFINE_F(Tdp_Benchmark, NAME##_invert_mult, IMPL)       \
     (benchmark::State & st)                                                    \
@@ -147,6 +308,58 @@ public:
 
 #define INVERT_MULT_BENCH(LIB) INVERT_MULT_BENCH_AUX(LIB, LIB##_Impl)
 
+// Concurrent use of a single TDP by several threads.
+// The fixture above cannot be used here: its members are shared by all the
+// threads running the benchmark.
+template<typename IMPL>
+struct Tdp_Concurrent_Keys
+{
+    Tdp_Concurrent_Keys() : tdp_inv_(), tdp_(tdp_inv_.public_key())
+    {
+    }
+
+    static const Tdp_Concurrent_Keys& instance()
+    {
+        static Tdp_Concurrent_Keys keys;
+        return keys;
+    }
+
+    typename IMPL::TdpInverseImpl tdp_inv_;
+    typename IMPL::TdpImpl        tdp_;
+};
+
+template<typename IMPL>
+void Tdp_concurrent_eval(benchmark::State& state)
+{
+    const auto& keys    = Tdp_Concurrent_Keys<IMPL>::instance();
+    auto        message = keys.tdp_.sample_array();
+
+    for (auto _ : state) {
+        message = keys.tdp_.eval(message);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+template<typename IMPL>
+void Tdp_concurrent_invert(benchmark::State& state)
+{
+    const auto& keys    = Tdp_Concurrent_Keys<IMPL>::instance();
+    auto        message = keys.tdp_.sample_array();
+
+    for (auto _ : state) {
+        message = keys.tdp_inv_.invert(message);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+#define CONCURRENT_BENCH(LIB)                                                  \
+    BENCHMARK_TEMPLATE(Tdp_concurrent_eval, LIB##_Impl)                        \
+        ->ThreadRange(1, 8)                                                    \
+        ->UseRealTime();                                                       \
+    BENCHMARK_TEMPLATE(Tdp_concurrent_invert, LIB##_Impl)                      \
+        ->ThreadRange(1, 8)                                                    \
+        ->UseRealTime()
+
 EVAL_BENCH(mbedTLS);
 #ifdef WITH_OPENSSL
 EVAL_BENCH(OpenSSL);
@@ -157,12 +370,27 @@ EVAL_MULT_BENCH(mbedTLS);
 EVAL_MULT_BENCH(OpenSSL);
 #endif
 
+EVAL_CHAIN_BENCH(mbedTLS);
+#ifdef WITH_OPENSSL
+EVAL_CHAIN_BENCH(OpenSSL);
+#endif
+
 INVERT_BENCH(mbedTLS);
 #ifdef WITH_OPENSSL
 INVERT_BENCH(OpenSSL);
 #endif
 
+INVERT_BATCH_BENCH(mbedTLS);
+#ifdef WITH_OPENSSL
+INVERT_BATCH_BENCH(OpenSSL);
+#endif
+
 INVERT_MULT_BENCH(mbedTLS);
 #ifdef WITH_OPENSSL
 INVERT_MULT_BENCH(OpenSSL);
 #endif
+
+CONCURRENT_BENCH(mbedTLS);
+#ifdef WITH_OPENSSL
+CONCURRENT_BENCH(OpenSSL);
+#endif
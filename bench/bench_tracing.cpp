@@ -0,0 +1,96 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <sse/crypto/rcprf.hpp>
+#include <sse/crypto/utils.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <string>
+
+using sse::crypto::Key;
+using sse::crypto::RCPrf;
+using sse::crypto::RCPrfParams;
+
+// Tracing overhead: every benchmark runs with tracing disabled
+// (state.range(0) == 0), or enabled with a sampling period of
+// state.range(0). Comparing the runs gives the overhead of the tracing.
+
+static void set_tracing(benchmark::State& state)
+{
+    sse::crypto::clear_trace();
+    if (state.range(0) == 0) {
+        sse::crypto::disable_tracing();
+        state.SetLabel("disabled");
+    } else {
+        sse::crypto::enable_tracing(static_cast<uint32_t>(state.range(0)));
+        state.SetLabel("sampling period "
+                       + std::to_string(state.range(0)));
+    }
+}
+
+static void reset_tracing()
+{
+    sse::crypto::disable_tracing();
+    sse::crypto::clear_trace();
+}
+
+// Cost of an empty span
+static void Tracing_span(benchmark::State& state)
+{
+    set_tracing(state);
+    for (auto _ : state) {
+        sse::crypto::TraceSpan span("Tracing_span");
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    reset_tracing();
+}
+
+BENCHMARK(Tracing_span)->Arg(0)->Arg(1)->Arg(100);
+
+// RCPrf::eval_range on state.range(1) leaves: a traced operation, with
+// nested spans around the key locking and unlocking
+static void Tracing_RCPrf_eval_range(benchmark::State& state)
+{
+    constexpr uint8_t kDepth = 48;
+    const uint64_t    range  = static_cast<uint64_t>(state.range(1));
+
+    RCPrf<32> rcprf(Key<RCPrfParams::kKeySize>(), kDepth);
+    auto      callback = [](size_t, std::array<uint8_t, 32>) {};
+
+    set_tracing(state);
+    uint64_t start = 0;
+    for (auto _ : state) {
+        rcprf.eval_range(start, start + range - 1, callback);
+        start += range;
+    }
+    state.SetItemsProcessed(state.iterations());
+    reset_tracing();
+}
+
+BENCHMARK(Tracing_RCPrf_eval_range)
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({100, 1})
+    ->Args({0, 64})
+    ->Args({1, 64})
+    ->Args({100, 64});
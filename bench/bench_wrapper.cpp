@@ -0,0 +1,182 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <sse/crypto/key_store.hpp>
+#include <sse/crypto/prf.hpp>
+#include <sse/crypto/wrapper.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+using sse::crypto::Key;
+using sse::crypto::Prf;
+using sse::crypto::WrappedKeyStore;
+using sse::crypto::WrappedKeyStoreBuilder;
+using sse::crypto::Wrapper;
+
+using WrappedPrf = Prf<32>;
+
+static void Wrapper_wrap(benchmark::State& state)
+{
+    Wrapper    wrapper((Key<Wrapper::kKeySize>()));
+    WrappedPrf prf;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wrapper.wrap(prf));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void Wrapper_wrap_into(benchmark::State& state)
+{
+    Wrapper    wrapper((Key<Wrapper::kKeySize>()));
+    WrappedPrf prf;
+
+    std::vector<uint8_t> buffer(Wrapper::wrapped_size(prf));
+
+    for (auto _ : state) {
+        wrapper.wrap_into(prf, buffer.data(), buffer.size());
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void Wrapper_unwrap(benchmark::State& state)
+{
+    Wrapper    wrapper((Key<Wrapper::kKeySize>()));
+    WrappedPrf prf;
+
+    const std::vector<uint8_t> rep = wrapper.wrap(prf);
+
+    for (auto _ : state) {
+        // unwrap wipes its input
+        std::vector<uint8_t> buffer = rep;
+        benchmark::DoNotOptimize(wrapper.unwrap<WrappedPrf>(buffer));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void Wrapper_unwrap_from(benchmark::State& state)
+{
+    Wrapper    wrapper((Key<Wrapper::kKeySize>()));
+    WrappedPrf prf;
+
+    const std::vector<uint8_t> rep = wrapper.wrap(prf);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            wrapper.unwrap_from<WrappedPrf>(rep.data(), rep.size()));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Batches of state.range(0) keys
+static void Wrapper_wrap_many(benchmark::State& state)
+{
+    Wrapper                 wrapper((Key<Wrapper::kKeySize>()));
+    std::vector<WrappedPrf> prfs(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wrapper.wrap_many(prfs));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void Wrapper_unwrap_many(benchmark::State& state)
+{
+    Wrapper                 wrapper((Key<Wrapper::kKeySize>()));
+    std::vector<WrappedPrf> prfs(static_cast<size_t>(state.range(0)));
+
+    const std::vector<std::vector<uint8_t>> reps = wrapper.wrap_many(prfs);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wrapper.unwrap_many<WrappedPrf>(reps));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static const char* kKeyStorePath = "bench_key_store.bin";
+
+static void write_key_store(const Wrapper& wrapper, size_t count)
+{
+    WrappedKeyStoreBuilder builder(wrapper);
+    for (size_t i = 0; i < count; i++) {
+        builder.add(WrappedPrf());
+    }
+    builder.write(kKeyStorePath);
+}
+
+// Opening a store of state.range(0) keys: only the index is read
+static void KeyStore_open(benchmark::State& state)
+{
+    Wrapper wrapper((Key<Wrapper::kKeySize>()));
+    write_key_store(wrapper, static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        WrappedKeyStore store(kKeyStorePath, wrapper);
+        benchmark::DoNotOptimize(store.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+
+    std::remove(kKeyStorePath);
+}
+
+// Access to a key that is not in the cache (state.range(0) == 0) or that is
+// cached (state.range(0) == 1)
+static void KeyStore_get(benchmark::State& state)
+{
+    constexpr size_t kCount = 1024;
+
+    Wrapper wrapper((Key<Wrapper::kKeySize>()));
+    write_key_store(wrapper, kCount);
+
+    WrappedKeyStore store(kKeyStorePath, wrapper, state.range(0) ? kCount : 0);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store.get<WrappedPrf>(i));
+        i = (i + 1) % kCount;
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    std::remove(kKeyStorePath);
+}
+
+BENCHMARK(Wrapper_wrap);
+BENCHMARK(Wrapper_wrap_into);
+BENCHMARK(Wrapper_unwrap);
+BENCHMARK(Wrapper_unwrap_from);
+BENCHMARK(Wrapper_wrap_many)
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 12);
+BENCHMARK(Wrapper_unwrap_many)
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 12);
+BENCHMARK(KeyStore_open)
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(16)
+    ->Range(1, 1 << 12);
+BENCHMARK(KeyStore_get)->Arg(0)->Arg(1);
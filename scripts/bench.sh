@@ -0,0 +1,115 @@
+#! /bin/bash
+set -e
+
+# Run all the benchmark_* executables of a build directory, store their
+# results as JSON and, if a baseline is available, compare the results
+# against it. The script fails if a benchmark regressed by more than
+# BENCH_THRESHOLD percent.
+#
+# Usage: scripts/bench.sh [build_dir]
+#
+# Environment variables:
+#   BENCH_OUT_DIR           Where to write the JSON results
+#                           (default: <build_dir>/bench_results)
+#   BENCH_BASELINE_DIR      Directory of the baseline JSON files. No
+#                           comparison is made if it is empty. The script
+#                           fails if it is set to a missing directory.
+#   BENCH_THRESHOLD         Maximum tolerated slowdown, in percent
+#                           (default: 10)
+#   BENCH_METRIC            Compared time: cpu_time or real_time
+#                           (default: cpu_time)
+#   BENCH_REPETITIONS       Number of repetitions of every benchmark, whose
+#                           median is compared (default: 5)
+#   BENCH_MIN_TIME          Minimum run time of each repetition, in seconds
+#                           (default: 0.1)
+#   BENCH_CPUS              CPU list the benchmarks are pinned to, in
+#                           taskset(1) format, e.g. 2-5. Empty to disable
+#                           pinning. (default: empty)
+#                           Some benchmarks run on several threads: the
+#                           list must have at least as many CPUs as their
+#                           largest thread count, otherwise the threads
+#                           share CPUs and the results are meaningless.
+#                           Pinning is thus off by default, and should only
+#                           be used with a range of isolated CPUs.
+#   BENCH_FILTER            Regular expression selecting the benchmarks
+#                           (default: all)
+#   BENCH_UPDATE_BASELINE   When set to 1, copy the results to the
+#                           baseline directory instead of comparing them.
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+
+BUILD_DIR="${1:-build}"
+
+: "${BENCH_OUT_DIR:=$BUILD_DIR/bench_results}"
+: "${BENCH_BASELINE_DIR:=}"
+: "${BENCH_THRESHOLD:=10}"
+: "${BENCH_METRIC:=cpu_time}"
+: "${BENCH_REPETITIONS:=5}"
+: "${BENCH_MIN_TIME:=0.1}"
+: "${BENCH_CPUS:=}"
+: "${BENCH_FILTER:=.}"
+: "${BENCH_UPDATE_BASELINE:=0}"
+
+shopt -s nullglob
+
+BENCHMARKS=("$BUILD_DIR"/bench/benchmark_*)
+
+if [ ${#BENCHMARKS[@]} -eq 0 ]; then
+    echo "No benchmark executable found in $BUILD_DIR/bench."
+    echo "Build them first with the 'bench' target."
+    exit 1
+fi
+
+PIN_COMMAND=()
+if [ -n "$BENCH_CPUS" ]; then
+    if command -v taskset > /dev/null; then
+        PIN_COMMAND=(taskset -c "$BENCH_CPUS")
+    else
+        echo "taskset not found: the benchmarks will not be pinned."
+    fi
+fi
+
+mkdir -p "$BENCH_OUT_DIR"
+
+for bench in "${BENCHMARKS[@]}"; do
+    if [ ! -x "$bench" ]; then
+        continue
+    fi
+    name=$(basename "$bench")
+
+    echo "Running $name"
+    "${PIN_COMMAND[@]}" "$bench" \
+        --benchmark_filter="$BENCH_FILTER" \
+        --benchmark_repetitions="$BENCH_REPETITIONS" \
+        --benchmark_report_aggregates_only=true \
+        --benchmark_min_time="$BENCH_MIN_TIME" \
+        --benchmark_out="$BENCH_OUT_DIR/$name.json" \
+        --benchmark_out_format=json
+done
+
+if [ "$BENCH_UPDATE_BASELINE" = "1" ]; then
+    if [ -z "$BENCH_BASELINE_DIR" ]; then
+        echo "BENCH_BASELINE_DIR must be set to update the baseline."
+        exit 1
+    fi
+    mkdir -p "$BENCH_BASELINE_DIR"
+    cp "$BENCH_OUT_DIR"/*.json "$BENCH_BASELINE_DIR"
+    echo "Baseline updated in $BENCH_BASELINE_DIR"
+    exit 0
+fi
+
+if [ -z "$BENCH_BASELINE_DIR" ]; then
+    echo "No baseline directory: the results are not compared."
+    exit 0
+fi
+
+if [ ! -d "$BENCH_BASELINE_DIR" ]; then
+    echo "The baseline directory $BENCH_BASELINE_DIR does not exist."
+    exit 1
+fi
+
+python3 "$SCRIPT_DIR/bench_compare.py" \
+    --threshold "$BENCH_THRESHOLD" \
+    --metric "$BENCH_METRIC" \
+    --filter "$BENCH_FILTER" \
+    "$BENCH_BASELINE_DIR" "$BENCH_OUT_DIR"
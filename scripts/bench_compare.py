@@ -0,0 +1,168 @@
+#! /usr/bin/env python3
+"""Compare Google Benchmark JSON results against a baseline.
+
+Both arguments are either JSON files written with --benchmark_out, or
+directories of such files (files are then matched by name). When repeated
+runs are available, the medians are compared. The script exits with a
+non-zero status if one of the benchmarks is slower than its baseline by
+more than the given threshold (in percent), if one of them failed, or if
+one of the baseline benchmarks (or result files) has no result.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_results(path, metric):
+    """Return a dictionary mapping benchmark names to times in ns, and a
+    dictionary mapping the names of the failed benchmarks to their error
+    messages."""
+    with open(path) as f:
+        report = json.load(f)
+
+    iterations = {}
+    medians = {}
+    errors = {}
+    for bench in report.get("benchmarks", []):
+        name = bench.get("run_name", bench["name"])
+        if bench.get("error_occurred", False):
+            errors[name] = bench.get("error_message", "unknown error")
+            continue
+        time = bench[metric] * TIME_UNITS[bench.get("time_unit", "ns")]
+
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[name] = time
+        else:
+            # without repetitions, there is a single run per benchmark
+            iterations.setdefault(name, time)
+
+    iterations.update(medians)
+    for name in errors:
+        iterations.pop(name, None)
+    return iterations, errors
+
+
+def result_files(baseline, current):
+    """List the (name, baseline file, current file) triples to compare, and
+    the names of the baseline files without a current file."""
+    if os.path.isfile(baseline) and os.path.isfile(current):
+        return [(os.path.basename(current), baseline, current)], []
+
+    if not (os.path.isdir(baseline) and os.path.isdir(current)):
+        raise ValueError(
+            "the baseline and the results must both be files or "
+            "both be directories"
+        )
+
+    files = []
+    for name in sorted(os.listdir(current)):
+        if not name.endswith(".json"):
+            continue
+        base_file = os.path.join(baseline, name)
+        if not os.path.isfile(base_file):
+            print("{}: no baseline, skipped".format(name))
+            continue
+        files.append((name, base_file, os.path.join(current, name)))
+
+    missing = [
+        name
+        for name in sorted(os.listdir(baseline))
+        if name.endswith(".json")
+        and not os.path.isfile(os.path.join(current, name))
+    ]
+    return files, missing
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("baseline", help="baseline JSON file or directory")
+    parser.add_argument("current", help="new JSON file or directory")
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=10.0,
+        help="maximum tolerated slowdown, in percent (default: 10)",
+    )
+    parser.add_argument(
+        "--metric",
+        choices=["cpu_time", "real_time"],
+        default="cpu_time",
+        help="compared time (default: cpu_time)",
+    )
+    parser.add_argument(
+        "--filter",
+        default=".",
+        help="regular expression selecting the baseline benchmarks that "
+        "must have a result (default: all)",
+    )
+    args = parser.parse_args()
+
+    try:
+        files, missing_files = result_files(args.baseline, args.current)
+        selected = re.compile(args.filter)
+    except (ValueError, re.error) as e:
+        print("error: {}".format(e), file=sys.stderr)
+        return 2
+
+    regressions = []
+    failures = []
+    for file_name in missing_files:
+        print("{}: no result".format(file_name))
+        failures.append((file_name, "*", "no result file"))
+
+    for file_name, base_file, cur_file in files:
+        base, _ = load_results(base_file, args.metric)
+        cur, errors = load_results(cur_file, args.metric)
+
+        print("{}:".format(file_name))
+        for name, message in errors.items():
+            print("  {:<60} ERROR: {}".format(name, message))
+            failures.append((file_name, name, "error: " + message))
+        for name, time in cur.items():
+            if name not in base:
+                print("  {:<60} new".format(name))
+                continue
+            delta = 100.0 * (time - base[name]) / base[name]
+            status = ""
+            if delta > args.threshold:
+                status = "REGRESSION"
+                regressions.append((file_name, name, delta))
+            line = "  {:<60} {:>12.1f} ns {:>+8.1f}% {}".format(
+                name, time, delta, status
+            )
+            print(line.rstrip())
+        for name in base:
+            if name in cur or name in errors or not selected.search(name):
+                continue
+            print("  {:<60} MISSING".format(name))
+            failures.append((file_name, name, "no result"))
+
+    if failures:
+        print("\n{} benchmark(s) failed or missing:".format(len(failures)))
+        for file_name, name, reason in failures:
+            print("  {} {} ({})".format(file_name, name, reason))
+
+    if regressions:
+        print(
+            "\n{} benchmark(s) regressed by more than {}%:".format(
+                len(regressions), args.threshold
+            )
+        )
+        for file_name, name, delta in regressions:
+            print("  {} {} ({:+.1f}%)".format(file_name, name, delta))
+
+    if failures or regressions:
+        return 1
+
+    print("\nNo regression above {}%.".format(args.threshold))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -27,6 +27,9 @@
 
 #include <array>
 #include <stdexcept>
+#include <type_traits>
+
+#include <sodium/utils.h>
 
 namespace sse {
 
@@ -34,6 +37,9 @@ namespace crypto {
 
 using hash_function = hash::blake2b;
 
+static_assert(std::is_same<Hash::state_type, hash_function::state_type>::value,
+              "Declared state type and hash_function state type do not match");
+
 void Hash::hash(const unsigned char* in, const size_t len, unsigned char* out)
 {
     if (in == nullptr) {
@@ -118,5 +124,87 @@ std::string Hash::hash(const std::string& in, const size_t out_len)
     return out;
 }
 
+void Hash::init(state_type& state)
+{
+    hash_function::init(state);
+}
+
+void Hash::update(state_type& state, const unsigned char* in, const size_t len)
+{
+    hash_function::update(state, in, len);
+}
+
+void Hash::final(state_type& state, unsigned char* out)
+{
+    hash_function::final(state, out);
+}
+
+Hash::State::State()
+{
+    init(state_);
+}
+
+Hash::State::~State()
+{
+    sodium_memzero(&state_, sizeof(state_));
+}
+
+void Hash::State::update(const unsigned char* in, const size_t len)
+{
+    if (finalized_) {
+        throw std::runtime_error("Hash::State: the state was finalized");
+    }
+    if (in == nullptr && len != 0) {
+        throw std::invalid_argument("in is NULL");
+    }
+
+    if (len != 0) {
+        Hash::update(state_, in, len);
+    }
+}
+
+void Hash::State::update(const std::string& in)
+{
+    update(reinterpret_cast<const unsigned char*>(in.data()), in.length());
+}
+
+void Hash::State::final(unsigned char* out, const size_t out_len)
+{
+    if (finalized_) {
+        throw std::runtime_error("Hash::State: the state was finalized");
+    }
+    if (out_len > kDigestSize) {
+        throw std::invalid_argument(
+            "Invalid output length: out_len > kDigestSize");
+    }
+    if (out == nullptr) {
+        throw std::invalid_argument("out is NULL");
+    }
+
+    finalized_ = true;
+    if (out_len == kDigestSize) {
+        Hash::final(state_, out);
+    } else {
+        std::array<unsigned char, kDigestSize> digest;
+        Hash::final(state_, digest.data());
+        memcpy(out, digest.data(), out_len);
+        sodium_memzero(digest.data(), digest.size());
+    }
+}
+
+std::string Hash::State::final()
+{
+    std::array<unsigned char, kDigestSize> digest;
+    final(digest.data());
+
+    return std::string(reinterpret_cast<char*>(digest.data()), kDigestSize);
+}
+
+void Hash::State::reset()
+{
+    init(state_);
+    finalized_ = false;
+}
+
 } // namespace crypto
 } // namespace sse
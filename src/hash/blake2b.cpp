@@ -38,6 +38,23 @@ void blake2b::hash(const unsigned char* in,
     crypto_generichash_blake2b(digest, kDigestSize, in, len, nullptr, 0);
 }
 
+void blake2b::init(state_type& state)
+{
+    crypto_generichash_blake2b_init(&state, nullptr, 0, kDigestSize);
+}
+
+void blake2b::update(state_type&          state,
+                     const unsigned char* in,
+                     const size_t         len)
+{
+    crypto_generichash_blake2b_update(&state, in, len);
+}
+
+void blake2b::final(state_type& state, unsigned char* digest)
+{
+    crypto_generichash_blake2b_final(&state, digest, kDigestSize);
+}
+
 } // namespace hash
 } // namespace crypto
 } // namespace sse
@@ -21,6 +21,8 @@
 
 #include <cstddef>
 
+#include <sodium/crypto_generichash_blake2b.h>
+
 namespace sse {
 
 namespace crypto {
@@ -35,6 +37,17 @@ struct blake2b
     static void hash(const unsigned char* in,
                      const size_t         len,
                      unsigned char*       digest);
+
+    /// Incremental hashing: a state is initialized by init, absorbs the
+    /// input through one or several calls to update, and produces the
+    /// digest with final. States can be copied.
+    using state_type = crypto_generichash_blake2b_state;
+
+    static void init(state_type& state);
+    static void update(state_type&          state,
+                       const unsigned char* in,
+                       const size_t         len);
+    static void final(state_type& state, unsigned char* digest);
 };
 
 } // namespace hash
@@ -38,6 +38,23 @@ void sha512::hash(const unsigned char* in,
     crypto_hash_sha512(digest, in, len);
 }
 
+void sha512::init(state_type& state)
+{
+    crypto_hash_sha512_init(&state);
+}
+
+void sha512::update(state_type&          state,
+                    const unsigned char* in,
+                    const size_t         len)
+{
+    crypto_hash_sha512_update(&state, in, len);
+}
+
+void sha512::final(state_type& state, unsigned char* digest)
+{
+    crypto_hash_sha512_final(&state, digest);
+}
+
 } // namespace hash
 } // namespace crypto
 } // namespace sse
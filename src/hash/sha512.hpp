@@ -20,6 +20,9 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+
+#include <sodium/crypto_hash_sha512.h>
 
 namespace sse {
 
@@ -35,6 +38,61 @@ struct sha512
     static void hash(const unsigned char* in,
                      const size_t         len,
                      unsigned char*       digest);
+
+    /// Incremental hashing: a state is initialized by init, absorbs the
+    /// input through one or several calls to update, and produces the
+    /// digest with final. States can be copied.
+    using state_type = crypto_hash_sha512_state;
+
+    static void init(state_type& state);
+    static void update(state_type&          state,
+                       const unsigned char* in,
+                       const size_t         len);
+    static void final(state_type& state, unsigned char* digest);
+
+    /// Multi-buffer hashing: four messages of the same length are hashed in
+    /// parallel, using a 4-lane AVX2 implementation when the CPU supports it.
+    static constexpr size_t kLanes = 4;
+
+    /// Implementations of the multi-buffer compression function
+    enum class x4_implementation
+    {
+        portable,
+        avx2,
+    };
+
+    struct state_x4_type
+    {
+        uint64_t      h[8][kLanes]; // chaining values, lanes interleaved
+        unsigned char buffer[kLanes][kBlockSize];
+        size_t        buffer_len;
+        uint64_t      total_len;
+    };
+
+    static void init_x4(state_x4_type& state);
+    static void update_x4(state_x4_type&             state,
+                          const unsigned char* const in[kLanes],
+                          const size_t               len);
+    static void final_x4(state_x4_type&       state,
+                         unsigned char* const digest[kLanes]);
+
+    static void hash_x4(const unsigned char* const in[kLanes],
+                        const size_t               len,
+                        unsigned char* const       digest[kLanes]);
+
+    /// Select the fastest multi-buffer implementation supported by the CPU.
+    /// Called by init_crypto_lib. Until then, the portable implementation is
+    /// used.
+    static void compute_x4_implementation() noexcept;
+
+    static bool is_supported(x4_implementation impl) noexcept;
+
+    /// Force the multi-buffer implementation (for tests and benchmarks).
+    /// Returns false, and leaves the implementation unchanged, if impl is not
+    /// supported by the CPU.
+    static bool set_x4_implementation(x4_implementation impl) noexcept;
+
+    static x4_implementation get_x4_implementation() noexcept;
 };
 
 } // namespace hash
@@ -0,0 +1,414 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "sha512.hpp"
+
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+
+#include <sodium/runtime.h>
+#include <sodium/utils.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SSE_CRYPTO_SHA512_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace sse {
+
+namespace crypto {
+
+namespace hash {
+
+namespace {
+
+constexpr uint64_t kRoundConstants[80]
+    = {0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+       0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+       0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+       0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+       0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+       0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+       0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+       0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+       0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+       0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+       0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+       0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+       0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+       0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+       0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+       0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+       0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+       0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+       0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+       0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+       0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+       0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+       0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+       0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+       0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+       0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+       0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+constexpr uint64_t kInitialState[8]
+    = {0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+       0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+       0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL};
+
+inline uint64_t load_be64(const unsigned char* in)
+{
+    uint64_t x;
+    memcpy(&x, in, sizeof(x));
+    return __builtin_bswap64(x);
+}
+
+inline void store_be64(unsigned char* out, uint64_t x)
+{
+    x = __builtin_bswap64(x);
+    memcpy(out, &x, sizeof(x));
+}
+
+inline uint64_t rotr(uint64_t x, int n)
+{
+    return (x >> n) | (x << (64 - n));
+}
+
+// Compress n_blocks blocks in each lane, one lane after the other
+void compress_x4_portable(uint64_t                   h[8][sha512::kLanes],
+                          const unsigned char* const blocks[sha512::kLanes],
+                          size_t                     n_blocks)
+{
+    uint64_t w[80];
+
+    for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+        const unsigned char* block = blocks[lane];
+
+        for (size_t b = 0; b < n_blocks; b++, block += sha512::kBlockSize) {
+            for (size_t t = 0; t < 16; t++) {
+                w[t] = load_be64(block + 8 * t);
+            }
+            for (size_t t = 16; t < 80; t++) {
+                const uint64_t s0 = rotr(w[t - 15], 1) ^ rotr(w[t - 15], 8)
+                                    ^ (w[t - 15] >> 7);
+                const uint64_t s1 = rotr(w[t - 2], 19) ^ rotr(w[t - 2], 61)
+                                    ^ (w[t - 2] >> 6);
+                w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+            }
+
+            uint64_t v[8];
+            for (size_t i = 0; i < 8; i++) {
+                v[i] = h[i][lane];
+            }
+            for (size_t t = 0; t < 80; t++) {
+                const uint64_t s1 = rotr(v[4], 14) ^ rotr(v[4], 18)
+                                    ^ rotr(v[4], 41);
+                const uint64_t ch  = (v[4] & v[5]) ^ (~v[4] & v[6]);
+                const uint64_t t1  = v[7] + s1 + ch + kRoundConstants[t] + w[t];
+                const uint64_t s0  = rotr(v[0], 28) ^ rotr(v[0], 34)
+                                    ^ rotr(v[0], 39);
+                const uint64_t maj = (v[0] & v[1]) ^ (v[0] & v[2])
+                                     ^ (v[1] & v[2]);
+
+                v[7] = v[6];
+                v[6] = v[5];
+                v[5] = v[4];
+                v[4] = v[3] + t1;
+                v[3] = v[2];
+                v[2] = v[1];
+                v[1] = v[0];
+                v[0] = t1 + s0 + maj;
+            }
+            for (size_t i = 0; i < 8; i++) {
+                h[i][lane] += v[i];
+            }
+        }
+    }
+    sodium_memzero(w, sizeof(w));
+}
+
+#ifdef SSE_CRYPTO_SHA512_AVX2
+
+#define SSE_CRYPTO_TARGET_AVX2 __attribute__((target("avx2")))
+
+template<int N>
+SSE_CRYPTO_TARGET_AVX2 inline __m256i rotr_avx2(__m256i x)
+{
+    return _mm256_or_si256(_mm256_srli_epi64(x, N),
+                           _mm256_slli_epi64(x, 64 - N));
+}
+
+// Load the big endian word at offset in each lane
+SSE_CRYPTO_TARGET_AVX2 inline __m256i load_word_avx2(
+    const unsigned char* const blocks[sha512::kLanes],
+    size_t                     offset)
+{
+    int64_t words[sha512::kLanes];
+    for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+        words[lane] = static_cast<int64_t>(load_be64(blocks[lane] + offset));
+    }
+    return _mm256_set_epi64x(words[3], words[2], words[1], words[0]);
+}
+
+// Compress n_blocks blocks in the four lanes at once: each 256 bits register
+// holds the same word of the four lanes
+SSE_CRYPTO_TARGET_AVX2 void compress_x4_avx2(
+    uint64_t                   h[8][sha512::kLanes],
+    const unsigned char* const blocks[sha512::kLanes],
+    size_t                     n_blocks)
+{
+    __m256i w[80];
+
+    const unsigned char* lane_blocks[sha512::kLanes]
+        = {blocks[0], blocks[1], blocks[2], blocks[3]};
+
+    for (size_t b = 0; b < n_blocks; b++) {
+        for (size_t t = 0; t < 16; t++) {
+            w[t] = load_word_avx2(lane_blocks, 8 * t);
+        }
+        for (size_t t = 16; t < 80; t++) {
+            const __m256i w15 = w[t - 15];
+            const __m256i w2  = w[t - 2];
+            const __m256i s0  = _mm256_xor_si256(
+                _mm256_xor_si256(rotr_avx2<1>(w15), rotr_avx2<8>(w15)),
+                _mm256_srli_epi64(w15, 7));
+            const __m256i s1 = _mm256_xor_si256(
+                _mm256_xor_si256(rotr_avx2<19>(w2), rotr_avx2<61>(w2)),
+                _mm256_srli_epi64(w2, 6));
+            w[t] = _mm256_add_epi64(_mm256_add_epi64(w[t - 16], s0),
+                                    _mm256_add_epi64(w[t - 7], s1));
+        }
+
+        __m256i v[8];
+        for (size_t i = 0; i < 8; i++) {
+            v[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h[i]));
+        }
+        for (size_t t = 0; t < 80; t++) {
+            const __m256i s1 = _mm256_xor_si256(
+                _mm256_xor_si256(rotr_avx2<14>(v[4]), rotr_avx2<18>(v[4])),
+                rotr_avx2<41>(v[4]));
+            const __m256i ch
+                = _mm256_xor_si256(_mm256_and_si256(v[4], v[5]),
+                                   _mm256_andnot_si256(v[4], v[6]));
+            const __m256i k = _mm256_set1_epi64x(
+                static_cast<int64_t>(kRoundConstants[t]));
+            const __m256i t1 = _mm256_add_epi64(
+                _mm256_add_epi64(_mm256_add_epi64(v[7], s1), ch),
+                _mm256_add_epi64(k, w[t]));
+            const __m256i s0 = _mm256_xor_si256(
+                _mm256_xor_si256(rotr_avx2<28>(v[0]), rotr_avx2<34>(v[0])),
+                rotr_avx2<39>(v[0]));
+            // maj(a, b, c) = ((a ^ b) & c) ^ (a & b)
+            const __m256i maj = _mm256_xor_si256(
+                _mm256_and_si256(_mm256_xor_si256(v[0], v[1]), v[2]),
+                _mm256_and_si256(v[0], v[1]));
+
+            v[7] = v[6];
+            v[6] = v[5];
+            v[5] = v[4];
+            v[4] = _mm256_add_epi64(v[3], t1);
+            v[3] = v[2];
+            v[2] = v[1];
+            v[1] = v[0];
+            v[0] = _mm256_add_epi64(t1, _mm256_add_epi64(s0, maj));
+        }
+        for (size_t i = 0; i < 8; i++) {
+            __m256i* hi = reinterpret_cast<__m256i*>(h[i]);
+            _mm256_storeu_si256(
+                hi, _mm256_add_epi64(_mm256_loadu_si256(hi), v[i]));
+        }
+
+        for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+            lane_blocks[lane] += sha512::kBlockSize;
+        }
+    }
+
+    // wipe the message schedule
+    const __m256i zero = _mm256_setzero_si256();
+    for (size_t t = 0; t < 80; t++) {
+        _mm256_storeu_si256(&w[t], zero);
+    }
+    _mm256_zeroupper();
+}
+
+#endif /* SSE_CRYPTO_SHA512_AVX2 */
+
+std::atomic<sha512::x4_implementation> g_x4_implementation(
+    sha512::x4_implementation::portable);
+
+void compress_x4(uint64_t                   h[8][sha512::kLanes],
+                 const unsigned char* const blocks[sha512::kLanes],
+                 size_t                     n_blocks)
+{
+#ifdef SSE_CRYPTO_SHA512_AVX2
+    if (g_x4_implementation.load(std::memory_order_relaxed)
+        == sha512::x4_implementation::avx2) {
+        compress_x4_avx2(h, blocks, n_blocks);
+        return;
+    }
+#endif
+    compress_x4_portable(h, blocks, n_blocks);
+}
+
+} // namespace
+
+void sha512::init_x4(state_x4_type& state)
+{
+    for (size_t i = 0; i < 8; i++) {
+        for (size_t lane = 0; lane < kLanes; lane++) {
+            state.h[i][lane] = kInitialState[i];
+        }
+    }
+    state.buffer_len = 0;
+    state.total_len  = 0;
+}
+
+void sha512::update_x4(state_x4_type&             state,
+                       const unsigned char* const in[kLanes],
+                       const size_t               len)
+{
+    const unsigned char* lane_in[kLanes] = {in[0], in[1], in[2], in[3]};
+    size_t               remaining       = len;
+
+    state.total_len += len;
+
+    if (state.buffer_len > 0) {
+        const size_t n = std::min(remaining, kBlockSize - state.buffer_len);
+        for (size_t lane = 0; lane < kLanes; lane++) {
+            memcpy(state.buffer[lane] + state.buffer_len, lane_in[lane], n);
+            lane_in[lane] += n;
+        }
+        state.buffer_len += n;
+        remaining -= n;
+
+        if (state.buffer_len < kBlockSize) {
+            return;
+        }
+        const unsigned char* buffers[kLanes] = {state.buffer[0],
+                                                state.buffer[1],
+                                                state.buffer[2],
+                                                state.buffer[3]};
+        compress_x4(state.h, buffers, 1);
+        state.buffer_len = 0;
+    }
+
+    const size_t n_blocks = remaining / kBlockSize;
+    if (n_blocks > 0) {
+        compress_x4(state.h, lane_in, n_blocks);
+        for (size_t lane = 0; lane < kLanes; lane++) {
+            lane_in[lane] += n_blocks * kBlockSize;
+        }
+        remaining -= n_blocks * kBlockSize;
+    }
+
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        memcpy(state.buffer[lane], lane_in[lane], remaining);
+    }
+    state.buffer_len = remaining;
+}
+
+void sha512::final_x4(state_x4_type&       state,
+                      unsigned char* const digest[kLanes])
+{
+    const unsigned char* buffers[kLanes] = {
+        state.buffer[0], state.buffer[1], state.buffer[2], state.buffer[3]};
+
+    // pad with 0x80, zeros, and the 128 bits big endian bit length
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        state.buffer[lane][state.buffer_len] = 0x80;
+        memset(state.buffer[lane] + state.buffer_len + 1,
+               0x00,
+               kBlockSize - state.buffer_len - 1);
+    }
+    if (state.buffer_len >= kBlockSize - 16) {
+        compress_x4(state.h, buffers, 1);
+        for (size_t lane = 0; lane < kLanes; lane++) {
+            memset(state.buffer[lane], 0x00, kBlockSize);
+        }
+    }
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        store_be64(state.buffer[lane] + kBlockSize - 16, state.total_len >> 61);
+        store_be64(state.buffer[lane] + kBlockSize - 8, state.total_len << 3);
+    }
+    compress_x4(state.h, buffers, 1);
+
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        for (size_t i = 0; i < 8; i++) {
+            store_be64(digest[lane] + 8 * i, state.h[i][lane]);
+        }
+    }
+
+    sodium_memzero(&state, sizeof(state));
+}
+
+void sha512::hash_x4(const unsigned char* const in[kLanes],
+                     const size_t               len,
+                     unsigned char* const       digest[kLanes])
+{
+    state_x4_type state;
+
+    init_x4(state);
+    update_x4(state, in, len);
+    final_x4(state, digest);
+}
+
+bool sha512::is_supported(x4_implementation impl) noexcept
+{
+    switch (impl) {
+    case x4_implementation::portable:
+        return true;
+    case x4_implementation::avx2:
+#ifdef SSE_CRYPTO_SHA512_AVX2
+        return sodium_runtime_has_avx2() == 1;
+#else
+        return false;
+#endif
+    }
+    /* LCOV_EXCL_START */
+    return false;
+    /* LCOV_EXCL_STOP */
+}
+
+void sha512::compute_x4_implementation() noexcept
+{
+    if (!set_x4_implementation(x4_implementation::avx2)) {
+        set_x4_implementation(x4_implementation::portable);
+    }
+}
+
+bool sha512::set_x4_implementation(x4_implementation impl) noexcept
+{
+    if (!is_supported(impl)) {
+        return false;
+    }
+    g_x4_implementation.store(impl, std::memory_order_relaxed);
+    return true;
+}
+
+sha512::x4_implementation sha512::get_x4_implementation() noexcept
+{
+    return g_x4_implementation.load(std::memory_order_relaxed);
+}
+
+} // namespace hash
+} // namespace crypto
+} // namespace sse
@@ -24,6 +24,8 @@
 
 #include <string>
 
+#include <sodium/crypto_generichash_blake2b.h>
+
 
 namespace sse {
 
@@ -142,6 +144,119 @@ public:
     /// kDigestSize
     ///
     static std::string hash(const std::string& in, const size_t out_len);
+
+    /// @brief Internal state of the incremental hashing functions
+    using state_type = crypto_generichash_blake2b_state;
+
+    ///
+    /// @brief Initialize an incremental hashing state
+    ///
+    /// The low-level incremental interface, shared with the hash backends.
+    /// Prefer the Hash::State class.
+    ///
+    /// @param state    The state to initialize.
+    ///
+    static void init(state_type& state);
+
+    ///
+    /// @brief Absorb a buffer in an incremental hashing state
+    ///
+    /// @param state    The hashing state, initialized by init().
+    /// @param in       The input buffer.
+    /// @param len      The size of the input buffer in bytes.
+    ///
+    static void update(state_type&          state,
+                       const unsigned char* in,
+                       const size_t         len);
+
+    ///
+    /// @brief Compute the digest of an incremental hashing state
+    ///
+    /// @param state    The hashing state. It must be initialized again
+    ///                 before being reused.
+    /// @param out      The output buffer. Must be larger than kDigestSize
+    ///                 bytes.
+    ///
+    static void final(state_type& state, unsigned char* out);
+
+    /// @class State
+    /// @brief Incremental hashing
+    ///
+    /// A State computes the same digest as Hash::hash over the
+    /// concatenation of all the buffers passed to update(), without copying
+    /// them. States can be copied, for example to hash several messages
+    /// sharing a common prefix. The state is wiped on destruction.
+    ///
+    class State
+    {
+    public:
+        /// @brief Constructor: creates a state for the empty input
+        State();
+
+        /// @brief Destructor: wipes the state
+        ~State();
+
+        /// @brief Copy constructor: clones the state
+        State(const State& state) = default;
+
+        /// @brief Copy assignment operator: clones the state
+        State& operator=(const State& state) = default;
+
+        ///
+        /// @brief Absorb a buffer
+        ///
+        /// @param in   The input buffer. Can only be NULL if len is 0.
+        /// @param len  The size of the input buffer in bytes.
+        ///
+        /// @exception std::invalid_argument    in is NULL and len is not 0
+        /// @exception std::runtime_error       The state was finalized
+        ///
+        void update(const unsigned char* in, const size_t len);
+
+        ///
+        /// @brief Absorb a string
+        ///
+        /// @param in   The input string.
+        ///
+        /// @exception std::runtime_error       The state was finalized
+        ///
+        void update(const std::string& in);
+
+        ///
+        /// @brief Compute the digest
+        ///
+        /// Computes the digest of the absorbed input. The state cannot be
+        /// updated anymore, unless it is reset.
+        ///
+        /// @param out      The output buffer. Must be non NULL, and larger
+        ///                 than out_len bytes.
+        /// @param out_len  The size of the output buffer in bytes. Must be
+        ///                 smaller than kDigestSize. The digest is truncated
+        ///                 to its first out_len bytes.
+        ///
+        /// @exception std::invalid_argument    out is NULL
+        /// @exception std::invalid_argument    out_len is larger than
+        ///                                     kDigestSize
+        /// @exception std::runtime_error       The state was finalized
+        ///
+        void final(unsigned char* out, const size_t out_len = kDigestSize);
+
+        ///
+        /// @brief Compute the digest and return it
+        ///
+        /// @return The kDigestSize bytes digest.
+        ///
+        /// @exception std::runtime_error       The state was finalized
+        ///
+        std::string final();
+
+        /// @brief Reset the state to the empty input
+        void reset();
+
+    private:
+        state_type state_;
+        bool       finalized_{false};
+    };
 };
 
 } // namespace crypto
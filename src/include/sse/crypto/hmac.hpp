@@ -22,6 +22,7 @@
 
 #include "key.hpp"
 #include "random.hpp"
+#include "utils.hpp"
 
 #include <cassert>
 #include <cstdint>
@@ -40,7 +41,7 @@ namespace sse {
 namespace crypto {
 
 // forward declare the Prf class so we can use is as a friend
-template<uint16_t NBYTES>
+template<uint16_t NBYTES, class PrfBase>
 class Prf;
 
 
@@ -58,7 +59,7 @@ class Prf;
 template<class H, uint16_t N>
 class HMac
 {
-    template<uint16_t NBYTES>
+    template<uint16_t NBYTES, class PrfBase>
     friend class Prf;
 
 public:
@@ -169,7 +170,90 @@ public:
     ///
     std::array<uint8_t, H::kDigestSize> hmac(const std::string& s) const;
 
+    ///
+    /// @brief Evaluate HMac
+    ///
+    /// Same as hmac(in, length, out, out_len). This is the evaluation
+    /// function of the interface shared by the Prf constructions.
+    ///
+    void evaluate(const unsigned char* in,
+                  const size_t         length,
+                  unsigned char*       out,
+                  const size_t         out_len = kDigestSize) const
+    {
+        hmac(in, length, out, out_len);
+    }
+
+    ///
+    /// @brief Evaluate HMac on several inputs at once
+    ///
+    /// Evaluates HMac on H::kLanes input buffers of the same length, using
+    /// the multi-buffer interface of the hash function. Only available when
+    /// H supports multi-buffer hashing (e.g. hash::sha512).
+    ///
+    /// @param in       The H::kLanes input buffers. Must be non NULL.
+    /// @param length   The size of each input buffer in bytes.
+    /// @param out      The H::kLanes output buffers. Must be non NULL, and
+    ///                 larger than out_len bytes.
+    /// @param out_len  The size of the output buffers in bytes. Must be
+    ///                 smaller than kDigestSize.
+    ///
+    /// @exception std::invalid_argument       One of the in or out buffers
+    ///                                        is NULL
+    /// @exception std::invalid_argument       out_len is larger than
+    /// kDigestSize
+    ///
+    void hmac_x4(const unsigned char* const in[],
+                 const size_t               length,
+                 unsigned char* const       out[],
+                 const size_t               out_len = kDigestSize) const;
+
+    ///
+    /// @brief Evaluate HMac with a raw key
+    ///
+    /// Same as hmac(in, length, out, out_len), keyed with a kKeySize bytes
+    /// buffer instead of a Key object. For keys that are not secret (e.g.
+    /// the tags used to derive the PPKE masks) or that are already held in
+    /// protected memory.
+    ///
+    /// @param key      The kKeySize bytes key. Must be non NULL.
+    /// @param in       The input buffer. Must be non NULL.
+    /// @param length   The size of the input buffer in bytes.
+    /// @param out      The output buffer. Must be non NULL, and larger
+    ///                 than out_len bytes.
+    /// @param out_len  The size of the output buffer in bytes. Must be
+    ///                 smaller than kDigestSize.
+    ///
+    /// @exception std::invalid_argument       One of key, in or out is NULL
+    /// @exception std::invalid_argument       out_len is larger than
+    /// kDigestSize
+    ///
+    static void hmac_raw_key(const unsigned char* key,
+                             const unsigned char* in,
+                             const size_t         length,
+                             unsigned char*       out,
+                             const size_t         out_len);
+
 private:
+    // Sets pad to the key, padded with zeros, xored with the input pad
+    static void inner_pad(const unsigned char* key, uint8_t* pad) noexcept;
+
+    // Evaluates the HMAC from its input pad, and wipes the pad and the
+    // intermediate values
+    static void hmac_from_pad(uint8_t*             pad,
+                              const unsigned char* in,
+                              const size_t         length,
+                              unsigned char*       out,
+                              const size_t         out_len);
+
+    // Number of blocks going through the hash compression function when
+    // evaluating the HMAC on a length bytes input (padding excluded)
+    static constexpr size_t compression_blocks(const size_t length) noexcept
+    {
+        return (2 * kHMACKeySize + length - 1) / kHMACKeySize
+               + (2 * kHMACKeySize + kDigestSize - 1) / kHMACKeySize;
+    }
+
     Key<kKeySize> key_;
 };
 
@@ -194,58 +278,165 @@ void HMac<H, N>::hmac(const unsigned char* in,
         throw std::invalid_argument("out is NULL");
     }
 
-    uint8_t*         buffer;
-    size_t           i_len      = kHMACKeySize + length;
-    constexpr size_t tmp_len    = kHMACKeySize + kDigestSize;
-    size_t           buffer_len = (i_len > kDigestSize) ? i_len : (kDigestSize);
-
-    buffer = new uint8_t[buffer_len];
-    uint8_t tmp[tmp_len];
+    uint8_t pad[kHMACKeySize];
 
     key_.unlock();
+    inner_pad(key_.data(), pad);
+    key_.lock();
+
+    hmac_from_pad(pad, in, length, out, out_len);
+}
 
-    // copy the key to the buffer
-    memcpy(buffer, key_.data(), kKeySize);
+template<class H, uint16_t N>
+void HMac<H, N>::hmac_raw_key(const unsigned char* key,
+                              const unsigned char* in,
+                              const size_t         length,
+                              unsigned char*       out,
+                              const size_t         out_len)
+{
+    if (out_len > kDigestSize) {
+        throw std::invalid_argument(
+            "Invalid output length: out_len > kDigestSize");
+    }
 
-    // set the other bytes to 0x00
-    if (kKeySize < kHMACKeySize) {
-        memset(buffer + kKeySize, 0x00, kHMACKeySize - kKeySize);
+    if (key == nullptr) {
+        throw std::invalid_argument("key is NULL");
+    }
+
+    if (in == nullptr) {
+        throw std::invalid_argument("in is NULL");
+    }
+
+    if (out == nullptr) {
+        throw std::invalid_argument("out is NULL");
+    }
+
+    uint8_t pad[kHMACKeySize];
+
+    inner_pad(key, pad);
+    hmac_from_pad(pad, in, length, out, out_len);
+}
+
+template<class H, uint16_t N>
+void HMac<H, N>::inner_pad(const unsigned char* key, uint8_t* pad) noexcept
+{
+    // Only the first kHMACKeySize bytes of longer keys are used
+    constexpr size_t key_len
+        = (kKeySize < kHMACKeySize) ? kKeySize : kHMACKeySize;
+
+    // copy the key to the pad, and set the other bytes to 0x00
+    memcpy(pad, key, key_len);
+    if (key_len < kHMACKeySize) {
+        memset(pad + key_len, 0x00, kHMACKeySize - key_len);
     }
 
     // xor the magic number for input
     for (uint16_t i = 0; i < kHMACKeySize; ++i) {
-        buffer[i] ^= 0x36;
+        pad[i] ^= 0x36;
     }
+}
 
-    memcpy(buffer + kHMACKeySize, in, length);
+template<class H, uint16_t N>
+void HMac<H, N>::hmac_from_pad(uint8_t*             pad,
+                               const unsigned char* in,
+                               const size_t         length,
+                               unsigned char*       out,
+                               const size_t         out_len)
+{
+    // HMAC(K, m) = H((K ^ opad) || H((K ^ ipad) || m)), where the input is
+    // streamed into the hash state instead of being copied after the key
+    uint8_t                inner_digest[kDigestSize];
+    uint8_t                digest[kDigestSize];
+    typename H::state_type state;
 
-    H::hash(buffer, i_len, buffer);
+    stats::count(&Statistics::hash_compressions, compression_blocks(length));
 
-    // prepend the key
-    memcpy(tmp, key_.data(), kKeySize);
-    // set the other bytes to 0x00
-    if (kKeySize < kHMACKeySize) {
-        memset(tmp + kKeySize, 0x00, kHMACKeySize - kKeySize);
-    }
+    H::init(state);
+    H::update(state, pad, kHMACKeySize);
+    H::update(state, in, length);
+    H::final(state, inner_digest);
 
-    // xor the magic number for output
+    // turn the input pad into the output pad
     for (uint16_t i = 0; i < kHMACKeySize; ++i) {
-        tmp[i] ^= 0x5c;
+        pad[i] ^= 0x36 ^ 0x5c;
     }
 
-    memcpy(tmp + kHMACKeySize, buffer, kDigestSize);
+    H::init(state);
+    H::update(state, pad, kHMACKeySize);
+    H::update(state, inner_digest, kDigestSize);
+    H::final(state, digest);
 
-    H::hash(tmp, kHMACKeySize + kDigestSize, buffer);
+    memcpy(out, digest, out_len);
+
+    sodium_memzero(pad, kHMACKeySize);
+    sodium_memzero(inner_digest, sizeof(inner_digest));
+    sodium_memzero(digest, sizeof(digest));
+    sodium_memzero(&state, sizeof(state));
+}
 
+template<class H, uint16_t N>
+void HMac<H, N>::hmac_x4(const unsigned char* const in[],
+                         const size_t               length,
+                         unsigned char* const       out[],
+                         const size_t               out_len) const
+{
+    constexpr size_t kLanes = H::kLanes;
 
-    memcpy(out, buffer, out_len);
+    if (out_len > kDigestSize) {
+        throw std::invalid_argument(
+            "Invalid output length: out_len > kDigestSize");
+    }
 
-    sodium_memzero(buffer, buffer_len);
-    delete[] buffer;
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        if (in[lane] == nullptr) {
+            throw std::invalid_argument("in is NULL");
+        }
+        if (out[lane] == nullptr) {
+            throw std::invalid_argument("out is NULL");
+        }
+    }
 
-    sodium_memzero(tmp, tmp_len);
+    // Same construction as hmac(), with the same pad in every lane
+    uint8_t                   pad[kHMACKeySize];
+    uint8_t                   digests[kLanes][kDigestSize];
+    typename H::state_x4_type state;
+
+    const unsigned char* pads[kLanes];
+    const unsigned char* inner_digests[kLanes];
+    unsigned char*       digest_ptrs[kLanes];
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        pads[lane]          = pad;
+        inner_digests[lane] = digests[lane];
+        digest_ptrs[lane]   = digests[lane];
+    }
 
+    key_.unlock();
+    inner_pad(key_.data(), pad);
     key_.lock();
+
+    stats::count(&Statistics::hash_compressions,
+                 kLanes * compression_blocks(length));
+
+    H::init_x4(state);
+    H::update_x4(state, pads, kHMACKeySize);
+    H::update_x4(state, in, length);
+    H::final_x4(state, digest_ptrs);
+
+    for (uint16_t i = 0; i < kHMACKeySize; ++i) {
+        pad[i] ^= 0x36 ^ 0x5c;
+    }
+
+    H::init_x4(state);
+    H::update_x4(state, pads, kHMACKeySize);
+    H::update_x4(state, inner_digests, kDigestSize);
+    H::final_x4(state, digest_ptrs);
+
+    for (size_t lane = 0; lane < kLanes; lane++) {
+        memcpy(out[lane], digests[lane], out_len);
+    }
+
+    sodium_memzero(pad, sizeof(pad));
+    sodium_memzero(digests, sizeof(digests));
 }
 
 template<class H, uint16_t N>
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "random.hpp"
+#include "utils.hpp"
 
 #include <cerrno>
 #include <cstdint>
@@ -49,7 +50,7 @@ namespace crypto {
 // forward declare some templates
 template<class Hash, uint16_t key_size>
 class HMac;
-template<uint16_t NBYTES>
+template<uint16_t NBYTES, class PrfBase>
 class Prf;
 
 void test_keys();
@@ -81,8 +82,9 @@ class Key
 
     template<class Hash, uint16_t key_size>
     friend class HMac;
-    template<uint16_t NBYTES>
+    template<uint16_t NBYTES, class PrfBase>
     friend class Prf;
+    friend class KeyedBlake2b;
     friend class Prg;
     friend class Prp;
     friend class Cipher;
@@ -107,6 +109,7 @@ public:
     Key()
     {
         content_ = static_cast<uint8_t*>(sodium_malloc(N));
+        stats::count(&Statistics::secure_allocations);
 
         if (content_ == nullptr) {
             throw std::bad_alloc(); /* LCOV_EXCL_LINE */
@@ -114,6 +117,7 @@ public:
 #ifdef ENABLE_MEMORY_LOCK
 
         random_bytes(N, content_);
+        stats::count(&Statistics::mprotects);
         int err = sodium_mprotect_noaccess(content_);
         if (err == -1 && errno != ENOSYS) {
             /* LCOV_EXCL_START */
@@ -144,6 +148,7 @@ public:
             throw std::invalid_argument("Invalid key: key == nullptr");
         }
         content_ = static_cast<uint8_t*>(sodium_malloc(N));
+        stats::count(&Statistics::secure_allocations);
 
         if (content_ == nullptr) {
             throw std::bad_alloc(); /* LCOV_EXCL_LINE */
@@ -153,6 +158,7 @@ public:
         sodium_memzero(key, N);   // erase the content of the input key
 
 #ifdef ENABLE_MEMORY_LOCK
+        stats::count(&Statistics::mprotects);
         int err = sodium_mprotect_noaccess(content_);
         if (err == -1 && errno != ENOSYS) {
             /* LCOV_EXCL_START */
@@ -255,6 +261,7 @@ private:
     explicit Key(const std::function<void(uint8_t*)>& init_callback)
     {
         content_ = static_cast<uint8_t*>(sodium_malloc(N));
+        stats::count(&Statistics::secure_allocations);
 
         if (content_ == nullptr) {
             throw std::bad_alloc(); /* LCOV_EXCL_LINE */
@@ -263,6 +270,7 @@ private:
         init_callback(content_); // use the callback to fill the key
 
 #ifdef ENABLE_MEMORY_LOCK
+        stats::count(&Statistics::mprotects);
         int err = sodium_mprotect_noaccess(content_);
         if (err == -1 && errno != ENOSYS) {
             /* LCOV_EXCL_START */
@@ -285,6 +293,9 @@ private:
     {
 #ifdef ENABLE_MEMORY_LOCK
         if (content_ != nullptr && !is_locked_) {
+            // only traced as part of a traced operation
+            TraceSpan span("Key::lock", true);
+            stats::count(&Statistics::mprotects);
             int err = sodium_mprotect_noaccess(content_);
             if (err == -1 && errno != ENOSYS) {
                 /* LCOV_EXCL_START */
@@ -308,6 +319,9 @@ private:
     {
 #ifdef ENABLE_MEMORY_LOCK
         if (content_ != nullptr && is_locked_) {
+            // only traced as part of a traced operation
+            TraceSpan span("Key::unlock", true);
+            stats::count(&Statistics::mprotects);
             int err = sodium_mprotect_readonly(content_);
             if (err == -1 && errno != ENOSYS) {
                 /* LCOV_EXCL_START */
@@ -0,0 +1,315 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include <sse/crypto/wrapper.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sse {
+namespace crypto {
+
+/// @class WrappedKeyStoreBuilder
+/// @brief Creation of wrapped key stores.
+///
+/// WrappedKeyStoreBuilder wraps cryptographic objects with a Wrapper, and
+/// writes them in a single file, which can then be opened with
+/// WrappedKeyStore.
+///
+/// The file is made of four parts (all the integers are little endian):
+/// | item  | magic | version | reserved | entry count | index   | tag | data |
+/// |-------|-------|---------|----------|-------------|---------|-----|------|
+/// |size(B)| 4     | 2       | 2        | 8           | 16*count| 12  | ...  |
+/// Every entry of the index is made of the offset of the wrapped object in
+/// the data region (8 bytes), its length (4 bytes), the type byte of its
+/// class (1 byte), and 3 reserved bytes. The tag authenticates the header
+/// and the index (and thus the position, type and length of every entry):
+/// it is computed with the wrapper's key (cf. Wrapper). The data region is
+/// the concatenation of the wrapped objects, which are authenticated by the
+/// wrapper.
+///
+class WrappedKeyStoreBuilder
+{
+public:
+    ///
+    /// @brief Constructor
+    ///
+    /// @param wrapper  The wrapper used to encrypt the objects. It must
+    ///                 outlive the builder.
+    ///
+    explicit WrappedKeyStoreBuilder(const Wrapper& wrapper);
+
+    ///
+    /// @brief Add an object to the store
+    ///
+    /// Wraps the object and appends it to the store.
+    ///
+    /// @param c    The object to add.
+    ///
+    /// @return     The index of the object in the store.
+    ///
+    template<class CryptoClass>
+    size_t add(const CryptoClass& c);
+
+    /// @brief Number of objects in the store
+    size_t size() const
+    {
+        return index_.size();
+    }
+
+    ///
+    /// @brief Write the store in a file
+    ///
+    /// The store is written to a temporary file in the same directory,
+    /// which then replaces the file at path: the file is either left
+    /// untouched or completely replaced, even if the process is interrupted.
+    /// The file is only readable and writable by its owner.
+    ///
+    /// @param path The path of the file. An existing file is overwritten.
+    ///
+    /// @exception std::runtime_error   The file cannot be written.
+    ///
+    void write(const std::string& path) const;
+
+private:
+    struct IndexEntry
+    {
+        uint64_t offset;
+        uint32_t length;
+        uint8_t  type_byte;
+    };
+
+    const Wrapper&          wrapper_;
+    std::vector<IndexEntry> index_;
+    std::vector<uint8_t>    data_;
+
+    friend class WrappedKeyStore;
+};
+
+/// @class WrappedKeyStore
+/// @brief Lazily unwrapped store of cryptographic objects.
+///
+/// WrappedKeyStore memory-maps a file created by WrappedKeyStoreBuilder.
+/// Opening a store only reads its index: the objects are unwrapped on first
+/// use. When they are released, the most recently used ones are kept in a
+/// LRU cache (the cryptographic objects store their keys in secure memory)
+/// and handed out again by the next calls to get().
+///
+/// The get() function can be called concurrently from several threads.
+///
+class WrappedKeyStore
+{
+public:
+    /// @brief Default number of unwrapped objects kept in the cache
+    static constexpr size_t kDefaultCacheCapacity = 1024;
+
+    ///
+    /// @brief Constructor
+    ///
+    /// Opens a wrapped key store.
+    ///
+    /// @param path             The path of the store.
+    /// @param wrapper          The wrapper used to decrypt the objects. It
+    ///                         must outlive the store.
+    /// @param cache_capacity   The maximum number of unwrapped objects kept
+    ///                         in memory. If it is 0, objects are unwrapped
+    ///                         on every call to get().
+    ///
+    /// @exception std::runtime_error       The file cannot be opened or
+    ///                                     mapped, or its index was not
+    ///                                     written with this wrapper's key
+    ///                                     (or was modified).
+    /// @exception std::invalid_argument    The file is not a valid store.
+    ///
+    WrappedKeyStore(const std::string& path,
+                    const Wrapper&     wrapper,
+                    size_t             cache_capacity = kDefaultCacheCapacity);
+
+    ~WrappedKeyStore();
+
+    WrappedKeyStore(const WrappedKeyStore&) = delete;
+    WrappedKeyStore& operator=(const WrappedKeyStore&) = delete;
+
+    /// @brief Number of objects in the store
+    size_t size() const
+    {
+        return index_.size();
+    }
+
+    /// @brief Number of released objects currently kept in the cache
+    size_t cached_count() const;
+
+    ///
+    /// @brief Get an object of the store
+    ///
+    /// Returns the object at position index, taken from the cache or
+    /// unwrapped if the cache holds no released copy of it. The returned
+    /// object belongs to the caller until the last copy of the pointer is
+    /// destroyed: two calls never return the same object at the same time,
+    /// so the objects returned to different threads can be used
+    /// concurrently. The released object is then put back in the cache (it
+    /// is destroyed if the store has been destroyed in the meantime).
+    ///
+    /// @tparam CryptoClass     The class of the object. It must be the
+    ///                         class used when adding the object to the
+    ///                         store.
+    ///
+    /// @param index    The index of the object.
+    ///
+    /// @return     A pointer to the object.
+    ///
+    /// @exception std::out_of_range        index is not smaller than size().
+    /// @exception std::invalid_argument    The object was not stored with
+    ///                                     this class.
+    /// @exception std::runtime_error       The decryption of the object
+    ///                                     failed.
+    ///
+    template<class CryptoClass>
+    std::shared_ptr<const CryptoClass> get(const size_t index) const;
+
+private:
+    using IndexEntry = WrappedKeyStoreBuilder::IndexEntry;
+
+    // A unique identifier per class, used to check the class of the cached
+    // objects (RTTI might be disabled)
+    template<class CryptoClass>
+    static const void* class_id()
+    {
+        static const char id = 0;
+        return &id;
+    }
+
+    // Returns the wrapped representation of an object, after checking its
+    // index and its type byte
+    const uint8_t* entry(const size_t index,
+                         const uint8_t type_byte,
+                         size_t&       length) const;
+
+    // Cache of the released objects. It is shared with the pointers
+    // returned by get(), so that they can give their object back.
+    class Cache;
+
+    // Takes a released object out of the cache. Returns nullptr if there is
+    // none.
+    std::shared_ptr<void> cache_acquire(const size_t index,
+                                        const void*  class_id) const;
+
+    // Gives an object back to the cache, if it still exists
+    static void cache_release(const std::weak_ptr<Cache>& cache,
+                              const size_t                index,
+                              const void*                 class_id,
+                              std::shared_ptr<void>       obj) noexcept;
+
+    // Hands obj out, and gives it back to the cache when the returned
+    // pointer is released
+    template<class CryptoClass>
+    std::shared_ptr<const CryptoClass> hand_out(
+        const size_t                 index,
+        std::shared_ptr<CryptoClass> obj) const;
+
+    const Wrapper&          wrapper_;
+    std::vector<IndexEntry> index_;
+
+    const uint8_t* mapping_{nullptr};
+    size_t         mapping_size_{0};
+    const uint8_t* data_{nullptr};
+    size_t         data_size_{0};
+
+    mutable std::mutex unwrap_mtx_;
+
+    std::shared_ptr<Cache> cache_;
+};
+
+template<class CryptoClass>
+size_t WrappedKeyStoreBuilder::add(const CryptoClass& c)
+{
+    const size_t wrapped_size = Wrapper::wrapped_size(c);
+    if (wrapped_size > UINT32_MAX) {
+        /* LCOV_EXCL_START */
+        throw std::invalid_argument(
+            "WrappedKeyStoreBuilder::add: the object is too large.");
+        /* LCOV_EXCL_STOP */
+    }
+
+    const size_t offset = data_.size();
+    data_.resize(offset + wrapped_size);
+    wrapper_.wrap_into(c, data_.data() + offset, wrapped_size);
+
+    IndexEntry e;
+    e.offset    = offset;
+    e.length    = static_cast<uint32_t>(wrapped_size);
+    e.type_byte = Wrapper::TypeByte<CryptoClass>::value;
+    index_.push_back(e);
+
+    return index_.size() - 1;
+}
+
+template<class CryptoClass>
+std::shared_ptr<const CryptoClass> WrappedKeyStore::get(
+    const size_t index) const
+{
+    std::shared_ptr<void> cached
+        = cache_acquire(index, class_id<CryptoClass>());
+    if (cached) {
+        return hand_out(index, std::static_pointer_cast<CryptoClass>(cached));
+    }
+
+    size_t         length = 0;
+    const uint8_t* rep
+        = entry(index, Wrapper::TypeByte<CryptoClass>::value, length);
+
+    // unwrap without holding the cache lock, but one object at a time: the
+    // wrapper's key cannot be used concurrently
+    std::shared_ptr<CryptoClass> obj;
+    {
+        std::lock_guard<std::mutex> lock(unwrap_mtx_);
+        obj = std::make_shared<CryptoClass>(
+            wrapper_.unwrap_from<CryptoClass>(rep, length));
+    }
+
+    return hand_out(index, std::move(obj));
+}
+
+template<class CryptoClass>
+std::shared_ptr<const CryptoClass> WrappedKeyStore::hand_out(
+    const size_t                 index,
+    std::shared_ptr<CryptoClass> obj) const
+{
+    const std::weak_ptr<Cache> cache(cache_);
+    const void*                id  = class_id<CryptoClass>();
+    CryptoClass*               raw = obj.get();
+
+    // the deleter owns the object until the returned pointer is released
+    return std::shared_ptr<const CryptoClass>(
+        raw, [cache, index, id, obj](const CryptoClass*) {
+            WrappedKeyStore::cache_release(cache, index, id, obj);
+        });
+}
+
+} // namespace crypto
+} // namespace sse
@@ -0,0 +1,117 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+/// @file keyed_hash.hpp
+///
+/// @brief Keyed hash functions, usable as PRF constructions
+///
+
+#pragma once
+
+#include "key.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sse {
+
+namespace crypto {
+
+// forward declare the Prf class so we can use is as a friend
+template<uint16_t NBYTES, class PrfBase>
+class Prf;
+
+/// @class KeyedBlake2b
+/// @brief Keyed Blake2b
+///
+/// KeyedBlake2b evaluates Blake2b in its keyed mode, which is a PRF on its
+/// own: unlike HMac, it only needs one invocation of the hash function.
+/// It has the same interface as HMac (kKeySize, kDigestSize and evaluate),
+/// and can be used as the construction of the Prf template, as
+/// Prf<NBYTES, KeyedBlake2b>.
+///
+class KeyedBlake2b
+{
+    template<uint16_t NBYTES, class PrfBase>
+    friend class Prf;
+
+public:
+    /// @brief Key size (in bytes)
+    static constexpr uint16_t kKeySize = 32;
+    /// @brief Digest (out) size (in bytes)
+    static constexpr uint8_t kDigestSize = 64;
+
+    ///
+    /// @brief Constructor
+    ///
+    /// Creates a KeyedBlake2b object with a new randomly generated key.
+    ///
+    KeyedBlake2b() = default;
+
+    ///
+    /// @brief Constructor
+    ///
+    /// Creates a KeyedBlake2b object from a kKeySize bytes key.
+    /// After a call to the constructor, the input key is
+    /// held by the KeyedBlake2b object, and cannot be re-used.
+    ///
+    /// @param key  The key used to initialize the hash function.
+    ///             Upon return, k is empty
+    ///
+    /// @exception std::invalid_argument       The key is empty
+    ///
+    explicit KeyedBlake2b(Key<kKeySize>&& key);
+
+    KeyedBlake2b(const KeyedBlake2b& h) = delete;
+
+    /// @brief Move constructor
+    KeyedBlake2b(KeyedBlake2b&& h) noexcept = default;
+
+    /// @brief Move assignment operator
+    KeyedBlake2b& operator=(KeyedBlake2b&& h) noexcept = default;
+
+    ///
+    /// @brief Evaluate the keyed hash function
+    ///
+    /// Hashes the input buffer and places the result in the output buffer
+    /// (and truncates the result it if necessary).
+    ///
+    /// @param in       The input buffer. Must be non NULL.
+    /// @param length   The size of the input buffer in bytes.
+    /// @param out      The output buffer. Must be non NULL, and larger
+    ///                 than out_len bytes.
+    /// @param out_len  The size of the output buffer in bytes. Must be
+    ///                 smaller than kDigestSize.
+    ///
+    /// @exception std::invalid_argument       One of in or out is NULL
+    /// @exception std::invalid_argument       out_len is larger than
+    /// kDigestSize
+    ///
+    void evaluate(const unsigned char* in,
+                  const size_t         length,
+                  unsigned char*       out,
+                  const size_t         out_len = kDigestSize) const;
+
+private:
+    Key<kKeySize> key_;
+};
+
+} // namespace crypto
+} // namespace sse
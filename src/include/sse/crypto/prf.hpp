@@ -23,6 +23,7 @@
 #include "hash.hpp"
 #include "hmac.hpp"
 #include "key.hpp"
+#include "keyed_hash.hpp"
 #include "random.hpp"
 
 #include <cstdint>
@@ -40,8 +41,10 @@ namespace crypto {
 /// @class Prf
 /// @brief Pseudorandom function.
 ///
-/// The Prf templates realizes a pseudorandom function (PRF) using HMac-H, where
-/// H is the hash function defined in hash.hpp (Blake2b).
+/// The Prf templates realizes a pseudorandom function (PRF) using a keyed
+/// construction, by default HMac-H, where H is the hash function defined in
+/// hash.hpp (Blake2b). KeyedBlake2b, which only calls the hash function once,
+/// can be selected instead, as Prf<NBYTES, KeyedBlake2b>.
 ///
 /// It is templated according
 /// to the output length. The rationale behind templating according the output
@@ -51,9 +54,12 @@ namespace crypto {
 /// mode.
 ///
 /// @tparam NBYTES  The output size (in bytes)
+/// @tparam PrfBase The keyed construction. It must have a kKeySize (32)
+///                 bytes key, and provide kDigestSize and evaluate() (see
+///                 HMac and KeyedBlake2b).
 ///
 
-template<uint16_t NBYTES>
+template<uint16_t NBYTES, class PrfBase = HMac<Hash, 32>>
 class Prf
 {
     friend class Wrapper;
@@ -62,8 +68,8 @@ public:
     /// @brief PRF key size (in bytes)
     static constexpr uint8_t kKeySize = 32;
 
-    static_assert(kKeySize <= Hash::kBlockSize,
-                  "The PRF key is too large for the hash block size");
+    static_assert(PrfBase::kKeySize == kKeySize,
+                  "The PRF construction must use kKeySize bytes keys");
 
     /// @brief  Size (in bytes) of the public context (used to wrap a Prf
     ///         object).
@@ -103,13 +109,13 @@ public:
 
 
     // delete the copy constructor
-    Prf(const Prf<NBYTES>& key) = delete;
+    Prf(const Prf& key) = delete;
 
     /// @brief Move constructor
-    Prf(Prf<NBYTES>&& prf) noexcept = default;
+    Prf(Prf&& prf) noexcept = default;
 
-    Prf<NBYTES>& operator=(Prf<NBYTES>&& prf) noexcept = default;
-    Prf<NBYTES>& operator=(const Prf<NBYTES>& prf) = delete;
+    Prf& operator=(Prf&& prf) noexcept = default;
+    Prf& operator=(const Prf& prf) = delete;
 
     /// @brief Destructor.
     ~Prf() // NOLINT // using = default causes a linker error on Travis
@@ -231,9 +237,9 @@ private:
     // ok to set is as pointer to const, while it will be erased by the Key
     // constructor
     // NOLINTNEXTLINE(readability-non-const-parameter)
-    static Prf<NBYTES> deserialize(uint8_t*     in,
-                                   const size_t in_size,
-                                   size_t&      n_bytes_read)
+    static Prf deserialize(uint8_t*     in,
+                           const size_t in_size,
+                           size_t&      n_bytes_read)
     {
         if (in_size < kKeySize) {
             /* LCOV_EXCL_START */
@@ -243,23 +249,21 @@ private:
         }
         n_bytes_read = kKeySize;
 
-        return Prf<NBYTES>(Key<kKeySize>(in));
+        return Prf(Key<kKeySize>(in));
     }
 
     /// @brief Inner implementation of the PRF
-    using PrfBase = HMac<Hash, kKeySize>;
-
     PrfBase base_;
 };
 
-template<uint16_t NBYTES>
-constexpr uint8_t Prf<NBYTES>::kKeySize;
+template<uint16_t NBYTES, class PrfBase>
+constexpr uint8_t Prf<NBYTES, PrfBase>::kKeySize;
 
 // PRF instantiation
-// For now, use HMAC-Hash where Hash is the hash function defined in hash.hpp
-template<uint16_t NBYTES>
-std::array<uint8_t, NBYTES> Prf<NBYTES>::prf(const unsigned char* in,
-                                             const size_t         length) const
+template<uint16_t NBYTES, class PrfBase>
+std::array<uint8_t, NBYTES> Prf<NBYTES, PrfBase>::prf(
+    const unsigned char* in,
+    const size_t         length) const
 {
     if (in == nullptr) {
         throw std::invalid_argument("in is NULL");
@@ -283,21 +287,21 @@ std::array<uint8_t, NBYTES> Prf<NBYTES>::prf(const unsigned char* in,
 
             // fill res
             if (static_cast<size_t>(NBYTES - pos) >= PrfBase::kDigestSize) {
-                base_.hmac(
+                base_.evaluate(
                     tmp, length + 1, result.data() + pos, PrfBase::kDigestSize);
             } else {
-                base_.hmac(tmp,
-                           length + 1,
-                           result.data() + pos,
-                           static_cast<size_t>(NBYTES - pos));
+                base_.evaluate(tmp,
+                               length + 1,
+                               result.data() + pos,
+                               static_cast<size_t>(NBYTES - pos));
             }
         }
 
         sodium_memzero(tmp, length + 1);
         delete[] tmp;
-    } else if (NBYTES <= Hash::kDigestSize) {
+    } else if (NBYTES <= PrfBase::kDigestSize) {
         // only need one output bloc of PrfBase.
-        base_.hmac(in, length, result.data(), result.size());
+        base_.evaluate(in, length, result.data(), result.size());
     }
 
 
@@ -305,15 +309,16 @@ std::array<uint8_t, NBYTES> Prf<NBYTES>::prf(const unsigned char* in,
 }
 
 // Convienience function to run the PRF over a C++ string
-template<uint16_t NBYTES>
-std::array<uint8_t, NBYTES> Prf<NBYTES>::prf(const std::string& s) const
+template<uint16_t NBYTES, class PrfBase>
+std::array<uint8_t, NBYTES> Prf<NBYTES, PrfBase>::prf(
+    const std::string& s) const
 {
     return prf(reinterpret_cast<const unsigned char*>(s.data()), s.length());
 }
 
-template<uint16_t NBYTES>
+template<uint16_t NBYTES, class PrfBase>
 template<size_t L>
-std::array<uint8_t, NBYTES> Prf<NBYTES>::prf(
+std::array<uint8_t, NBYTES> Prf<NBYTES, PrfBase>::prf(
     const std::array<uint8_t, L>& in) const
 {
     return prf(reinterpret_cast<const unsigned char*>(in.data()), L);
@@ -321,22 +326,23 @@ std::array<uint8_t, NBYTES> Prf<NBYTES>::prf(
 
 // derive a key using the PRF
 
-template<uint16_t NBYTES>
-Key<NBYTES> Prf<NBYTES>::derive_key(const unsigned char* in,
-                                    const size_t         length) const
+template<uint16_t NBYTES, class PrfBase>
+Key<NBYTES> Prf<NBYTES, PrfBase>::derive_key(const unsigned char* in,
+                                             const size_t         length) const
 {
     return Key<NBYTES>(prf(in, length).data());
 }
 
-template<uint16_t NBYTES>
-Key<NBYTES> Prf<NBYTES>::derive_key(const std::string& s) const
+template<uint16_t NBYTES, class PrfBase>
+Key<NBYTES> Prf<NBYTES, PrfBase>::derive_key(const std::string& s) const
 {
     return Key<NBYTES>(prf(s).data());
 }
 
-template<uint16_t NBYTES>
+template<uint16_t NBYTES, class PrfBase>
 template<size_t L>
-Key<NBYTES> Prf<NBYTES>::derive_key(const std::array<uint8_t, L>& in) const
+Key<NBYTES> Prf<NBYTES, PrfBase>::derive_key(
+    const std::array<uint8_t, L>& in) const
 {
     return Key<NBYTES>(prf(in).data());
 }
@@ -380,6 +386,9 @@ extern template Key<1024> Prf<1024>::derive_key(
     const std::array<uint8_t, 200>& in) const;
 
 extern template class Prf<2000>;
+
+extern template class Prf<32, KeyedBlake2b>;
+extern template class Prf<128, KeyedBlake2b>;
 } // namespace crypto
 } // namespace sse
 #endif
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "key.hpp"
+#include "utils.hpp"
 
 #include <cstdint>
 
@@ -462,6 +463,7 @@ std::vector<Key<K>> Prg::derive_keys(const uint16_t n_keys,
 
     uint8_t* key_buffer
         = reinterpret_cast<uint8_t*>(sodium_allocarray(n_keys, K));
+    stats::count(&Statistics::secure_allocations);
 
     this->derive(key_offset * K, n_keys * K, key_buffer);
 
@@ -506,6 +508,7 @@ std::vector<Key<K>> Prg::derive_keys(Key<kKeySize>&& k,
 
     uint8_t* key_buffer
         = reinterpret_cast<uint8_t*>(sodium_allocarray(n_keys, K));
+    stats::count(&Statistics::secure_allocations);
 
     derive(std::move(k), key_offset * K, n_keys * K, key_buffer);
 
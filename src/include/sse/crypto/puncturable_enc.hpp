@@ -25,6 +25,7 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace sse {
@@ -146,6 +147,27 @@ public:
     punct::ciphertext_type encrypt(const uint64_t         m,
                                    const punct::tag_type& tag);
 
+    ///
+    /// @brief Encrypt a batch of messages
+    ///
+    /// Encrypts every (message, tag) pair of the input vector. The result is
+    /// the same as calling encrypt() on every pair, but the setup is shared
+    /// by the whole batch, and the batch can be split between several
+    /// threads.
+    ///
+    /// @param messages     The messages to encrypt, with their tags
+    /// @param n_threads    The number of threads used for the computation.
+    ///                     If it is 0, the number of hardware threads is used.
+    ///
+    /// @return     The ciphertexts, in the same order as the messages
+    ///
+    /// @exception  std::invalid_argument   One of the tags is the NULL tag.
+    ///                                     No message is encrypted.
+    ///
+    std::vector<punct::ciphertext_type> encrypt_batch(
+        const std::vector<std::pair<uint64_t, punct::tag_type>>& messages,
+        unsigned int                                             n_threads = 1);
+
     ///
     /// @brief Generate the first keyshare of a punctured decryption key
     ///
@@ -208,11 +230,39 @@ public:
     /// Creates a PuncturableDecryption object from a punctured_key, i.e. from
     /// a list of keyshares (cf. the description of punct::punctured_key_type).
     ///
-    /// @param punctured_key    The list of keyshare used to initialize the
-    ///                         PuncturableDecryption object.
+    /// The decryption of a ciphertext mostly consists in multiplying two
+    /// elements of every keyshare by scalars. With fixed_base_tables, the
+    /// constructor precomputes tables for these multiplications: decryptions
+    /// are faster, but every keyshare then uses a few kilobytes of memory.
+    ///
+    /// @param punctured_key        The list of keyshare used to initialize the
+    ///                             PuncturableDecryption object.
+    /// @param fixed_base_tables    Precompute the fixed-base tables of the
+    ///                             keyshares.
     ///
     explicit PuncturableDecryption(
-        const punct::punctured_key_type& punctured_key);
+        const punct::punctured_key_type& punctured_key,
+        bool                             fixed_base_tables = false);
+
+    ///
+    /// @brief Constructor
+    ///
+    /// Creates a PuncturableDecryption object from a snapshot generated by
+    /// snapshot(). The elements of the keyshares are stored uncompressed,
+    /// and every one of them is checked to be an element of G2 when the
+    /// snapshot is reloaded. The snapshot is not authenticated: it must come
+    /// from a trusted storage.
+    ///
+    /// @param snapshot             The snapshot of a PuncturableDecryption
+    ///                             object.
+    /// @param fixed_base_tables    Precompute the fixed-base tables of the
+    ///                             keyshares.
+    ///
+    /// @exception  std::invalid_argument   The snapshot is malformed, or
+    ///                                     contains invalid group elements.
+    ///
+    explicit PuncturableDecryption(const std::vector<uint8_t>& snapshot,
+                                   bool fixed_base_tables = false);
 
     PuncturableDecryption(const PuncturableDecryption&) = delete;
 
@@ -225,6 +275,55 @@ public:
     ///
     ~PuncturableDecryption();
 
+    ///
+    /// @brief Check if the key is punctured on a tag
+    ///
+    /// The check does not depend linearly on the number of keyshares: it is
+    /// cheap, even for heavily punctured keys.
+    ///
+    /// @param tag  The tag to look for
+    ///
+    /// @return     true if the decryption key is punctured on tag, i.e. if
+    ///             the ciphertexts encrypted with tag cannot be decrypted.
+    ///
+    bool is_punctured_on_tag(const punct::tag_type& tag) const;
+
+    ///
+    /// @brief Add a keyshare to the decryption key
+    ///
+    /// Adds a keyshare to the key without parsing the previous keyshares
+    /// again. The keyshare generated by inc_puncture() is appended to the
+    /// key, and the initial keyshare (whose tag is the NULL tag) replaces the
+    /// current initial keyshare. Hence, to puncture a key with d punctures,
+    /// add the keyshares initial_keyshare(d+1) and inc_puncture(d+1, tag).
+    ///
+    /// add_share() must not be called concurrently with a decryption.
+    ///
+    /// @param share    The keyshare to add to the key.
+    ///
+    void add_share(const punct::key_share_type& share);
+
+    ///
+    /// @brief Add keyshares to the decryption key
+    ///
+    /// Calls add_share() on every keyshare of the input, in order.
+    ///
+    /// @param shares   The keyshares to add to the key.
+    ///
+    void extend(const punct::punctured_key_type& shares);
+
+    ///
+    /// @brief Serialize the decryption key
+    ///
+    /// Returns a snapshot of the decryption key, from which the
+    /// PuncturableDecryption object can be reloaded. The snapshot contains
+    /// the keyshares in an uncompressed format: it is larger than the
+    /// punctured key, but it is much faster to parse.
+    ///
+    /// @return     The snapshot of the decryption key.
+    ///
+    std::vector<uint8_t> snapshot() const;
+
     ///
     /// @brief Encrypt a message
     ///
@@ -232,13 +331,58 @@ public:
     /// The message can be decrypted with a punctured key whose associated tag
     /// set does not contain the tage used during the encryption
     ///
-    /// @param ct   The ciphertext to decrypt
-    /// @param m    The result of the decryption
+    /// @param ct           The ciphertext to decrypt
+    /// @param m            The result of the decryption
+    /// @param n_threads    The number of threads between which the key shares
+    ///                     are split. If it is 0, the number of hardware
+    ///                     threads is used. Keys with few shares are always
+    ///                     processed by a single thread.
     ///
     /// @return     true if the decryption succeeded, false if the tag with
     ///             which the message was encrypted was punctured.
     ///
-    bool decrypt(const punct::ciphertext_type& ct, uint64_t& m);
+    bool decrypt(const punct::ciphertext_type& ct,
+                 uint64_t&                     m,
+                 unsigned int                  n_threads = 1);
+
+    ///
+    /// @brief Decrypt a batch of ciphertexts
+    ///
+    /// Decrypts every ciphertext of the input vector. The result is the same
+    /// as calling decrypt() on every ciphertext. When there are at least as
+    /// many ciphertexts as threads, the ciphertexts are split between the
+    /// threads. Otherwise, the ciphertexts are decrypted one after the other,
+    /// and the key shares are split between the threads.
+    ///
+    /// @param cts          The ciphertexts to decrypt
+    /// @param ms           The results of the decryptions, in the same order as
+    ///                     the ciphertexts. The result of a failed decryption
+    ///                     is set to 0.
+    /// @param n_threads    The number of threads used for the computation.
+    ///                     If it is 0, the number of hardware threads is used.
+    ///
+    /// @return     For every ciphertext, true if its decryption succeeded,
+    ///             false if its tag was punctured.
+    ///
+    std::vector<bool> decrypt_batch(
+        const std::vector<punct::ciphertext_type>& cts,
+        std::vector<uint64_t>&                     ms,
+        unsigned int                               n_threads = 1);
+
+    ///
+    /// @brief Set the minimum number of keyshares per decryption thread
+    ///
+    /// When the keyshares are split between several threads, every thread
+    /// is given at least min_shares keyshares: with fewer keyshares, the cost
+    /// of the synchronization outweighs the gain. The default value (4) can
+    /// be tuned with the PPKE_parallel_decrypt benchmark. The setting is
+    /// global, and applies to all the PuncturableDecryption objects.
+    ///
+    /// @param min_shares   The minimum number of keyshares per thread.
+    ///
+    /// @exception std::invalid_argument    min_shares is 0.
+    ///
+    static void set_min_shares_per_thread(size_t min_shares);
 
 private:
     /// @class PDecImpl
@@ -26,6 +26,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 #include <array>
 #include <string>
 
@@ -33,9 +36,38 @@ namespace sse {
 
 namespace crypto {
 
+/// @brief Sources of randomness for random_bytes
+///
+enum class RandomSource : uint8_t
+{
+    /// Every call is forwarded to libsodium's randombytes_buf, i.e. to the
+    /// operating system's generator. This is the default source.
+    System,
+    /// Each thread uses a buffered ChaCha20 generator, with fast key erasure.
+    /// It is seeded from the operating system's generator, and reseeded
+    /// periodically and after a fork. Its state is kept in secure memory
+    /// (see sodium_malloc), allocated by the first call of each thread.
+    /// Faster for small requests, but opt-in: a process using it keeps a
+    /// generator state per thread.
+    BufferedChaCha20,
+};
+
+/// @brief Select the source of randomness used by random_bytes
+///
+/// The source can be changed at any time, and is shared by all the threads.
+///
+/// @param source   The new source of randomness
+///
+void set_random_source(RandomSource source) noexcept;
+
+/// @brief Return the source of randomness currently used by random_bytes
+///
+RandomSource random_source() noexcept;
+
 /// @brief Generate random bytes
 ///
-/// Fills a buffer with random bytes
+/// Fills a buffer with random bytes, drawn from the source returned by
+/// random_source().
 ///
 /// @param byte_count   Number of bytes to generate
 ///
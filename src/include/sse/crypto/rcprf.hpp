@@ -23,6 +23,7 @@
 
 #include "key.hpp"
 #include "prg.hpp"
+#include "utils.hpp"
 
 #include <cassert>
 #include <cstring>
@@ -1418,6 +1419,7 @@ void ConstrainedRCPrf<NBYTES>::eval_range(uint64_t             min,
                                           uint64_t             max,
                                           const callback_type& callback) const
 {
+    TraceSpan span("ConstrainedRCPrf::eval_range");
     if (max < min) {
         throw std::invalid_argument("ConstrainedRCPrf::eval_range: Invalid "
                                     "range: min is larger than max: max="
@@ -1483,6 +1485,7 @@ template<uint16_t NBYTES>
 ConstrainedRCPrf<NBYTES> ConstrainedRCPrf<NBYTES>::constrain(uint64_t min,
                                                              uint64_t max) const
 {
+    TraceSpan span("ConstrainedRCPrf::constrain");
     std::vector<std::unique_ptr<ConstrainedRCPrfElement<NBYTES>>>
         constrained_elements;
     generate_constrained_subkeys(min, max, constrained_elements);
@@ -1969,6 +1972,7 @@ void RCPrf<NBYTES>::eval_range(uint64_t             min,
                                uint64_t             max,
                                const callback_type& callback) const
 {
+    TraceSpan span("RCPrf::eval_range");
     if (max >> this->tree_height() != 0) {
         throw std::out_of_range("Invalid max index: max > 2^height -1.");
     }
@@ -1987,6 +1991,7 @@ template<uint16_t NBYTES>
 ConstrainedRCPrf<NBYTES> RCPrf<NBYTES>::constrain(uint64_t min,
                                                   uint64_t max) const
 {
+    TraceSpan span("RCPrf::constrain");
     std::vector<std::unique_ptr<ConstrainedRCPrfElement<NBYTES>>>
         constrained_elements;
     generate_constrained_subkeys(min, max, constrained_elements);
@@ -28,8 +28,10 @@
 #include <cstring>
 
 #include <array>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace sse {
 namespace crypto {
@@ -70,6 +72,11 @@ public:
     static constexpr size_t kRSAPrfSize
         = kMessageSize + (kStatisticalSecurity + 7) / 8;
 
+    /// @brief The callback type used by the iterated evaluation functions
+    using iteration_callback_type
+        = std::function<void(uint32_t,
+                             const std::array<uint8_t, kMessageSize>&)>;
+
     ///
     /// @brief  Constructor
     ///
@@ -258,6 +265,52 @@ public:
     std::array<uint8_t, kMessageSize> eval(
         const std::array<uint8_t, kMessageSize>& in) const;
 
+    ///
+    /// @brief Iteratively evaluate the TDP
+    ///
+    /// Iteratively evaluates the TDP on the input message order times (i.e.
+    /// compute \f$ \pi_{PK}^{order}(in)\f$) and returns the result as a byte
+    /// array. The intermediate values are kept in an internal representation
+    /// between the iterations, which makes this function much faster than
+    /// order successive calls to eval().
+    ///
+    /// @param  in      The input message, stored in a byte array
+    /// @param  order   The number of times the TDP evaluation is iterated on in
+    /// @return         The result of the iterated evaluation, stored in a
+    ///                 byte array
+    ///
+    /// @exception std::runtime_error   Parsing in as a valid input failed
+    ///
+    std::array<uint8_t, kMessageSize> eval_iterated(
+        const std::array<uint8_t, kMessageSize>& in,
+        uint32_t                                 order) const;
+
+    ///
+    /// @brief Iteratively evaluate the TDP, and output the intermediate values
+    ///
+    /// Iteratively evaluates the TDP on the input message order times (i.e.
+    /// compute \f$ \pi_{PK}^{order}(in)\f$) and returns the result as a byte
+    /// array. For every 1 <= i <= order, callback is called with i and
+    /// \f$ \pi_{PK}^{i}(in)\f$.
+    ///
+    /// The array passed to the callback is an internal buffer, overwritten at
+    /// every iteration: it is only valid during the call to the callback, and
+    /// must be copied if it has to be kept.
+    ///
+    /// @param  in          The input message, stored in a byte array
+    /// @param  order       The number of times the TDP evaluation is iterated
+    ///                     on in
+    /// @param  callback    The function called on every intermediate value
+    /// @return             The result of the iterated evaluation, stored in a
+    ///                     byte array
+    ///
+    /// @exception std::runtime_error   Parsing in as a valid input failed
+    ///
+    std::array<uint8_t, kMessageSize> eval_iterated(
+        const std::array<uint8_t, kMessageSize>& in,
+        uint32_t                                 order,
+        const iteration_callback_type&           callback) const;
+
 private:
     std::unique_ptr<TdpImpl> tdp_imp_; // opaque pointer
 };
@@ -575,6 +628,31 @@ public:
         const std::array<uint8_t, kMessageSize>& in,
         uint32_t                                 order) const;
 
+    ///
+    /// @brief Invert the TDP on a batch of messages
+    ///
+    /// Evaluates the inverse of the TDP on every message of the input vector.
+    /// The result is the same as calling invert() on every message, but the
+    /// implementation can share work between the inversions (e.g. exponent
+    /// blinding, interleaved exponentiations), and split the batch between
+    /// several threads.
+    ///
+    /// @param  in          The input messages
+    /// @param  n_threads   The number of threads used for the computation,
+    ///                     including the calling thread. If it is 0, or
+    ///                     larger than the number of hardware threads, the
+    ///                     number of hardware threads is used. The other
+    ///                     threads are persistent workers.
+    /// @return             The results of the inversions, in the same order
+    ///                     as the inputs
+    ///
+    /// @exception std::invalid_argument    One of the inputs is not a valid
+    ///                                     message
+    ///
+    std::vector<std::array<uint8_t, kMessageSize>> invert_batch(
+        const std::vector<std::array<uint8_t, kMessageSize>>& in,
+        unsigned int n_threads = 1) const;
+
 private:
     std::unique_ptr<TdpInverseImpl> tdp_inv_imp_; // opaque pointer
 
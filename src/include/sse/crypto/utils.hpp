@@ -23,6 +23,9 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <atomic>
+#include <iosfwd>
+
 namespace sse {
 namespace crypto {
 ///
@@ -40,6 +43,194 @@ void init_crypto_lib();
 ///
 void cleanup_crypto_lib();
 
+///
+/// @brief Per-thread counters of expensive operations
+///
+/// When the library is compiled with ENABLE_STATISTICS, every thread counts
+/// the expensive operations it triggers. Otherwise, the counters stay at 0
+/// and the instrumentation compiles to nothing.
+///
+struct Statistics
+{
+    /// Memory protection changes (sodium_mprotect_* calls)
+    uint64_t mprotects{0};
+    /// Secure memory allocations (sodium_malloc and sodium_allocarray calls)
+    uint64_t secure_allocations{0};
+    /// ChaCha20 blocks generated by Prg
+    uint64_t prg_blocks{0};
+    /// Blocks processed by the hash compression function in HMac
+    uint64_t hash_compressions{0};
+    /// Pairings (Miller loops) computed by the puncturable encryption
+    uint64_t pairings{0};
+    /// Exponentiations in the pairing groups G1, G2 and GT
+    uint64_t exponentiations{0};
+    /// Pairing group elements parsed from their compressed encoding
+    uint64_t decompressions{0};
+    /// Modular exponentiations computed by the trapdoor permutations
+    uint64_t mod_exps{0};
+};
+
+///
+/// @brief Returns true if the library counts its operations
+///
+constexpr bool statistics_enabled() noexcept
+{
+#ifdef ENABLE_STATISTICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+///
+/// @brief Snapshot of the calling thread's statistics
+///
+/// @return The operations counted since the thread started, or since its
+///         last call to reset_statistics().
+///
+Statistics statistics_snapshot() noexcept;
+
+///
+/// @brief Resets the calling thread's statistics
+///
+void reset_statistics() noexcept;
+
+namespace stats {
+// Counters of the calling thread. Use count() instead of this function.
+Statistics& thread_statistics() noexcept;
+
+// Adds n to one of the calling thread's counters. This is a no-op when the
+// library is compiled without ENABLE_STATISTICS.
+inline void count(uint64_t Statistics::*counter, const uint64_t n = 1) noexcept
+{
+#ifdef ENABLE_STATISTICS
+    thread_statistics().*counter += n;
+#else
+    (void)counter;
+    (void)n;
+#endif
+}
+} // namespace stats
+
+///
+/// @brief Enables the tracing of the library's operations
+///
+/// Once tracing is enabled, the public operations of the library (and the key
+/// locking) record spans in a per-thread ring buffer. Only one top-level
+/// span out of sampling_period is recorded, together with all the spans
+/// nested in it. Tracing is disabled by default.
+///
+/// @param sampling_period      Record one top-level span out of
+///                             sampling_period. 1 records every span.
+/// @param events_per_thread    Capacity of the ring buffer of each thread.
+///                             When it is full, the oldest spans are
+///                             overwritten. Only used by the threads that
+///                             did not record any span yet.
+///
+/// @exception std::invalid_argument    sampling_period or events_per_thread
+///                                     is 0.
+///
+void enable_tracing(const uint32_t sampling_period   = 1,
+                    const size_t   events_per_thread = 4096);
+
+///
+/// @brief Disables the tracing of the library's operations
+///
+/// The spans recorded so far are kept until clear_trace() is called.
+///
+void disable_tracing() noexcept;
+
+///
+/// @brief Returns true if the library's operations are traced
+///
+bool tracing_enabled() noexcept;
+
+///
+/// @brief Writes the recorded spans in the Chrome trace-event format
+///
+/// The output is a JSON object that can be loaded in chrome://tracing or in
+/// Perfetto. The spans of all the threads are written, including the ones
+/// of threads that have exited since they were recorded. The spans of the
+/// exited threads are then discarded: they are only dumped once. Only the
+/// spans of the 64 most recently started exited threads are kept until
+/// they are dumped.
+///
+/// @param out  The output stream.
+///
+void dump_trace(std::ostream& out);
+
+///
+/// @brief Discards all the recorded spans
+///
+void clear_trace();
+
+namespace trace {
+// Set by enable_tracing() and disable_tracing(). Use TraceSpan instead.
+extern std::atomic<bool> g_enabled;
+
+// Called when a span starts while tracing is enabled. Returns false if the
+// span is ignored (a nested_only span outside of any other span), in which
+// case end_span must not be called. Otherwise, sets sampled, and start if
+// the span is sampled.
+bool begin_span(uint64_t&  start,
+                const bool nested_only,
+                bool&      sampled) noexcept;
+
+// Called when a span started by begin_span() ends
+void end_span(const char*    name,
+              const uint64_t start,
+              const bool     sampled) noexcept;
+} // namespace trace
+
+///
+/// @brief Scoped tracing span
+///
+/// Records the time spent between the construction and the destruction of
+/// the object when tracing is enabled (see enable_tracing()). When tracing
+/// is disabled, this costs a single relaxed atomic load.
+///
+class TraceSpan
+{
+public:
+    ///
+    /// @brief Starts a span
+    ///
+    /// @param name         The name of the span. It must outlive the trace,
+    ///                     e.g. be a string literal.
+    /// @param nested_only  Only record the span when it is nested in another
+    ///                     one. Used for the frequent low-level operations,
+    ///                     which would otherwise take the sampling slots of
+    ///                     the top-level spans.
+    ///
+    explicit TraceSpan(const char* name,
+                       const bool  nested_only = false) noexcept
+        : name_(name)
+    {
+        if (trace::g_enabled.load(std::memory_order_relaxed)) {
+            started_ = trace::begin_span(start_, nested_only, sampled_);
+        }
+    }
+
+    ///
+    /// @brief Ends the span
+    ///
+    ~TraceSpan()
+    {
+        if (started_) {
+            trace::end_span(name_, start_, sampled_);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    uint64_t    start_{0};
+    bool        started_{false};
+    bool        sampled_{false};
+};
+
 const uint8_t* strstrn_uint8(const uint8_t* str1,
                              const size_t   str1_len,
                              const uint8_t* str2,
@@ -178,6 +178,96 @@ public:
     template<class CryptoClass>
     CryptoClass unwrap(std::vector<uint8_t>& c_rep) const;
 
+    ///
+    /// @brief Size of the wrapped representation of an object
+    ///
+    /// @param c    The object to be wrapped.
+    ///
+    /// @return The number of bytes written by wrap_into(c, ...)
+    ///
+    template<class CryptoClass>
+    static size_t wrapped_size(const CryptoClass& c)
+    {
+        return kCiphertextExpansion + c.serialized_size();
+    }
+
+    ///
+    /// @brief Wrap a cryptographic object into a caller-provided buffer
+    ///
+    /// Same as wrap(), but writes the encrypted representation of the object
+    /// in the out buffer instead of allocating a new vector. The secure
+    /// staging buffer is reused from one call to the other (it is
+    /// thread-local, and wiped after every use).
+    ///
+    /// @param c        The object to be wrapped.
+    /// @param out      The output buffer.
+    /// @param out_size The size of the output buffer. It must be at least
+    ///                 wrapped_size(c).
+    ///
+    /// @return The number of bytes written in out (i.e. wrapped_size(c)).
+    ///
+    /// @exception std::invalid_argument    The output buffer is too small.
+    ///
+    template<class CryptoClass>
+    size_t wrap_into(const CryptoClass& c,
+                     uint8_t*           out,
+                     const size_t       out_size) const;
+
+    ///
+    /// @brief Unwrap a cryptographic object from a caller-provided buffer
+    ///
+    /// Same as unwrap(), but reads the encrypted representation from a
+    /// buffer. Contrary to unwrap(), the input buffer is **not** wiped:
+    /// this is the responsibility of the caller.
+    ///
+    /// @param in       The buffer containing the encrypted representation of
+    ///                 the object.
+    /// @param in_size  The size of the in buffer.
+    ///
+    /// @return     The object represented by the encrypted buffer.
+    ///
+    /// @exception std::invalid_argument    The input buffer is too small.
+    /// @exception std::runtime_error       The decryption failed:
+    ///                                     invalid tag
+    ///
+    template<class CryptoClass>
+    CryptoClass unwrap_from(const uint8_t* in, const size_t in_size) const;
+
+    ///
+    /// @brief Wrap a collection of cryptographic objects
+    ///
+    /// Wraps every object of the container. This is faster than calling
+    /// wrap() on every object: the key is only unlocked once, and the
+    /// staging buffer is reused.
+    ///
+    /// @param objects  The objects to be wrapped. The container must be
+    ///                 iterable, and its elements must be wrappable.
+    ///
+    /// @return The encrypted representations of the objects, in the order of
+    ///         the container.
+    ///
+    template<class Container>
+    std::vector<std::vector<uint8_t>> wrap_many(
+        const Container& objects) const;
+
+    ///
+    /// @brief Unwrap a collection of cryptographic objects
+    ///
+    /// Unwraps every representation of the input vector, with the same
+    /// savings as wrap_many(). The input buffers are **not** wiped.
+    ///
+    /// @param c_reps   The encrypted representations of the objects.
+    ///
+    /// @return     The unwrapped objects, in the order of the input.
+    ///
+    /// @exception std::invalid_argument    One of the buffers is too small.
+    /// @exception std::runtime_error       One of the decryptions failed:
+    ///                                     invalid tag
+    ///
+    template<class CryptoClass>
+    std::vector<CryptoClass> unwrap_many(
+        const std::vector<std::vector<uint8_t>>& c_reps) const;
+
     static constexpr size_t kDefaultTypeByte = 0x00;
 
 private:
@@ -187,21 +277,120 @@ private:
         static constexpr uint8_t value = kDefaultTypeByte;
     };
 
+    // Secure (sodium_malloc'ed) staging buffer of at least size bytes,
+    // reused by all the wrapping operations of the calling thread. Callers
+    // must wipe it after use.
+    static uint8_t* scratch_buffer(const size_t size);
+
+    // Wipes a staging buffer when it goes out of scope
+    struct ScratchWiper
+    {
+        uint8_t*     buffer;
+        const size_t size;
+
+        ~ScratchWiper()
+        {
+            sodium_memzero(buffer, size);
+        }
+    };
+
+    // Wrapping and unwrapping, with an already unlocked encryption key
+    template<class CryptoClass>
+    void wrap_with_key(const CryptoClass& c,
+                       uint8_t*           out,
+                       const uint8_t*     encryption_key) const;
+
+    template<class CryptoClass>
+    CryptoClass unwrap_with_key(const uint8_t* in,
+                                const size_t   in_size,
+                                const uint8_t* encryption_key) const;
+
+    // Tag authenticating data that is not a wrapped object (e.g. the index
+    // of a key store). The PRF input starts with a label and with the
+    // default type byte, which no wrapped object uses: these tags cannot be
+    // confused with the tags of the wrapped objects.
+    std::array<uint8_t, kTagSize> metadata_tag(const uint8_t* in,
+                                               const size_t   in_size) const;
+
     static constexpr uint16_t kEncryptionKeySize = 32U;
 
+    // the key stores record the type bytes of the wrapped objects, and
+    // authenticate their indexes
+    friend class WrappedKeyStoreBuilder;
+    friend class WrappedKeyStore;
+
     Prf<kTagSize>           tag_generator_;
     Key<kEncryptionKeySize> encryption_key_;
 };
 
 template<class CryptoClass>
 std::vector<uint8_t> Wrapper::wrap(const CryptoClass& c) const
+{
+    std::vector<uint8_t> out(wrapped_size(c));
+    wrap_into(c, out.data(), out.size());
+
+    return out;
+}
+
+template<class CryptoClass>
+size_t Wrapper::wrap_into(const CryptoClass& c,
+                          uint8_t*           out,
+                          const size_t       out_size) const
+{
+    const size_t size = wrapped_size(c);
+    if (out_size < size) {
+        throw std::invalid_argument(
+            "Wrapper::wrap_into: output buffer is too small.");
+    }
+
+    const uint8_t* key = encryption_key_.unlock_get();
+    try {
+        wrap_with_key(c, out, key);
+    } catch (...) {
+        /* LCOV_EXCL_START */
+        encryption_key_.lock();
+        throw;
+        /* LCOV_EXCL_STOP */
+    }
+    encryption_key_.lock();
+
+    return size;
+}
+
+template<class Container>
+std::vector<std::vector<uint8_t>> Wrapper::wrap_many(
+    const Container& objects) const
+{
+    std::vector<std::vector<uint8_t>> out;
+
+    const uint8_t* key = encryption_key_.unlock_get();
+    try {
+        for (const auto& c : objects) {
+            out.emplace_back(wrapped_size(c));
+            wrap_with_key(c, out.back().data(), key);
+        }
+    } catch (...) {
+        /* LCOV_EXCL_START */
+        encryption_key_.lock();
+        throw;
+        /* LCOV_EXCL_STOP */
+    }
+    encryption_key_.lock();
+
+    return out;
+}
+
+template<class CryptoClass>
+void Wrapper::wrap_with_key(const CryptoClass& c,
+                            uint8_t*           out,
+                            const uint8_t*     encryption_key) const
 {
     const size_t serialized_size = c.serialized_size();
     const size_t buffer_size     = kRandomIVSize + serialized_size
                                + CryptoClass::kPublicContextSize
                                + 1; // the +1 is for the mandatory type byte
-    uint8_t* buffer = static_cast<uint8_t*>(sodium_malloc(buffer_size));
-    // std::array<uint8_t, buffer_size> buffer;
+    uint8_t*     buffer = scratch_buffer(buffer_size);
+    ScratchWiper wiper{buffer, buffer_size};
 
     // put the random IV at the beggining
     random_bytes(kRandomIVSize, buffer);
@@ -223,46 +412,87 @@ std::vector<uint8_t> Wrapper::wrap(const CryptoClass& c) const
         = +kRandomIVSize + 1 + CryptoClass::kPublicContextSize;
     c.serialize(buffer + serialization_offset);
 
-    std::vector<uint8_t> out(kCiphertextExpansion + serialized_size);
-
     // copy the IV at the beggining of the output
-    memcpy(out.data(), buffer, kRandomIVSize);
+    memcpy(out, buffer, kRandomIVSize);
 
     // compute the tag and put it at the end of the ciphertext
     std::array<uint8_t, kTagSize> tag = tag_generator_.prf(buffer, buffer_size);
-    std::copy_n(tag.begin(), kTagSize, out.end() - kTagSize);
+    std::copy_n(tag.begin(), kTagSize, out + kRandomIVSize + serialized_size);
 
     // encrypt the secret part of the buffer
-    crypto_stream_chacha20_ietf_xor(out.data() + kRandomIVSize,
+    crypto_stream_chacha20_ietf_xor(out + kRandomIVSize,
                                     buffer + serialization_offset,
                                     serialized_size,
                                     tag.data(),
-                                    encryption_key_.unlock_get());
-    encryption_key_.lock();
+                                    encryption_key);
+}
 
-    sodium_free(buffer);
+template<class CryptoClass>
+CryptoClass Wrapper::unwrap(std::vector<uint8_t>& c_rep) const
+{
+    CryptoClass c = unwrap_from<CryptoClass>(c_rep.data(), c_rep.size());
+
+    // zero the entry
+    sodium_memzero(c_rep.data(), c_rep.size());
+
+    return c;
+}
+
+template<class CryptoClass>
+CryptoClass Wrapper::unwrap_from(const uint8_t* in, const size_t in_size) const
+{
+    const uint8_t* key = encryption_key_.unlock_get();
+    try {
+        CryptoClass c = unwrap_with_key<CryptoClass>(in, in_size, key);
+        encryption_key_.lock();
+        return c;
+    } catch (...) {
+        encryption_key_.lock();
+        throw;
+    }
+}
+
+template<class CryptoClass>
+std::vector<CryptoClass> Wrapper::unwrap_many(
+    const std::vector<std::vector<uint8_t>>& c_reps) const
+{
+    std::vector<CryptoClass> out;
+    out.reserve(c_reps.size());
+
+    const uint8_t* key = encryption_key_.unlock_get();
+    try {
+        for (const auto& c_rep : c_reps) {
+            out.push_back(
+                unwrap_with_key<CryptoClass>(c_rep.data(), c_rep.size(), key));
+        }
+    } catch (...) {
+        encryption_key_.lock();
+        throw;
+    }
+    encryption_key_.lock();
 
     return out;
 }
 
 template<class CryptoClass>
-CryptoClass Wrapper::unwrap(std::vector<uint8_t>& c_rep) const
+CryptoClass Wrapper::unwrap_with_key(const uint8_t* in,
+                                     const size_t   in_size,
+                                     const uint8_t* encryption_key) const
 {
-    if (c_rep.size() <= kCiphertextExpansion) {
+    if (in_size <= kCiphertextExpansion) {
         throw std::invalid_argument(
             "Wrapper::unwrap: wrapper size is too small.");
     }
 
-    const size_t data_size   = c_rep.size() - kCiphertextExpansion;
+    const size_t data_size   = in_size - kCiphertextExpansion;
     const size_t buffer_size = kRandomIVSize + data_size
                                + CryptoClass::kPublicContextSize
                                + 1; // the +1 is for the mandatory type byte
-    uint8_t* buffer = static_cast<uint8_t*>(sodium_malloc(buffer_size));
-    // std::array<uint8_t, buffer_size> buffer;
+    uint8_t*     buffer = scratch_buffer(buffer_size);
+    ScratchWiper wiper{buffer, buffer_size};
 
     // copy the IV at the beggining of the buffer
-    memcpy(buffer, c_rep.data(), kRandomIVSize);
-    // std::copy_n(c_rep.begin(), kRandomIVSize, buffer.begin());
+    memcpy(buffer, in, kRandomIVSize);
 
     // put the type byte after the IV
     buffer[kRandomIVSize] = Wrapper::TypeByte<CryptoClass>::value;
@@ -277,19 +507,17 @@ CryptoClass Wrapper::unwrap(std::vector<uint8_t>& c_rep) const
     }
     // put the expected tag in a dedicated array
     std::array<uint8_t, kTagSize> expected_tag;
-    std::copy_n(c_rep.end() - kTagSize, kTagSize, expected_tag.begin());
+    std::copy_n(in + in_size - kTagSize, kTagSize, expected_tag.begin());
 
     // decrypt the representation
     constexpr size_t serialization_offset
         = +kRandomIVSize + 1 + CryptoClass::kPublicContextSize;
 
     crypto_stream_chacha20_ietf_xor(buffer + serialization_offset,
-                                    c_rep.data() + kRandomIVSize,
+                                    in + kRandomIVSize,
                                     data_size,
                                     expected_tag.data(),
-                                    encryption_key_.unlock_get());
-    encryption_key_.lock();
-
+                                    encryption_key);
 
     // re-compute the tag
     std::array<uint8_t, kTagSize> computed_tag
@@ -319,10 +547,6 @@ CryptoClass Wrapper::unwrap(std::vector<uint8_t>& c_rep) const
         /* LCOV_EXCL_STOP */
     }
 
-    // free the buffer and zero the entry
-    sodium_free(buffer);
-    sodium_memzero(c_rep.data(), c_rep.size());
-
     return c;
 }
 
@@ -335,13 +559,22 @@ struct Wrapper::TypeByte<Cipher>
     static constexpr uint8_t value = 0x01;
 };
 
-template<uint16_t NBYTES>
+class Hash;
+template<class H, uint16_t N>
+class HMac;
+class KeyedBlake2b;
+template<uint16_t NBYTES, class PrfBase>
 class Prf;
 template<uint16_t NBYTES>
-struct Wrapper::TypeByte<Prf<NBYTES>>
+struct Wrapper::TypeByte<Prf<NBYTES, HMac<Hash, 32>>>
 {
     static constexpr uint8_t value = 0x02;
 };
+template<uint16_t NBYTES>
+struct Wrapper::TypeByte<Prf<NBYTES, KeyedBlake2b>>
+{
+    static constexpr uint8_t value = 0x08;
+};
 
 class Prg;
 template<>
@@ -0,0 +1,352 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "key_store.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <array>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sodium/utils.h>
+
+namespace sse {
+namespace crypto {
+
+static constexpr uint8_t  kStoreMagic[4]       = {'O', 'S', 'K', 'S'};
+static constexpr uint16_t kStoreVersion        = 2;
+static constexpr size_t   kStoreHeaderSize     = 16;
+static constexpr size_t   kStoreIndexEntrySize = 16;
+static constexpr size_t   kStoreTagSize        = Wrapper::kTagSize;
+
+static void store_le(uint8_t* out, const uint64_t v, const size_t n_bytes)
+{
+    for (size_t i = 0; i < n_bytes; i++) {
+        out[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+static uint64_t load_le(const uint8_t* in, const size_t n_bytes)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < n_bytes; i++) {
+        v |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return v;
+}
+
+// Writes the whole buffer, retrying after interruptions and partial writes.
+// Returns false on error.
+static bool write_all(const int fd, const uint8_t* buf, size_t len)
+{
+    while (len > 0) {
+        const ssize_t n = ::write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue; /* LCOV_EXCL_LINE */
+            }
+            return false; /* LCOV_EXCL_LINE */
+        }
+        buf += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+WrappedKeyStoreBuilder::WrappedKeyStoreBuilder(const Wrapper& wrapper)
+    : wrapper_(wrapper)
+{
+}
+
+void WrappedKeyStoreBuilder::write(const std::string& path) const
+{
+    std::vector<uint8_t> header(kStoreHeaderSize
+                                + index_.size() * kStoreIndexEntrySize);
+
+    memcpy(header.data(), kStoreMagic, sizeof(kStoreMagic));
+    store_le(header.data() + 4, kStoreVersion, 2);
+    store_le(header.data() + 6, 0, 2); // reserved
+    store_le(header.data() + 8, index_.size(), 8);
+
+    uint8_t* e_bytes = header.data() + kStoreHeaderSize;
+    for (const auto& e : index_) {
+        store_le(e_bytes, e.offset, 8);
+        store_le(e_bytes + 8, e.length, 4);
+        e_bytes[12] = e.type_byte;
+        e_bytes[13] = e_bytes[14] = e_bytes[15] = 0; // reserved
+        e_bytes += kStoreIndexEntrySize;
+    }
+
+    // the tag covers the header and the index
+    const std::array<uint8_t, kStoreTagSize> tag
+        = wrapper_.metadata_tag(header.data(), header.size());
+    header.insert(header.end(), tag.begin(), tag.end());
+
+    // write a temporary file, and atomically replace the destination with it
+    std::vector<char> tmp_path(path.begin(), path.end());
+    const char        suffix[] = ".XXXXXX";
+    tmp_path.insert(tmp_path.end(), suffix, suffix + sizeof(suffix));
+
+    const int fd = mkstemp(tmp_path.data());
+    if (fd == -1) {
+        throw std::runtime_error("WrappedKeyStoreBuilder::write: unable to "
+                                 "create a temporary file for "
+                                 + path + ": " + strerror(errno));
+    }
+
+    int err = 0;
+    if (!write_all(fd, header.data(), header.size())
+        || !write_all(fd, data_.data(), data_.size()) || fsync(fd) != 0) {
+        err = errno; /* LCOV_EXCL_LINE */
+    }
+    if (close(fd) != 0 && err == 0) {
+        err = errno; /* LCOV_EXCL_LINE */
+    }
+    if (err == 0 && rename(tmp_path.data(), path.c_str()) != 0) {
+        err = errno;
+    }
+
+    if (err != 0) {
+        unlink(tmp_path.data());
+        throw std::runtime_error("WrappedKeyStoreBuilder::write: unable to "
+                                 "write the store to "
+                                 + path + ": " + strerror(err));
+    }
+}
+
+constexpr size_t WrappedKeyStore::kDefaultCacheCapacity;
+
+class WrappedKeyStore::Cache
+{
+public:
+    explicit Cache(const size_t cap) : capacity(cap)
+    {
+    }
+
+    struct Entry
+    {
+        size_t                index;
+        const void*           class_id;
+        std::shared_ptr<void> object;
+    };
+
+    const size_t     capacity;
+    std::mutex       mtx;
+    std::list<Entry> lru; // most recently released first
+    std::unordered_multimap<size_t, std::list<Entry>::iterator> by_index;
+};
+
+WrappedKeyStore::WrappedKeyStore(const std::string& path,
+                                 const Wrapper&     wrapper,
+                                 size_t             cache_capacity)
+    : wrapper_(wrapper), cache_(std::make_shared<Cache>(cache_capacity))
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("WrappedKeyStore: unable to open " + path
+                                 + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        /* LCOV_EXCL_START */
+        const int err = errno;
+        close(fd);
+        throw std::runtime_error("WrappedKeyStore: unable to stat " + path
+                                 + ": " + strerror(err));
+        /* LCOV_EXCL_STOP */
+    }
+    mapping_size_ = static_cast<size_t>(st.st_size);
+
+    if (mapping_size_ < kStoreHeaderSize) {
+        close(fd);
+        throw std::invalid_argument(
+            "WrappedKeyStore: the file is too small to be a key store.");
+    }
+
+    void* mapping
+        = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the file is closed
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        /* LCOV_EXCL_START */
+        throw std::runtime_error("WrappedKeyStore: unable to map " + path
+                                 + ": " + strerror(errno));
+        /* LCOV_EXCL_STOP */
+    }
+    mapping_ = static_cast<const uint8_t*>(mapping);
+
+    try {
+        if (memcmp(mapping_, kStoreMagic, sizeof(kStoreMagic)) != 0) {
+            throw std::invalid_argument(
+                "WrappedKeyStore: invalid magic number.");
+        }
+        if (load_le(mapping_ + 4, 2) != kStoreVersion) {
+            throw std::invalid_argument(
+                "WrappedKeyStore: unsupported store version.");
+        }
+
+        const uint64_t n_entries = load_le(mapping_ + 8, 8);
+        if (mapping_size_ < kStoreHeaderSize + kStoreTagSize
+            || n_entries > (mapping_size_ - kStoreHeaderSize - kStoreTagSize)
+                               / kStoreIndexEntrySize) {
+            throw std::invalid_argument(
+                "WrappedKeyStore: the index does not fit in the file.");
+        }
+
+        const size_t index_end
+            = kStoreHeaderSize + n_entries * kStoreIndexEntrySize;
+
+        const std::array<uint8_t, kStoreTagSize> tag
+            = wrapper_.metadata_tag(mapping_, index_end);
+        if (sodium_memcmp(tag.data(), mapping_ + index_end, kStoreTagSize)
+            != 0) {
+            throw std::runtime_error(
+                "WrappedKeyStore: the index was not written with this "
+                "wrapper, or was modified.");
+        }
+
+        data_      = mapping_ + index_end + kStoreTagSize;
+        data_size_ = mapping_size_ - index_end - kStoreTagSize;
+
+        // only the index is read: the objects are unwrapped on demand
+        index_.reserve(n_entries);
+        const uint8_t* e_bytes = mapping_ + kStoreHeaderSize;
+        for (uint64_t i = 0; i < n_entries; i++) {
+            IndexEntry e;
+            e.offset    = load_le(e_bytes, 8);
+            e.length    = static_cast<uint32_t>(load_le(e_bytes + 8, 4));
+            e.type_byte = e_bytes[12];
+
+            if (e.offset > data_size_ || e.length > data_size_ - e.offset) {
+                throw std::invalid_argument("WrappedKeyStore: entry "
+                                            + std::to_string(i)
+                                            + " is out of the file.");
+            }
+            index_.push_back(e);
+            e_bytes += kStoreIndexEntrySize;
+        }
+    } catch (...) {
+        munmap(const_cast<uint8_t*>(mapping_), mapping_size_);
+        throw;
+    }
+}
+
+WrappedKeyStore::~WrappedKeyStore()
+{
+    munmap(const_cast<uint8_t*>(mapping_), mapping_size_);
+}
+
+size_t WrappedKeyStore::cached_count() const
+{
+    std::lock_guard<std::mutex> lock(cache_->mtx);
+    return cache_->lru.size();
+}
+
+const uint8_t* WrappedKeyStore::entry(const size_t index,
+                                      const uint8_t type_byte,
+                                      size_t&       length) const
+{
+    if (index >= index_.size()) {
+        throw std::out_of_range("WrappedKeyStore: index out of range.");
+    }
+
+    const IndexEntry& e = index_[index];
+    if (e.type_byte != type_byte) {
+        throw std::invalid_argument(
+            "WrappedKeyStore: the object has a different type.");
+    }
+    length = e.length;
+    return data_ + e.offset;
+}
+
+std::shared_ptr<void> WrappedKeyStore::cache_acquire(
+    const size_t index,
+    const void*  class_id) const
+{
+    std::lock_guard<std::mutex> lock(cache_->mtx);
+
+    auto it = cache_->by_index.find(index);
+    if (it == cache_->by_index.end()) {
+        return nullptr;
+    }
+    Cache::Entry& e = *it->second;
+    if (e.class_id != class_id) {
+        throw std::invalid_argument(
+            "WrappedKeyStore: the object has a different type.");
+    }
+
+    std::shared_ptr<void> obj = std::move(e.object);
+    cache_->lru.erase(it->second);
+    cache_->by_index.erase(it);
+    return obj;
+}
+
+void WrappedKeyStore::cache_release(const std::weak_ptr<Cache>& cache,
+                                    const size_t                index,
+                                    const void*                 class_id,
+                                    std::shared_ptr<void>       obj) noexcept
+{
+    std::shared_ptr<Cache> c = cache.lock();
+    if (!c || c->capacity == 0) {
+        // the store is gone or does not keep objects: destroy obj
+        return;
+    }
+
+    // the evicted object is destroyed once the lock is released
+    std::shared_ptr<void> evicted;
+
+    std::lock_guard<std::mutex> lock(c->mtx);
+
+    try {
+        if (c->lru.size() >= c->capacity) {
+            // evict the least recently released object
+            auto victim = std::prev(c->lru.end());
+            auto range  = c->by_index.equal_range(victim->index);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == victim) {
+                    c->by_index.erase(it);
+                    break;
+                }
+            }
+            evicted = std::move(victim->object);
+            c->lru.erase(victim);
+        }
+
+        c->lru.push_front(Cache::Entry{index, class_id, std::move(obj)});
+        c->by_index.emplace(index, c->lru.begin());
+    } catch (...) {
+        /* LCOV_EXCL_START */
+        // out of memory: simply destroy obj
+    }
+    /* LCOV_EXCL_STOP */
+}
+
+} // namespace crypto
+} // namespace sse
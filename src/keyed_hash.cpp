@@ -0,0 +1,84 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "keyed_hash.hpp"
+
+#include <cstring>
+
+#include <array>
+#include <stdexcept>
+
+#include <sodium/crypto_generichash_blake2b.h>
+#include <sodium/utils.h>
+
+namespace sse {
+
+namespace crypto {
+
+static_assert(KeyedBlake2b::kKeySize >= crypto_generichash_blake2b_KEYBYTES_MIN
+                  && KeyedBlake2b::kKeySize
+                         <= crypto_generichash_blake2b_KEYBYTES_MAX,
+              "Invalid Blake2b key size");
+static_assert(KeyedBlake2b::kDigestSize == crypto_generichash_blake2b_BYTES_MAX,
+              "Invalid Blake2b digest size");
+
+constexpr uint16_t KeyedBlake2b::kKeySize;
+constexpr uint8_t  KeyedBlake2b::kDigestSize;
+
+KeyedBlake2b::KeyedBlake2b(Key<kKeySize>&& key) : key_(std::move(key))
+{
+    if (key_.is_empty()) {
+        throw std::invalid_argument("Invalid key: key is empty");
+    }
+}
+
+void KeyedBlake2b::evaluate(const unsigned char* in,
+                            const size_t         length,
+                            unsigned char*       out,
+                            const size_t         out_len) const
+{
+    if (out_len > kDigestSize) {
+        throw std::invalid_argument(
+            "Invalid output length: out_len > kDigestSize");
+    }
+
+    if (in == nullptr) {
+        throw std::invalid_argument("in is NULL");
+    }
+
+    if (out == nullptr) {
+        throw std::invalid_argument("out is NULL");
+    }
+
+    // The digest length is a parameter of Blake2b: always compute the full
+    // digest, so that truncated outputs are prefixes of the full output
+    std::array<unsigned char, kDigestSize> digest;
+
+    key_.unlock();
+    crypto_generichash_blake2b(
+        digest.data(), kDigestSize, in, length, key_.data(), kKeySize);
+    key_.lock();
+
+    memcpy(out, digest.data(), out_len);
+    sodium_memzero(digest.data(), digest.size());
+}
+
+} // namespace crypto
+} // namespace sse
@@ -669,6 +669,48 @@ int mbedtls_mpi_mod_int( mbedtls_mpi_uint *r, const mbedtls_mpi *A, mbedtls_mpi_
  */
 int mbedtls_mpi_exp_mod( mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *E, const mbedtls_mpi *N, mbedtls_mpi *_RR );
 
+/**
+ * \brief          Montgomery setup: compute mm = -N^-1 mod 2^biL
+ *
+ * \param mm       Destination limb
+ * \param N        Modular MPI (must be odd)
+ */
+void mbedtls_mpi_montg_init( mbedtls_mpi_uint *mm, const mbedtls_mpi *N );
+
+/**
+ * \brief          Montgomery multiplication: A = A * B * R^-1 mod N
+ *
+ * \param A        Left-hand MPI and destination. It must be smaller than N
+ *                 and have at least N->n + 1 limbs allocated.
+ * \param B        Right-hand MPI. It must be smaller than N.
+ * \param N        Modular MPI (must be odd)
+ * \param mm       Montgomery constant, as set by mbedtls_mpi_montg_init()
+ * \param T        Temporary MPI with at least 2 * ( N->n + 1 ) limbs
+ *
+ * \return         0 if successful,
+ *                 MBEDTLS_ERR_MPI_BAD_INPUT_DATA if T is too small
+ *
+ * \note           These functions expose the Montgomery arithmetic used by
+ *                 mbedtls_mpi_exp_mod() so that a value can be kept in
+ *                 Montgomery representation across several exponentiations.
+ *                 A is put in Montgomery form by multiplying it by R^2 mod N.
+ */
+int mbedtls_mpi_montmul( mbedtls_mpi *A, const mbedtls_mpi *B, const mbedtls_mpi *N, mbedtls_mpi_uint mm,
+                         const mbedtls_mpi *T );
+
+/**
+ * \brief          Montgomery reduction: A = A * R^-1 mod N
+ *
+ * \param A        MPI to reduce, with at least N->n + 1 limbs allocated
+ * \param N        Modular MPI (must be odd)
+ * \param mm       Montgomery constant, as set by mbedtls_mpi_montg_init()
+ * \param T        Temporary MPI with at least 2 * ( N->n + 1 ) limbs
+ *
+ * \return         0 if successful,
+ *                 MBEDTLS_ERR_MPI_BAD_INPUT_DATA if T is too small
+ */
+int mbedtls_mpi_montred( mbedtls_mpi *A, const mbedtls_mpi *N, mbedtls_mpi_uint mm, const mbedtls_mpi *T );
+
 /**
  * \brief          Fill an MPI X with size bytes of random
  *
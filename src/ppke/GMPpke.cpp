@@ -5,6 +5,12 @@
 #include "util.hpp"
 
 #include <cassert>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <stdexcept>
 
 namespace sse {
 
@@ -41,13 +47,82 @@ std::string tag2string(const tag_type& tag)
 }
 
 
+void tagHMac(const tag_type& tag,
+             const uint8_t*  in,
+             const size_t    length,
+             uint8_t*        out,
+             const size_t    out_len)
+{
+    HMac<Hash, kTagSize>::hmac_raw_key(tag.data(), in, length, out, out_len);
+}
+
 bool GmppkePrivateKey::isPuncturedOnTag(const tag_type& tag) const
 {
-    return std::any_of(shares.cbegin(),
-                       shares.cend(),
-                       [&tag](const sse::crypto::GmppkePrivateKeyShare& share) {
-                           return share.sk4 == tag;
-                       });
+    return std::binary_search(sorted_tags.cbegin(), sorted_tags.cend(), tag);
+}
+
+void GmppkePrivateKey::addShare(const GmppkePrivateKeyShare& share)
+{
+    shares.push_back(share);
+    sorted_tags.insert(
+        std::upper_bound(sorted_tags.begin(), sorted_tags.end(), share.sk4),
+        share.sk4);
+}
+
+// Same as PairingGroup::hashListToZR
+static ZR hashTag(const tag_type& tag)
+{
+    return relicxx::hashToZR(relicxx::bytes_vec(tag.begin(), tag.end()));
+}
+
+GmppkeDecryptionKey::GmppkeDecryptionKey(GmppkePrivateKey key,
+                                         bool             fixed_base_tables)
+    : sk(std::move(key)), fixed_base_tables_(fixed_base_tables)
+{
+    tag_hashes.reserve(sk.shares.size());
+    if (fixed_base_tables) {
+        sk2_tables.reserve(sk.shares.size());
+        sk3_tables.reserve(sk.shares.size());
+    }
+    for (const auto& share : sk.shares) {
+        sk1_sum = sk1_sum + share.sk1;
+        tag_hashes.push_back(hashTag(share.sk4));
+
+        if (fixed_base_tables) {
+            sk2_tables.emplace_back(share.sk2);
+            sk3_tables.emplace_back(share.sk3);
+        }
+    }
+}
+
+void GmppkeDecryptionKey::addShare(const GmppkePrivateKeyShare& share)
+{
+    if (share.sk4 == Gmppke::NULLTAG) {
+        auto it = std::find_if(sk.shares.begin(),
+                               sk.shares.end(),
+                               [](const GmppkePrivateKeyShare& s) {
+                                   return s.sk4 == Gmppke::NULLTAG;
+                               });
+        if (it != sk.shares.end()) {
+            const size_t i = static_cast<size_t>(it - sk.shares.begin());
+
+            sk1_sum = (sk1_sum - it->sk1) + share.sk1;
+            *it     = share;
+            if (fixed_base_tables_) {
+                sk2_tables[i] = relicxx::G2Table(share.sk2);
+                sk3_tables[i] = relicxx::G2Table(share.sk3);
+            }
+            return;
+        }
+    }
+
+    sk.addShare(share);
+    sk1_sum = sk1_sum + share.sk1;
+    tag_hashes.push_back(hashTag(share.sk4));
+    if (fixed_base_tables_) {
+        sk2_tables.emplace_back(share.sk2);
+        sk3_tables.emplace_back(share.sk3);
+    }
 }
 
 void Gmppke::keygen(GmppkePublicKey&        pk,
@@ -59,8 +134,8 @@ void Gmppke::keygen(GmppkePublicKey&        pk,
     bpk.gG1               = group.generatorG1();
     bpk.gG2               = group.generatorG2();
     const ZR beta         = group.randomZR();
-    bpk.g2G1              = group.exp(bpk.gG1, beta);
-    bpk.g2G2              = group.exp(bpk.gG2, beta);
+    bpk.g2G1              = group.expGeneratorG1(beta);
+    bpk.g2G2              = group.expGeneratorG2(beta);
     pk.gG1                = bpk.gG1;
     pk.gG2                = bpk.gG2;
     pk.g2G1               = bpk.g2G1;
@@ -99,8 +174,8 @@ void Gmppke::keygen(const sse::crypto::Prf<kPPKEPrfOutputSize>& prf,
     bpk.gG2 = group.generatorG2();
     //    const ZR beta = group.randomZR();
     const ZR beta = group.pseudoRandomZR(prf, "param_beta");
-    bpk.g2G1      = group.exp(bpk.gG1, beta);
-    bpk.g2G2      = group.exp(bpk.gG2, beta);
+    bpk.g2G1      = group.expGeneratorG1(beta);
+    bpk.g2G2      = group.expGeneratorG2(beta);
     pk.gG1        = bpk.gG1;
     pk.gG2        = bpk.gG2;
     pk.g2G1       = bpk.g2G1;
@@ -124,7 +199,8 @@ void Gmppke::keygenPartial(const ZR&                     alpha,
                            GmppkePrivateKey&             sk,
                            const GmppkeSecretParameters& sp) const
 {
-    pk.ppkeg1 = group.exp(pk.gG2, alpha);
+    // pk.gG1 and pk.gG2 are the generators of G1 and G2
+    pk.ppkeg1 = group.expGeneratorG2(alpha);
 
     // Select a random polynomial of degree d subject to q(0)= beta. We do this
     // by selecting d+1 points. Because we don't actually  care about the
@@ -144,8 +220,8 @@ void Gmppke::keygenPartial(const ZR&                     alpha,
 
 
     polynomial_xcordinates[1] = ZR(1);
-    pk.gqofxG1[1]             = group.mul(group.exp(pk.gG1, sp.ry), pk.g2G1);
-    pk.gqofxG2[1]             = group.mul(group.exp(pk.gG2, sp.ry), pk.g2G2);
+    pk.gqofxG1[1] = group.mul(group.expGeneratorG1(sp.ry), pk.g2G1);
+    pk.gqofxG2[1] = group.mul(group.expGeneratorG2(sp.ry), pk.g2G2);
 
     assert(polynomial_xcordinates.size() == pk.gqofxG1.size());
 
@@ -156,7 +232,7 @@ void Gmppke::keygenPartial(const ZR&                     alpha,
     //    LagrangeInterpInExponent<G2>(group,0,polynomial_xcordinates,pk.gqofxG2));
 
 
-    sk.shares.push_back(skgen(sp));
+    sk.addShare(skgen(sp));
 }
 
 void Gmppke::keygenPartial(const sse::crypto::Prf<kPPKEPrfOutputSize>& prf,
@@ -165,7 +241,8 @@ void Gmppke::keygenPartial(const sse::crypto::Prf<kPPKEPrfOutputSize>& prf,
                            GmppkePrivateKey&                           sk,
                            const GmppkeSecretParameters&               sp) const
 {
-    pk.ppkeg1 = group.exp(pk.gG2, alpha);
+    // pk.gG1 and pk.gG2 are the generators of G1 and G2
+    pk.ppkeg1 = group.expGeneratorG2(alpha);
 
     // Select a random polynomial of degree d subject to q(0)= beta. We do this
     // by selecting d+1 points. Because we don't actually  care about the
@@ -187,8 +264,8 @@ void Gmppke::keygenPartial(const sse::crypto::Prf<kPPKEPrfOutputSize>& prf,
     //    const ZR ry = group.randomZR();
 
     polynomial_xcordinates[1] = ZR(1);
-    pk.gqofxG1[1]             = group.mul(group.exp(pk.gG1, sp.ry), pk.g2G1);
-    pk.gqofxG2[1]             = group.mul(group.exp(pk.gG2, sp.ry), pk.g2G2);
+    pk.gqofxG1[1] = group.mul(group.expGeneratorG1(sp.ry), pk.g2G1);
+    pk.gqofxG2[1] = group.mul(group.expGeneratorG2(sp.ry), pk.g2G2);
 
     assert(polynomial_xcordinates.size() == pk.gqofxG1.size());
 
@@ -198,7 +275,7 @@ void Gmppke::keygenPartial(const sse::crypto::Prf<kPPKEPrfOutputSize>& prf,
     //    assert(pk.g2G2 ==
     //    LagrangeInterpInExponent<G2>(group,0,polynomial_xcordinates,pk.gqofxG2));
 
-    sk.shares.push_back(skgen(prf, sp));
+    sk.addShare(skgen(prf, sp));
 }
 
 GmppkePrivateKeyShare Gmppke::skgen(const GmppkeSecretParameters& sp) const
@@ -207,12 +284,12 @@ GmppkePrivateKeyShare Gmppke::skgen(const GmppkeSecretParameters& sp) const
     share.sk4  = NULLTAG;
     const ZR r = group.randomZR();
     //    share.sk1 = group.exp(pk.g2G2, group.add(r,alpha));
-    share.sk1 = group.exp(group.generatorG2(), sp.beta * (r + sp.alpha));
+    share.sk1 = group.expGeneratorG2(sp.beta * (r + sp.alpha));
 
     const ZR h = group.hashListToZR(NULLTAG);
 
-    share.sk3 = group.exp(group.generatorG2(), r);           // g^r
-    share.sk2 = group.exp(share.sk3, sp.beta + (h * sp.ry)); // v(t0)^r
+    share.sk3 = group.expGeneratorG2(r);                         // g^r
+    share.sk2 = group.expGeneratorG2(r * (sp.beta + (h * sp.ry))); // v(t0)^r
 
     return share;
 }
@@ -226,12 +303,12 @@ GmppkePrivateKeyShare Gmppke::skgen(
     //    const ZR r = group.randomZR();
     const ZR r = group.pseudoRandomZR(prf, "param_r");
     //    share.sk1 = group.exp(pk.g2G2, group.add(r,alpha));
-    share.sk1 = group.exp(group.generatorG2(), sp.beta * (r + sp.alpha));
+    share.sk1 = group.expGeneratorG2(sp.beta * (r + sp.alpha));
 
     const ZR h = group.hashListToZR(NULLTAG);
 
-    share.sk3 = group.exp(group.generatorG2(), r);           // g^r
-    share.sk2 = group.exp(share.sk3, sp.beta + (h * sp.ry)); // v(t0)^r
+    share.sk3 = group.expGeneratorG2(r);                         // g^r
+    share.sk2 = group.expGeneratorG2(r * (sp.beta + (h * sp.ry))); // v(t0)^r
 
     return share;
 }
@@ -251,10 +328,10 @@ GmppkePrivateKeyShare Gmppke::sk0Gen(
         // this is the initial first key share, we have to act a bit differently
 
         const ZR r = group.pseudoRandomZR(prf, "param_rho_0");
-        sk_0.sk1   = group.exp(group.generatorG2(), sp.beta * (r + sp.alpha));
+        sk_0.sk1   = group.expGeneratorG2(sp.beta * (r + sp.alpha));
 
-        sk_0.sk3 = group.exp(group.generatorG2(), r);          // g^r
-        sk_0.sk2 = group.exp(sk_0.sk3, sp.beta + (h * sp.ry)); // v(t0)^r
+        sk_0.sk3 = group.expGeneratorG2(r);                         // g^r
+        sk_0.sk2 = group.expGeneratorG2(r * (sp.beta + (h * sp.ry))); // v(t0)^r
 
 
     } else {
@@ -267,10 +344,10 @@ GmppkePrivateKeyShare Gmppke::sk0Gen(
 
         //        const ZR l_d_1 = (d > 1) ? (group.pseudoRandomZR(prf,
         //        std::string("param_l_%d",d-1))) : (-sp.alpha);
-        auto g   = group.generatorG2();
-        sk_0.sk1 = group.exp(g, sp.beta * (rho_d - l_d));
-        sk_0.sk3 = group.exp(g, rho_d);                        // g^r
-        sk_0.sk2 = group.exp(sk_0.sk3, sp.beta + (h * sp.ry)); // v(t0)^r
+        sk_0.sk1 = group.expGeneratorG2(sp.beta * (rho_d - l_d));
+        sk_0.sk3 = group.expGeneratorG2(rho_d); // g^r
+        sk_0.sk2
+            = group.expGeneratorG2(rho_d * (sp.beta + (h * sp.ry))); // v(t0)^r
     }
 
     sk_0.sk4 = NULLTAG;
@@ -298,9 +375,9 @@ GmppkePrivateKeyShare Gmppke::skShareGen(
               ? (group.pseudoRandomZR(prf, "param_l_" + std::to_string(d - 1)))
               : (-sp.alpha);
 
-    share.sk1 = group.exp(group.generatorG2(), sp.beta * (l_d - l_d_1 + r1));
-    share.sk3 = group.exp(group.generatorG2(), r1);          // g^r
-    share.sk2 = group.exp(share.sk3, sp.beta + (h * sp.ry)); // v(t0)^r
+    share.sk1 = group.expGeneratorG2(sp.beta * (l_d - l_d_1 + r1));
+    share.sk3 = group.expGeneratorG2(r1);                         // g^r
+    share.sk2 = group.expGeneratorG2(r1 * (sp.beta + (h * sp.ry))); // v(t)^r
 
 
     share.sk4 = tag;
@@ -341,7 +418,7 @@ void Gmppke::puncture(const GmppkePublicKey& pk,
     skentryn.sk3   = group.exp(pk.gG2, r1); // G^ r1
     skentryn.sk4   = tag;
 
-    sk.shares.push_back(skentryn);
+    sk.addShare(skentryn);
 }
 
 PartialGmmppkeCT Gmppke::blind(const GmppkePublicKey& pk,
@@ -354,9 +431,17 @@ PartialGmmppkeCT Gmppke::blind(const GmppkePublicKey& pk,
     }
 
     PartialGmmppkeCT ct;
-    ct.ct2  = group.exp(pk.gG1, s);
-    G1 vofx = vx(pk.gqofxG1, tag);
-    ct.ct3  = group.exp(vofx, s);
+    // pk.gG1 is always the generator of G1
+    ct.ct2 = group.expGeneratorG1(s);
+
+    // ct3 = V(tag)^s, where V is interpolated from the points gqofxG1 (at
+    // x = 0 and x = 1): put s in the exponents of the interpolation instead
+    // of exponentiating V(tag). With these x-coordinates, the Lagrange
+    // coefficients at h are w0 = 1 - h and w1 = h.
+    const ZR h  = group.hashListToZR(tag);
+    const ZR w0 = group.sub(ZR(1), h);
+    ct.ct3      = group.mul(group.exp(pk.gqofxG1[0], s * w0),
+                       group.exp(pk.gqofxG1[1], s * h));
 
     ct.tag = tag;
     return ct;
@@ -372,60 +457,125 @@ PartialGmmppkeCT Gmppke::blind(const GmppkeSecretParameters& sp,
     }
 
     PartialGmmppkeCT ct;
-    ct.ct2 = group.exp(group.generatorG1(), s);
+    ct.ct2 = group.expGeneratorG1(s);
 
     ZR h = group.hashListToZR(tag);
-    G1 g = group.generatorG1();
 
-    ct.ct3 = group.exp(ct.ct2, (sp.beta + (h * sp.ry)));
+    // ct3 = ct2^(beta + h * ry), computed from the generator
+    ct.ct3 = group.expGeneratorG1(s * (sp.beta + (h * sp.ry)));
 
     ct.tag = tag;
     return ct;
 }
 
 
-GT Gmppke::recoverBlind(const GmppkePrivateKey& sk,
-                        const PartialGmmppkeCT& ct) const
-{
-    static const ZR zr_zero = ZR(0);
-    ZR              ctTag   = group.hashListToZR(ct.tag);
-
-    const unsigned int numshares = static_cast<unsigned int>(sk.shares.size());
+namespace {
+std::atomic<size_t> min_shares_per_thread(Gmppke::kMinSharesPerThread);
+} // namespace
 
+size_t Gmppke::minSharesPerThread()
+{
+    return min_shares_per_thread.load(std::memory_order_relaxed);
+}
 
-    // Compute w_i coefficients for recovery
-    std::vector<GT> z(numshares);
-
+void Gmppke::setMinSharesPerThread(size_t min_shares)
+{
+    if (min_shares == 0) {
+        throw std::invalid_argument(
+            "The minimum number of shares per thread must be positive");
+    }
+    min_shares_per_thread.store(min_shares, std::memory_order_relaxed);
+}
 
+GT Gmppke::recoverBlind(const GmppkeDecryptionKey& dk,
+                        const PartialGmmppkeCT&    ct,
+                        unsigned int               n_threads) const
+{
     relicxx::relicResourceHandle h(true);
-    for (unsigned int i = 0; i < numshares; i++) {
-        const GmppkePrivateKeyShare& s0         = sk.shares.at(i);
-        ZR                           currentTag = group.hashListToZR(s0.sk4);
-
-
-        ZR w0 = LagrangeBasisCoefficients<2>(
-            group, 0, zr_zero, {{ctTag, currentTag}});
-        const ZR wstar = LagrangeBasisCoefficients<2>(
-            group, 1, zr_zero, {{ctTag, currentTag}});
-
-
-        G1 ct3prod_j;
 
-        ct3prod_j = group.mul(ct3prod_j, group.exp(ct.ct3, w0));
+    const ZR     ctTag     = group.hashListToZR(ct.tag);
+    const size_t numshares = dk.sk.shares.size();
+
+    // Handing a chunk to a worker, and adding the partial sums, has a fixed
+    // cost: do not give a thread too few shares.
+    n_threads = static_cast<unsigned int>(
+        std::min(static_cast<size_t>(worker_thread_count(n_threads)),
+                 numshares / minSharesPerThread()));
+
+    // The blinding value is the product, over the key shares, of
+    //      e(ct2, sk1) / (e(ct3^w0, sk3) * e(ct2^wstar, sk2)).
+    // By bilinearity, it is equal to
+    //      e(ct2, sum(sk1) - k2) * e(-ct3, k3)
+    // with k2 = sum(wstar * sk2) and k3 = sum(w0 * sk3) (using an additive
+    // notation in G2). This only costs two Miller loops and one final
+    // exponentiation, whatever the number of shares. sum(sk1) does not depend
+    // on the ciphertext and is precomputed, and the scalar multiplications in
+    // G2 have fixed bases, for which the key can hold precomputed tables.
+    G2 k2;
+    G2 k3;
+
+    if (n_threads <= 1) {
+        recoverBlindShares(dk, ctTag, 0, numshares, k2, k3);
+    } else {
+        // split the shares in contiguous ranges, and add the partial sums
+        std::vector<G2> partial_k2(n_threads);
+        std::vector<G2> partial_k3(n_threads);
+
+        RelicParallelChunks(
+            numshares,
+            n_threads,
+            [this, &dk, &ctTag, &partial_k2, &partial_k3](unsigned int t,
+                                                          size_t begin,
+                                                          size_t end) {
+                recoverBlindShares(
+                    dk, ctTag, begin, end, partial_k2[t], partial_k3[t]);
+            });
+
+        for (unsigned int t = 0; t < n_threads; t++) {
+            k2 = group.mul(k2, partial_k2[t]);
+            k3 = group.mul(k3, partial_k3[t]);
+        }
+    }
 
-        GT denominator
-            = group.mul(group.pair(ct3prod_j, s0.sk3),
-                        group.pair(group.exp(ct.ct2, wstar), s0.sk2));
-        GT nominator = group.pair(ct.ct2, s0.sk1);
+    return group.multiPair({ct.ct2, group.inv(ct.ct3)},
+                           {group.div(dk.sk1_sum, k2), k3});
+}
 
-        z.at(i) = group.div(nominator, denominator);
+void Gmppke::recoverBlindShares(const GmppkeDecryptionKey& dk,
+                                const ZR&                  ctTag,
+                                const size_t               begin,
+                                const size_t               end,
+                                G2&                        k2,
+                                G2&                        k3) const
+{
+    const bool use_tables = dk.hasFixedBaseTables();
+
+    // The Lagrange coefficients at 0 for the points (ctTag, currentTag) are
+    //      w0    = -currentTag / (ctTag - currentTag)
+    //      wstar =  ctTag / (ctTag - currentTag).
+    // The inverses of (ctTag - currentTag) are computed all at once.
+    std::vector<ZR> inv_diffs;
+    inv_diffs.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        inv_diffs.push_back(group.sub(ctTag, dk.tag_hashes[i]));
     }
-
-    GT zprod;
-    for (unsigned int i = 0; i < numshares; i++) {
-        zprod = group.mul(zprod, z.at(i));
+    BatchInverse(group, inv_diffs);
+
+    for (size_t i = begin; i < end; i++) {
+        const GmppkePrivateKeyShare& s0       = dk.sk.shares[i];
+        const ZR&                    inv_diff = inv_diffs[i - begin];
+
+        const ZR w0    = group.neg(group.mul(dk.tag_hashes[i], inv_diff));
+        const ZR wstar = group.mul(ctTag, inv_diff);
+
+        if (use_tables) {
+            k2 = group.mul(k2, group.exp(dk.sk2_tables[i], wstar));
+            k3 = group.mul(k3, group.exp(dk.sk3_tables[i], w0));
+        } else {
+            k2 = group.mul(k2, group.exp(s0.sk2, wstar));
+            k3 = group.mul(k3, group.exp(s0.sk3, w0));
+        }
     }
-    return zprod;
 }
 
 } // namespace crypto
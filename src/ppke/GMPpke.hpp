@@ -16,6 +16,7 @@
 #include <sse/crypto/key.hpp>
 #include <sse/crypto/prf.hpp>
 
+#include <algorithm>
 #include <array>
 #include <utility>
 
@@ -35,6 +36,16 @@ using tag_type = std::array<uint8_t, kTagSize>;
 
 std::string tag2string(const tag_type& tag);
 
+// Computes HMac<Hash, kTagSize>, keyed with the tag, of the input buffer.
+// The tag is public: it is used as a raw key (HMac::hmac_raw_key) instead of
+// being copied in a protected Key object, which saves two allocations and
+// several system calls per call.
+void tagHMac(const tag_type& tag,
+             const uint8_t*  in,
+             size_t          length,
+             uint8_t*        out,
+             size_t          out_len);
+
 class BadCiphertext : public std::invalid_argument
 {
 public:
@@ -76,6 +87,7 @@ public:
 class Gmppke;
 class PartialGmmppkeCT;
 class GmppkePrivateKey;
+class GmppkeDecryptionKey;
 class GmppkePublicKey : public baseKey
 {
 public:
@@ -104,15 +116,23 @@ class GmppkePrivateKeyShare
 public:
     static constexpr size_t kByteSize
         = 3 * relicxx::G2::kCompactByteSize + kTagSize;
+    // Size of the uncompressed encoding: it is larger, but it is parsed
+    // without computing square roots.
+    static constexpr size_t kUncompressedByteSize
+        = 3 * relicxx::G2::kByteSize + kTagSize;
 
     GmppkePrivateKeyShare() = default;
 
     explicit GmppkePrivateKeyShare(const uint8_t* bytes)
-        : sk1(bytes, true), sk2(bytes + relicxx::G2::kCompactByteSize, true),
-          sk3(bytes + 2 * relicxx::G2::kCompactByteSize, true)
+        : GmppkePrivateKeyShare(bytes, true)
     {
-        ::memcpy(
-            sk4.data(), bytes + 3 * relicxx::G2::kCompactByteSize, kTagSize);
+    }
+
+    GmppkePrivateKeyShare(const uint8_t* bytes, bool compress)
+        : sk1(bytes, compress), sk2(bytes + pointSize(compress), compress),
+          sk3(bytes + 2 * pointSize(compress), compress)
+    {
+        ::memcpy(sk4.data(), bytes + 3 * pointSize(compress), kTagSize);
     }
 
 
@@ -128,13 +148,20 @@ public:
         return !(x == y);
     }
 
-    void writeBytes(uint8_t* bytes) const
+    // Checks that the three points of the share are elements of G2. The
+    // shares read from an untrusted uncompressed encoding must be checked.
+    bool isValid(relicxx::PairingGroup& group)
     {
-        sk1.writeBytes(bytes, true); // compress
-        sk2.writeBytes(bytes + relicxx::G2::kCompactByteSize, true);
-        sk3.writeBytes(bytes + 2 * relicxx::G2::kCompactByteSize, true);
-        ::memcpy(
-            bytes + 3 * relicxx::G2::kCompactByteSize, sk4.data(), sk4.size());
+        return group.ismember(sk1) && group.ismember(sk2)
+               && group.ismember(sk3);
+    }
+
+    void writeBytes(uint8_t* bytes, bool compress = true) const
+    {
+        sk1.writeBytes(bytes, compress);
+        sk2.writeBytes(bytes + pointSize(compress), compress);
+        sk3.writeBytes(bytes + 2 * pointSize(compress), compress);
+        ::memcpy(bytes + 3 * pointSize(compress), sk4.data(), sk4.size());
     }
 
     inline const tag_type& get_tag() const
@@ -143,6 +170,12 @@ public:
     }
 
 protected:
+    static constexpr size_t pointSize(bool compress)
+    {
+        return compress ? relicxx::G2::kCompactByteSize
+                        : relicxx::G2::kByteSize;
+    }
+
     relicxx::G2 sk1;
     relicxx::G2 sk2;
     relicxx::G2 sk3;
@@ -150,6 +183,7 @@ protected:
 
     friend class Gmppke;
     friend class GmppkePrivateKey;
+    friend class GmppkeDecryptionKey;
 };
 
 class GmppkePrivateKey
@@ -161,6 +195,11 @@ public:
     explicit GmppkePrivateKey(std::vector<GmppkePrivateKeyShare> s)
         : shares(std::move(s))
     {
+        sorted_tags.reserve(shares.size());
+        for (const auto& share : shares) {
+            sorted_tags.push_back(share.sk4);
+        }
+        std::sort(sorted_tags.begin(), sorted_tags.end());
     }
 
     friend bool operator==(const GmppkePrivateKey& l, const GmppkePrivateKey& r)
@@ -178,9 +217,67 @@ public:
 
     bool isPuncturedOnTag(const tag_type& tag) const;
 
+    const std::vector<GmppkePrivateKeyShare>& keyShares() const
+    {
+        return shares;
+    }
+
 protected:
+    void addShare(const GmppkePrivateKeyShare& share);
+
     std::vector<GmppkePrivateKeyShare> shares;
 
+    // The tags of the shares, sorted for a fast isPuncturedOnTag.
+    // It must be updated with shares (use addShare).
+    std::vector<tag_type> sorted_tags;
+
+    friend class Gmppke;
+    friend class GmppkeDecryptionKey;
+};
+
+// Private key prepared for decryption: holds the ciphertext-independent
+// values used by Gmppke::recoverBlind (the sum of the sk1 elements and the
+// hashes of the tags). The fixed-base tables for the sk2 and
+// sk3 elements of every share speed up the decryptions, at the cost of
+// 2 * RLC_G2_TABLE elements of G2 per share.
+class GmppkeDecryptionKey
+{
+public:
+    explicit GmppkeDecryptionKey(GmppkePrivateKey key,
+                                 bool             fixed_base_tables = false);
+
+    const GmppkePrivateKey& privateKey() const
+    {
+        return sk;
+    }
+
+    bool isPuncturedOnTag(const tag_type& tag) const
+    {
+        return sk.isPuncturedOnTag(tag);
+    }
+
+    bool hasFixedBaseTables() const
+    {
+        return fixed_base_tables_;
+    }
+
+    // Adds a share to the key, and updates the precomputed values.
+    // A share on the NULL tag replaces the current NULL tag share (the
+    // initial share, which changes with the number of punctures). The other
+    // shares are appended to the key.
+    void addShare(const GmppkePrivateKeyShare& share);
+
+protected:
+    GmppkePrivateKey sk;
+    bool             fixed_base_tables_;
+
+    // hashes of the tags of the shares, in the same order as the shares
+    std::vector<relicxx::ZR> tag_hashes;
+
+    relicxx::G2                   sk1_sum;
+    std::vector<relicxx::G2Table> sk2_tables;
+    std::vector<relicxx::G2Table> sk3_tables;
+
     friend class Gmppke;
 };
 
@@ -294,6 +391,16 @@ public:
     static constexpr uint8_t kPRFKeySize = 32; // 256 bits
     static const tag_type    NULLTAG;
 
+    // Default minimum number of key shares per thread in a parallel
+    // decryption. It can be changed with setMinSharesPerThread, e.g. after
+    // running the PPKE_parallel_decrypt benchmark of benchmark_ppke on the
+    // target machine.
+    static constexpr size_t kMinSharesPerThread = 4;
+
+    static size_t minSharesPerThread();
+    // Throws std::invalid_argument if min_shares is 0
+    static void setMinSharesPerThread(size_t min_shares);
+
     Gmppke()  = default;
     ~Gmppke() = default;
 
@@ -323,8 +430,14 @@ public:
                            const relicxx::ZR&            s,
                            const tag_type&               tag) const;
 
-    relicxx::GT recoverBlind(const GmppkePrivateKey& sk,
-                             const PartialGmmppkeCT& ct) const;
+    // The key shares are split between n_threads threads (0 stands for the
+    // number of hardware threads, and at most that number), with at least
+    // minSharesPerThread() shares per thread.
+    // The decryption key holds the precomputations: build it once, and reuse
+    // it for all the decryptions.
+    relicxx::GT recoverBlind(const GmppkeDecryptionKey& dk,
+                             const PartialGmmppkeCT&    ct,
+                             unsigned int               n_threads = 1) const;
 
     template<typename T>
     GmmppkeCT<T> encrypt(const GmppkePublicKey& pk,
@@ -334,20 +447,16 @@ public:
         const relicxx::ZR s  = group.randomZR();
         GmmppkeCT<T>      ct = GmmppkeCT<T>(blind(pk, s, tag));
 
-        auto arr = tag;
-
-        sse::crypto::HMac<sse::crypto::Hash, kTagSize> hkdf(
-            sse::crypto::Key<kTagSize>(arr.data()));
-
         std::array<uint8_t, 12 * RLC_FP_BYTES> gt_blind_bytes;
         group.exp(group.pair(pk.g2G1, pk.ppkeg1), s)
             .getBytes(false, gt_blind_bytes.size(), gt_blind_bytes.data());
 
         T mask;
-        hkdf.hmac(gt_blind_bytes.data(),
-                  gt_blind_bytes.size(),
-                  reinterpret_cast<uint8_t*>(&mask),
-                  sizeof(mask));
+        tagHMac(tag,
+                gt_blind_bytes.data(),
+                gt_blind_bytes.size(),
+                reinterpret_cast<uint8_t*>(&mask),
+                sizeof(mask));
 
         ct.ct1 = mask ^ M;
         return ct;
@@ -361,62 +470,60 @@ public:
         const relicxx::ZR s  = group.randomZR();
         GmmppkeCT<T>      ct = GmmppkeCT<T>(blind(sp, s, tag));
 
-        auto                                           arr = tag;
-        sse::crypto::HMac<sse::crypto::Hash, kTagSize> hkdf(
-            sse::crypto::Key<kTagSize>(arr.data()));
-
         std::array<uint8_t, 12 * RLC_FP_BYTES> gt_blind_bytes;
-        group.exp(group.generatorGT(), sp.alpha * sp.beta * s)
+        group.expGeneratorGT(sp.alpha * sp.beta * s)
             .getBytes(false, gt_blind_bytes.size(), gt_blind_bytes.data());
 
         T mask;
-        hkdf.hmac(gt_blind_bytes.data(),
-                  gt_blind_bytes.size(),
-                  reinterpret_cast<uint8_t*>(&mask),
-                  sizeof(mask));
+        tagHMac(tag,
+                gt_blind_bytes.data(),
+                gt_blind_bytes.size(),
+                reinterpret_cast<uint8_t*>(&mask),
+                sizeof(mask));
 
         ct.ct1 = mask ^ M;
         return ct;
     }
 
     template<typename T>
-    T decrypt(const GmppkePrivateKey& sk, const GmmppkeCT<T>& ct) const
+    T decrypt(const GmppkeDecryptionKey& dk, const GmmppkeCT<T>& ct) const
     {
-        if (sk.isPuncturedOnTag(ct.tag)) {
+        if (dk.isPuncturedOnTag(ct.tag)) {
             throw PuncturedCiphertext("cannot decrypt. The key is punctured on "
                                       "the following tag in the ciphertext: "
                                       + tag2string(ct.tag) + ".");
         }
-        return decrypt_unchecked(sk, ct);
+        return decrypt_unchecked(dk, ct);
     }
     template<typename T>
-    bool decrypt(const GmppkePrivateKey& sk, const GmmppkeCT<T>& ct, T& m) const
+    bool decrypt(const GmppkeDecryptionKey& dk,
+                 const GmmppkeCT<T>&        ct,
+                 T&                         m,
+                 unsigned int               n_threads = 1) const
     {
-        if (sk.isPuncturedOnTag(ct.tag)) {
+        if (dk.isPuncturedOnTag(ct.tag)) {
             return false;
         }
-        m = decrypt_unchecked(sk, ct);
+        m = decrypt_unchecked(dk, ct, n_threads);
 
         return true;
     }
 
     // For testing purposes only
     template<typename T>
-    T decrypt_unchecked(const GmppkePrivateKey& sk,
-                        const GmmppkeCT<T>&     ct) const
+    T decrypt_unchecked(const GmppkeDecryptionKey& dk,
+                        const GmmppkeCT<T>&        ct,
+                        unsigned int               n_threads = 1) const
     {
         std::vector<uint8_t> gt_blind_bytes
-            = recoverBlind(sk, ct).getBytes(false);
-
-        auto                                           arr = ct.tag;
-        sse::crypto::HMac<sse::crypto::Hash, kTagSize> hkdf(
-            sse::crypto::Key<kTagSize>(arr.data()));
+            = recoverBlind(dk, ct, n_threads).getBytes(false);
 
         T mask;
-        hkdf.hmac(gt_blind_bytes.data(),
-                  gt_blind_bytes.size(),
-                  reinterpret_cast<uint8_t*>(&mask),
-                  sizeof(mask));
+        tagHMac(ct.tag,
+                gt_blind_bytes.data(),
+                gt_blind_bytes.size(),
+                reinterpret_cast<uint8_t*>(&mask),
+                sizeof(mask));
 
         return mask ^ ct.ct1;
     }
@@ -454,6 +561,13 @@ private:
                        GmppkePrivateKey&                           sk,
                        const GmppkeSecretParameters&               sp) const;
 
+    void recoverBlindShares(const GmppkeDecryptionKey& dk,
+                            const relicxx::ZR&         ctTag,
+                            size_t                     begin,
+                            size_t                     end,
+                            relicxx::G2&               k2,
+                            relicxx::G2&               k3) const;
+
     GmppkePrivateKeyShare skgen(const GmppkeSecretParameters& sp) const;
     GmppkePrivateKeyShare skgen(const sse::crypto::Prf<kPPKEPrfOutputSize>& prf,
                                 const GmppkeSecretParameters& sp) const;
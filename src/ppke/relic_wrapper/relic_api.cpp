@@ -1,8 +1,12 @@
 #include "relic_api.h"
 
+#include "utils.hpp"
+
 #include <cassert>
 
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include <sodium/utils.h>
 
@@ -13,16 +17,52 @@ namespace relicxx {
     throw std::invalid_argument("writing to read only object");
 }
 
-void error_if_relic_not_init()
+// The wrapper uses RELIC from several threads: every thread must have its own
+// RELIC context.
+#if !defined(MULTI) || (MULTI != PTHREAD && MULTI != OPENMP)
+#error "RELIC must be configured with thread-local contexts (MULTI=PTHREAD)"
+#endif
+
+static void init_relic_core()
 {
-    if (nullptr == core_get()) {
+    const int err_code = core_init();
+    if (err_code != RLC_OK) {
+        throw std::runtime_error(
+            "ERROR cannot initialize  relic: core_init returned: "
+            + std::to_string(err_code) + ".");
+    }
+    const int err_code_2 = pc_param_set_any();
+    if (err_code_2 != RLC_OK) {
         throw std::runtime_error(
-            "\n\nERROR. relic core_get() returned null. Relic is probably not "
-            "initialized.\n ??? DID YOU INITIALIZE LIBFORWARDSEC ???\n"
-            "You need to initialize the library once per thread by grabbing an "
-            "instance of relicxx::relicResourceHandle\n"
-            "and holding it until you are done with the library/thread.\n");
+            "ERROR cannot initialize  relic: pc_param_set_any returned: "
+            + std::to_string(err_code_2) + ".");
+    }
+}
+
+// Context lazily initialized by ensure_relic_thread_context, and released
+// when its thread exits
+struct LazyThreadContext
+{
+    bool initialized{false};
+
+    ~LazyThreadContext()
+    {
+        // the context might have been released by someone else in between
+        if (initialized && nullptr != core_get()) {
+            core_clean();
+        }
+    }
+};
+
+void ensure_relic_thread_context()
+{
+    if (nullptr != core_get()) {
+        return;
     }
+
+    thread_local LazyThreadContext context;
+    init_relic_core();
+    context.initialized = true;
 }
 
 static void invertZR(ZR& c, const ZR& a, const bn_t order)
@@ -41,7 +81,7 @@ static void invertZR(ZR& c, const ZR& a, const bn_t order)
 // Begin ZR-specific classes
 ZR::ZR(int x)
 {
-    error_if_relic_not_init();
+    ensure_relic_thread_context();
     bn_inits(z);
     bn_inits(order);
     g1_get_ord(order);
@@ -56,7 +96,7 @@ ZR::ZR(int x)
 
 ZR::ZR(const std::string& str)
 {
-    error_if_relic_not_init();
+    ensure_relic_thread_context();
     bn_inits(z);
     bn_inits(order);
     g1_get_ord(order);
@@ -67,7 +107,7 @@ ZR::ZR(const std::string& str)
 
 ZR::ZR(const uint8_t* bytes, size_t len)
 {
-    error_if_relic_not_init();
+    ensure_relic_thread_context();
     bn_inits(z);
     bn_inits(order);
     g1_get_ord(order);
@@ -282,9 +322,12 @@ ZR operator&(const ZR& a, const ZR& b)
 // Begin G1-specific classes
 G1::G1(const uint8_t* bytes, bool compress)
 {
-    error_if_relic_not_init();
+    ensure_relic_thread_context();
     g1_inits(g);
     isInit = true;
+    if (compress) {
+        sse::crypto::stats::count(&sse::crypto::Statistics::decompressions);
+    }
     g1_read_bin(g, bytes, (compress) ? kCompactByteSize : kByteSize);
 }
 
@@ -316,6 +359,7 @@ G1 operator-(const G1& x)
 
 G1 power(const G1& g, const ZR& zr)
 {
+    sse::crypto::stats::count(&sse::crypto::Statistics::exponentiations);
     G1 g1;
     g1_mul(g1.g, const_cast<ep_st*>(g.g), const_cast<bn_st*>(zr.z));
     return g1;
@@ -339,6 +383,13 @@ G1 hashToG1(const bytes_vec& b)
 
 bool G1::ismember(const bn_t order) const
 {
+    // a point read from its uncompressed encoding might not even be on the
+    // curve, in which case the order check below is meaningless
+    if (g1_is_infty(const_cast<ep_st*>(g)) == 0
+        && g1_is_valid(const_cast<ep_st*>(g)) == 0) {
+        return false;
+    }
+
     bool result = false;
     g1_t r;
     g1_inits(r);
@@ -393,9 +444,12 @@ std::ostream& operator<<(std::ostream& s, const G1& g1)
 // Begin G2-specific classes
 G2::G2(const uint8_t* bytes, bool compress)
 {
-    error_if_relic_not_init();
+    ensure_relic_thread_context();
     g2_inits(g);
     isInit = true;
+    if (compress) {
+        sse::crypto::stats::count(&sse::crypto::Statistics::decompressions);
+    }
     g2_read_bin(g,
                 const_cast<uint8_t*>(bytes),
                 (compress) ? kCompactByteSize : kByteSize);
@@ -430,6 +484,7 @@ G2 operator-(const G2& x)
 
 G2 power(const G2& g, const ZR& zr)
 {
+    sse::crypto::stats::count(&sse::crypto::Statistics::exponentiations);
     G2 g2;
     RELICXX_G2unconst(g, g1);
     RELICXX_ZRunconst(zr, zr1);
@@ -437,6 +492,35 @@ G2 power(const G2& g, const ZR& zr)
     return g2;
 }
 
+G2Table::G2Table(const G2& base) : table_(new g2_t[RLC_G2_TABLE])
+{
+    for (size_t i = 0; i < RLC_G2_TABLE; i++) {
+        g2_inits(table_[i]);
+    }
+    RELICXX_G2unconst(base, base1);
+    g2_mul_pre(table_.get(), base1.g);
+}
+
+G2Table::~G2Table()
+{
+    if (table_) {
+        for (size_t i = 0; i < RLC_G2_TABLE; i++) {
+            {
+                g2_free(table_[i])
+            }
+        }
+    }
+}
+
+G2 power(const G2Table& t, const ZR& zr)
+{
+    sse::crypto::stats::count(&sse::crypto::Statistics::exponentiations);
+    G2 g2;
+    RELICXX_ZRunconst(zr, zr1);
+    g2_mul_fix(g2.g, t.table_.get(), zr1.z);
+    return g2;
+}
+
 G2 hashToG2(const bytes_vec& b)
 {
     static_assert(sizeof(HASH_FUNCTION_BYTES_TO_G2_ROM) == 1,
@@ -456,6 +540,11 @@ G2 hashToG2(const bytes_vec& b)
 
 bool G2::ismember(bn_t order)
 {
+    // see G1::ismember
+    if (g2_is_infty(g) == 0 && g2_is_valid(g) == 0) {
+        return false;
+    }
+
     bool result = false;
     g2_t r;
     g2_inits(r);
@@ -512,9 +601,12 @@ std::ostream& operator<<(std::ostream& s, const G2& g2)
 // Begin GT-specific classes
 GT::GT(const uint8_t* bytes, bool compress)
 {
-    error_if_relic_not_init();
+    ensure_relic_thread_context();
     gt_inits(g);
     isInit = true;
+    if (compress) {
+        sse::crypto::stats::count(&sse::crypto::Statistics::decompressions);
+    }
     gt_read_bin(g,
                 const_cast<uint8_t*>(bytes),
                 (compress) ? kCompactByteSize : kByteSize);
@@ -545,8 +637,115 @@ GT operator/(const GT& x, const GT& y)
     return z;
 }
 
+GTTable::GTTable(const GT& base)
+{
+    bn_t order;
+    bn_inits(order);
+    g1_get_ord(order);
+    n_windows_ = RLC_CEIL(static_cast<size_t>(bn_bits(order)), kWindowBits);
+    bn_free(order);
+
+    const size_t n = n_windows_ * kWindowSize;
+    table_.reset(new gt_t[n]);
+    for (size_t i = 0; i < n; i++) {
+        gt_inits(table_[i]);
+    }
+
+    RELICXX_GTunconst(base, base1);
+    // table_[i * kWindowSize + j - 1] = base^(j * 2^(kWindowBits * i))
+    gt_copy(table_[0], base1.g);
+    for (size_t i = 0; i < n_windows_; i++) {
+        gt_t* window = table_.get() + i * kWindowSize;
+        if (i > 0) {
+            // base^(2^(kWindowBits * i)) = base^((kWindowSize + 1) * 2^(...))
+            gt_mul(window[0], window[-1], table_[(i - 1) * kWindowSize]);
+        }
+        for (size_t j = 1; j < kWindowSize; j++) {
+            gt_mul(window[j], window[j - 1], window[0]);
+        }
+    }
+}
+
+GTTable::~GTTable()
+{
+    if (table_) {
+        for (size_t i = 0; i < n_windows_ * kWindowSize; i++) {
+            {
+                gt_free(table_[i])
+            }
+        }
+    }
+}
+
+// Copies src to dst if mask is all ones, and leaves dst untouched if mask is
+// 0, without any secret-dependent branch or memory access.
+static void gt_copy_masked(gt_t dst, const gt_t src, const dig_t mask)
+{
+    // with ALLOC = AUTO, gt_t is a plain array of digits
+    static_assert(sizeof(gt_t) % sizeof(dig_t) == 0,
+                  "gt_t must be an array of digits");
+    dig_t*       d = reinterpret_cast<dig_t*>(dst);
+    const dig_t* s = reinterpret_cast<const dig_t*>(src);
+    for (size_t i = 0; i < sizeof(gt_t) / sizeof(dig_t); i++) {
+        d[i] ^= mask & (d[i] ^ s[i]);
+    }
+}
+
+// The exponent is secret (e.g. the exponent of the message mask in Gmppke):
+// every window is processed, with a full scan of its table entries, and a
+// multiplication even for zero digits.
+GT power(const GTTable& t, const ZR& zr)
+{
+    sse::crypto::stats::count(&sse::crypto::Statistics::exponentiations);
+    GT gt;
+    RELICXX_ZRunconst(zr, zr1);
+
+    // bring the exponent in [0, order), i.e. in the range of the table
+    ZR e;
+    bn_mod(e.z, zr1.z, zr1.order);
+    if (bn_sign(e.z) == RLC_NEG) {
+        bn_add(e.z, e.z, zr1.order);
+    }
+
+    // fixed-size big-endian encoding, padded with zeros
+    const size_t max_bits = t.n_windows_ * GTTable::kWindowBits;
+    std::vector<uint8_t> bytes((max_bits + 7) / 8);
+    bn_write_bin(bytes.data(), static_cast<int>(bytes.size()), e.z);
+
+    gt_t entry;
+    gt_inits(entry);
+    for (size_t i = 0; i < t.n_windows_; i++) {
+        dig_t digit = 0;
+        for (size_t b = 0; b < GTTable::kWindowBits; b++) {
+            const size_t bit  = i * GTTable::kWindowBits + b;
+            const size_t byte = bytes.size() - 1 - bit / 8;
+            digit |= static_cast<dig_t>((bytes[byte] >> (bit % 8)) & 1) << b;
+        }
+
+        // entry = base^(digit * 2^(kWindowBits * i)), 1 if digit is 0
+        gt_set_unity(entry);
+        for (size_t j = 1; j <= GTTable::kWindowSize; j++) {
+            // all ones iff j == digit: (j ^ digit) - 1 only has its top
+            // bit set when j ^ digit is 0
+            const dig_t diff = static_cast<dig_t>(j) ^ digit;
+            const dig_t mask
+                = static_cast<dig_t>(0)
+                  - ((diff - 1) >> (8 * sizeof(dig_t) - 1));
+            gt_copy_masked(
+                entry, t.table_[i * GTTable::kWindowSize + j - 1], mask);
+        }
+        gt_mul(gt.g, gt.g, entry);
+    }
+    {
+        gt_free(entry)
+    }
+    sodium_memzero(bytes.data(), bytes.size());
+    return gt;
+}
+
 GT power(const GT& g, const ZR& zr)
 {
+    sse::crypto::stats::count(&sse::crypto::Statistics::exponentiations);
     GT gt;
     RELICXX_GTunconst(g, gg);
     RELICXX_ZRunconst(zr, zr1);
@@ -571,6 +770,7 @@ GT operator-(const GT& g)
 
 GT pairing(const G1& g1, const G2& g2)
 {
+    sse::crypto::stats::count(&sse::crypto::Statistics::pairings);
     GT gt;
     RELICXX_G1unconst(g1, g11);
     RELICXX_G2unconst(g2, g22);
@@ -580,6 +780,46 @@ GT pairing(const G1& g1, const G2& g2)
     return gt;
 }
 
+GT multiPairing(const std::vector<G1>& g1, const std::vector<G2>& g2)
+{
+    if (g1.size() != g2.size()) {
+        throw std::invalid_argument(
+            "Invalid multi-pairing input: the G1 and G2 vectors must have the "
+            "same size.");
+    }
+
+    GT gt; // unity
+    if (g1.empty()) {
+        return gt;
+    }
+    sse::crypto::stats::count(&sse::crypto::Statistics::pairings, g1.size());
+
+    // RELIC needs contiguous arrays of points
+    const size_t            m = g1.size();
+    std::unique_ptr<g1_t[]> p(new g1_t[m]);
+    std::unique_ptr<g2_t[]> q(new g2_t[m]);
+
+    for (size_t i = 0; i < m; i++) {
+        g1_inits(p[i]);
+        g1_copy(p[i], g1[i].g);
+        g2_inits(q[i]);
+        g2_copy(q[i], const_cast<G2&>(g2[i]).g);
+    }
+
+    /* compute the product of optimal ate pairings, with a single final
+     * exponentiation */
+    pp_map_sim_oatep_k12(gt.g, p.get(), q.get(), static_cast<int>(m));
+
+    for (size_t i = 0; i < m; i++) {
+        {
+            g1_free(p[i])
+        }
+        {
+            g2_free(q[i])
+        }
+    }
+    return gt;
+}
 
 bool GT::ismember(bn_t order)
 {
@@ -660,18 +900,7 @@ relicResourceHandle::relicResourceHandle(const bool allowAlreadyInitialized)
         }
         throw std::runtime_error("ERROR Relic already initialized.");
     }
-    const int err_code = core_init();
-    if (err_code != RLC_OK) {
-        throw std::runtime_error(
-            "ERROR cannot initialize  relic: core_init returned: "
-            + std::to_string(err_code) + ".");
-    }
-    const int err_code_2 = pc_param_set_any();
-    if (err_code_2 != RLC_OK) {
-        throw std::runtime_error(
-            "ERROR cannot initialize  relic: pc_param_set_any returned: "
-            + std::to_string(err_code_2) + ".");
-    }
+    init_relic_core();
     isInit = true;
 }
 relicResourceHandle::~relicResourceHandle()
@@ -686,7 +915,7 @@ bool relicResourceHandle::isInitalized() const
 }
 PairingGroup::PairingGroup()
 {
-    error_if_relic_not_init();
+    ensure_relic_thread_context();
     bn_inits(grp_order);
     g1_get_ord(grp_order);
     isInit = true; // user needs to call setCurve after construction
@@ -763,6 +992,36 @@ GT PairingGroup::generatorGT() const
     return gt;
 }
 
+G1 PairingGroup::expGeneratorG1(const ZR& r) const
+{
+    // uses the table precomputed by RELIC for the generator
+    sse::crypto::stats::count(&sse::crypto::Statistics::exponentiations);
+    G1 g1;
+    RELICXX_ZRunconst(r, r1);
+    g1_mul_gen(g1.g, r1.z);
+    return g1;
+}
+
+G2 PairingGroup::expGeneratorG2(const ZR& r) const
+{
+    // uses the table precomputed by RELIC for the generator
+    sse::crypto::stats::count(&sse::crypto::Statistics::exponentiations);
+    G2 g2;
+    RELICXX_ZRunconst(r, r1);
+    g2_mul_gen(g2.g, r1.z);
+    return g2;
+}
+
+GT PairingGroup::expGeneratorGT(const ZR& r) const
+{
+    // RELIC has no precomputation for GT: build our own table once.
+    // The generator only depends on the curve, so the table can be shared
+    // by all the threads.
+    static const GTTable table(generatorGT());
+
+    return exp(table, r);
+}
+
 ZR PairingGroup::neg(const ZR& r) const
 {
     return -r;
@@ -823,6 +1082,12 @@ G2 PairingGroup::exp(const G2& g, const int& r) const
     return power(g, ZR(r));
 }
 
+G2 PairingGroup::exp(const G2Table& t, const ZR& r) const
+{
+    // fixed-base scalar multiplication
+    return power(t, r);
+}
+
 GT PairingGroup::pair(const G1& g, const G2& h) const
 {
     return pairing(g, h);
@@ -833,6 +1098,12 @@ GT PairingGroup::pair(const G2& h, const G1& g) const
     return pairing(g, h);
 }
 
+GT PairingGroup::multiPair(const std::vector<G1>& g,
+                           const std::vector<G2>& h) const
+{
+    return multiPairing(g, h);
+}
+
 bool PairingGroup::ismember(GT& g)
 {
     return g.ismember(grp_order); // add code to check
@@ -949,6 +1220,12 @@ GT PairingGroup::exp(const GT& g, const int& r) const
     return power(g, ZR(r));
 }
 
+GT PairingGroup::exp(const GTTable& t, const ZR& r) const
+{
+    // fixed-base exponentiation
+    return power(t, r);
+}
+
 ZR PairingGroup::hashListToZR(const std::string& str) const
 {
     bytes_vec b(str.begin(), str.end());
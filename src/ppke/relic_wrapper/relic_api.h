@@ -12,6 +12,7 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <type_traits> // for static assert
@@ -100,7 +101,13 @@ public:
     }
 };
 
-void error_if_relic_not_init();
+// RELIC keeps one context per thread. Initializes the context of the calling
+// thread if it is not already initialized (by a relicResourceHandle, or by a
+// previous call). A context initialized by this function is released when
+// the thread exits.
+// Throws std::runtime_error if the initialization fails.
+void ensure_relic_thread_context();
+
 class ZR
 {
 public:
@@ -109,7 +116,7 @@ public:
     bool isInit{false};
     ZR()
     {
-        error_if_relic_not_init();
+        ensure_relic_thread_context();
         bn_inits(z);
         bn_inits(order);
         g1_get_ord(order);
@@ -122,7 +129,7 @@ public:
     ZR(const uint8_t* /*bytes*/, size_t /*len*/);
     explicit ZR(const bn_t y)
     {
-        error_if_relic_not_init();
+        ensure_relic_thread_context();
         bn_inits(z);
         bn_inits(order);
         g1_get_ord(order);
@@ -131,7 +138,7 @@ public:
     }
     ZR(const ZR& w)
     {
-        error_if_relic_not_init();
+        ensure_relic_thread_context();
         bn_inits(z);
         bn_inits(order);
         bn_copy(z, w.z);
@@ -331,7 +338,7 @@ public:
     bool isInit{false};
     G1()
     {
-        error_if_relic_not_init();
+        ensure_relic_thread_context();
         g1_inits(g);
         isInit = true;
         g1_set_infty(g);
@@ -434,7 +441,7 @@ public:
     bool isInit{false};
     G2()
     {
-        error_if_relic_not_init();
+        ensure_relic_thread_context();
         g2_inits(g);
         isInit = true;
         g2_set_infty(g);
@@ -525,6 +532,35 @@ public:
     }
 };
 
+/**
+ * Precomputation table for scalar multiplications of a fixed G2 element.
+ * A table holds RLC_G2_TABLE elements of G2: it is only worth its memory
+ * when the same element is multiplied by many scalars.
+ */
+class G2Table
+{
+public:
+    explicit G2Table(const G2& base);
+    G2Table(G2Table&& other) noexcept = default;
+    ~G2Table();
+
+    // tables are expensive: avoid implicit copies
+    G2Table(const G2Table&) = delete;
+    G2Table& operator=(const G2Table&) = delete;
+
+    // the previous table is released by the destructor of other
+    G2Table& operator=(G2Table&& other) noexcept
+    {
+        table_.swap(other.table_);
+        return *this;
+    }
+
+    friend G2 power(const G2Table& /*t*/, const ZR& /*zr*/);
+
+private:
+    std::unique_ptr<g2_t[]> table_;
+};
+
 class GT
 {
 public:
@@ -535,14 +571,14 @@ public:
     bool isInit{false};
     GT()
     {
-        error_if_relic_not_init();
+        ensure_relic_thread_context();
         gt_inits(g);
         isInit = true;
         gt_set_unity(g);
     }
     GT(const GT& x)
     {
-        error_if_relic_not_init();
+        ensure_relic_thread_context();
         gt_inits(g);
         isInit = true;
         gt_copy(g, const_cast<GT&>(x).g);
@@ -611,6 +647,8 @@ public:
 
     friend GT            pairing(const G1&, const G1&);
     friend GT            pairing(const G1& /*g1*/, const G2& /*g2*/);
+    friend GT            multiPairing(const std::vector<G1>& /*g1*/,
+                                      const std::vector<G2>& /*g2*/);
     friend GT            power(const GT& /*g*/, const ZR& /*zr*/);
     friend GT            operator-(const GT& /*g*/);
     friend GT            operator/(const GT& /*x*/, const GT& /*y*/);
@@ -626,6 +664,35 @@ public:
     }
 };
 
+/**
+ * Precomputation table for exponentiations of a fixed GT element, using a
+ * fixed window of kWindowBits bits: the table holds base^(j * 2^(w * i)) for
+ * every window i and every non-zero digit j. An exponentiation then only
+ * costs one multiplication per window, and no squaring. The table of a 254
+ * bits group uses about 360kB.
+ */
+class GTTable
+{
+public:
+    static constexpr size_t kWindowBits = 4;
+    static constexpr size_t kWindowSize = (1UL << kWindowBits) - 1;
+
+    explicit GTTable(const GT& base);
+    GTTable(GTTable&& other) noexcept = default;
+    ~GTTable();
+
+    // tables are expensive: avoid implicit copies
+    GTTable(const GTTable&) = delete;
+    GTTable& operator=(const GTTable&) = delete;
+    GTTable& operator=(GTTable&&) = delete;
+
+    friend GT power(const GTTable& /*t*/, const ZR& /*zr*/);
+
+private:
+    size_t                  n_windows_{0};
+    std::unique_ptr<gt_t[]> table_;
+};
+
 class relicResourceHandle
 {
 public:
@@ -674,6 +741,11 @@ public:
     G2 generatorG2() const;
     GT generatorGT() const;
 
+    // Fixed-base exponentiations of the generators, using precomputed tables
+    G1 expGeneratorG1(const ZR& r) const;
+    G2 expGeneratorG2(const ZR& r) const;
+    GT expGeneratorGT(const ZR& r) const;
+
 
     bool ismember(ZR& /*zr*/);
     bool ismember(G1& /*g*/);
@@ -686,8 +758,20 @@ public:
     G2 div(const G2& /*g*/, const G2& /*h*/) const;
     G2 exp(const G2& /*g*/, const ZR& /*r*/) const;
     G2 exp(const G2& /*g*/, const int& /*r*/) const;
+    G2 exp(const G2Table& /*t*/, const ZR& /*r*/) const;
     GT pair(const G1& /*g*/, const G2& /*h*/) const;
     GT pair(const G2& /*h*/, const G1& /*g*/) const;
+
+    /**
+     * Computes the product of the pairings e(g[i], h[i]).
+     * The Miller loops are computed simultaneously, and the final
+     * exponentiation is only done once. Divisions by a pairing should be
+     * expressed as multiplications by the pairing of the negated G1 point.
+     *
+     * @exception std::invalid_argument g and h have different sizes
+     */
+    GT multiPair(const std::vector<G1>& g, const std::vector<G2>& h) const;
+
     ZR order() const; // returns the order of the group
 
     ZR hashListToZR(const std::string& str) const;
@@ -721,6 +805,7 @@ public:
     G1 exp(const G1& /*g*/, const int& /*r*/) const;
     GT exp(const GT& /*g*/, const ZR& /*r*/) const;
     GT exp(const GT& /*g*/, const int& /*r*/) const;
+    GT exp(const GTTable& /*t*/, const ZR& /*r*/) const;
 
     ZR  add(const ZR& /*g*/, const ZR& /*h*/) const;
     int add(const int& /*g*/, const int& /*h*/) const;
@@ -1 +1,40 @@
 #include "util.hpp"
+
+namespace sse {
+
+namespace crypto {
+
+void BatchInverse(const relicxx::PairingGroup& group,
+                  std::vector<relicxx::ZR>&    values)
+{
+    if (values.empty()) {
+        return;
+    }
+
+    // prefix[i] = values[0] * ... * values[i]
+    std::vector<relicxx::ZR> prefix(values.size());
+    prefix[0] = values[0];
+    for (size_t i = 1; i < values.size(); i++) {
+        prefix[i] = group.mul(prefix[i - 1], values[i]);
+    }
+
+    relicxx::ZR inv_prod;
+    try {
+        inv_prod = group.div(1, prefix.back());
+    } catch (const relicxx::RelicDividByZero& /*t*/) {
+        throw std::logic_error("BatchInverse failed. RelicDividByZero"
+                               " Almost certainly a duplicate "
+                               "x-coordinate.");
+    }
+
+    // walk back: inv_prod is the inverse of values[0] * ... * values[i]
+    for (size_t i = values.size() - 1; i > 0; i--) {
+        relicxx::ZR inv_i = group.mul(inv_prod, prefix[i - 1]);
+        inv_prod          = group.mul(inv_prod, values[i]);
+        values[i]         = inv_i;
+    }
+    values[0] = inv_prod;
+}
+
+} // namespace crypto
+} // namespace sse
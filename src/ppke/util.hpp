@@ -1,6 +1,7 @@
 #ifndef SRC_UTIL_H_
 #define SRC_UTIL_H_
 #include "relic_wrapper/relic_api.h"
+#include "thread_pool.hpp"
 
 #include <array>
 #include <vector>
@@ -44,6 +45,13 @@ relicxx::ZR LagrangeInterp(
     const std::vector<relicxx::ZR>& polynomial_xcordinates,
     const std::vector<relicxx::ZR>& polynomial_ycordinates);
 
+/// Replaces every element of values by its inverse, using Montgomery's
+/// trick: a single inversion, and 3 multiplications per element.
+/// Throws std::logic_error if one of the elements is zero (in which case
+/// values is left unchanged).
+void BatchInverse(const relicxx::PairingGroup& group,
+                  std::vector<relicxx::ZR>&    values);
+
 template<class type, size_t N>
 type LagrangeInterpInExponent(
     const relicxx::PairingGroup&      group,
@@ -61,6 +69,21 @@ type LagrangeInterpInExponent(
     }
     return prod;
 }
+
+/// Splits [0, n) in n_threads contiguous chunks and calls f(t, begin, end) on
+/// the t-th chunk, in parallel (see parallel_chunks). Every chunk runs in a
+/// thread holding a RELIC context: the worker threads keep theirs from one
+/// call to the next.
+template<class F>
+void RelicParallelChunks(const size_t n, unsigned int n_threads, F f)
+{
+    parallel_chunks(
+        n, n_threads, [&f](unsigned int t, size_t begin, size_t end) {
+            relicxx::ensure_relic_thread_context();
+            f(t, begin, end);
+        });
+}
+
 } // namespace crypto
 } // namespace sse
 #endif /* SRC_UTIL_H_ */
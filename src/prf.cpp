@@ -54,6 +54,9 @@ template Key<1024> Prf<1024>::derive_key(
     const std::array<uint8_t, 200>& in) const;
 
 template class Prf<2000>;
+
+template class Prf<32, KeyedBlake2b>;
+template class Prf<128, KeyedBlake2b>;
 } // namespace crypto
 } // namespace sse
 #endif
@@ -20,6 +20,7 @@
 
 
 #include "prg.hpp"
+#include "utils.hpp"
 
 #include <cassert>
 #include <cstring>
@@ -60,6 +61,8 @@ static void prg_derivation(const unsigned char* key,
 
     const size_t block_len = max_block_index - block_offset;
 
+    stats::count(&Statistics::prg_blocks, block_len);
+
     memset(out, 0, len);
 
     if (offset % CHACHA20_BLOCK_SIZE == 0) {
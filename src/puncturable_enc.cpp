@@ -21,7 +21,11 @@
 #include "puncturable_enc.hpp"
 
 #include "ppke/GMPpke.hpp"
+#include "ppke/util.hpp"
 #include "prf.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
 
 namespace sse {
 
@@ -41,7 +45,10 @@ public:
 
     punct::ciphertext_type encrypt(const uint64_t         m,
                                    const punct::tag_type& tag);
-    punct::key_share_type  initial_keyshare(const size_t d);
+    std::vector<punct::ciphertext_type> encrypt_batch(
+        const std::vector<std::pair<uint64_t, punct::tag_type>>& messages,
+        unsigned int                                             n_threads);
+    punct::key_share_type initial_keyshare(const size_t d);
     punct::key_share_type  inc_puncture(const size_t           d,
                                         const punct::tag_type& tag);
 
@@ -75,6 +82,43 @@ punct::ciphertext_type PuncturableEncryption::PEncImpl::encrypt(
     return ct_bytes;
 }
 
+std::vector<punct::ciphertext_type> PuncturableEncryption::PEncImpl::
+    encrypt_batch(
+        const std::vector<std::pair<uint64_t, punct::tag_type>>& messages,
+        unsigned int                                             n_threads)
+{
+    // check the tags before doing any work
+    for (const auto& m : messages) {
+        if (m.second == Gmppke::NULLTAG) {
+            throw std::invalid_argument(
+                "Invalid tag: the NULLTAG is reserved and cannot be used.");
+        }
+    }
+
+    std::vector<punct::ciphertext_type> cts(messages.size());
+
+    auto encrypt_range = [this, &messages, &cts](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            cts[i] = encrypt(messages[i].first, messages[i].second);
+        }
+    };
+
+    n_threads = worker_thread_count(n_threads);
+
+    if (n_threads <= 1 || messages.size() <= 1) {
+        // hold the RELIC context for the whole batch
+        relicxx::relicResourceHandle handle(true);
+        encrypt_range(0, messages.size());
+    } else {
+        RelicParallelChunks(
+            messages.size(),
+            n_threads,
+            [&encrypt_range](unsigned int /*t*/, size_t begin, size_t end) {
+                encrypt_range(begin, end);
+            });
+    }
+    return cts;
+}
 
 punct::key_share_type PuncturableEncryption::PEncImpl::inc_puncture(
     const size_t           d,
@@ -111,9 +155,18 @@ punct::ciphertext_type PuncturableEncryption::encrypt(
     const uint64_t         m,
     const punct::tag_type& tag)
 {
+    TraceSpan span("PuncturableEncryption::encrypt");
     return penc_imp_->encrypt(m, tag);
 }
 
+std::vector<punct::ciphertext_type> PuncturableEncryption::encrypt_batch(
+    const std::vector<std::pair<uint64_t, punct::tag_type>>& messages,
+    unsigned int                                             n_threads)
+{
+    TraceSpan span("PuncturableEncryption::encrypt_batch");
+    return penc_imp_->encrypt_batch(messages, n_threads);
+}
+
 punct::key_share_type PuncturableEncryption::initial_keyshare(const size_t d)
 {
     return penc_imp_->initial_keyshare(d);
@@ -123,6 +176,7 @@ punct::key_share_type PuncturableEncryption::inc_puncture(
     const size_t           d,
     const punct::tag_type& tag)
 {
+    TraceSpan span("PuncturableEncryption::inc_puncture");
     return penc_imp_->inc_puncture(d, tag);
 }
 
@@ -130,18 +184,51 @@ punct::key_share_type PuncturableEncryption::inc_puncture(
 class PuncturableDecryption::PDecImpl
 {
 public:
-    explicit PDecImpl(const punct::punctured_key_type& punctured_key);
-
-    bool is_punctured_on_tag(const punct::tag_type& tag);
-    bool decrypt(const punct::ciphertext_type& ct_bytes, uint64_t& m) const;
+    PDecImpl(const punct::punctured_key_type& punctured_key,
+             bool                             fixed_base_tables);
+    PDecImpl(const std::vector<uint8_t>& snapshot, bool fixed_base_tables);
+
+    bool is_punctured_on_tag(const punct::tag_type& tag) const;
+    void add_share(const punct::key_share_type& share);
+    std::vector<uint8_t> snapshot() const;
+    bool decrypt(const punct::ciphertext_type& ct_bytes,
+                 uint64_t&                     m,
+                 unsigned int                  n_threads) const;
+    std::vector<bool> decrypt_batch(
+        const std::vector<punct::ciphertext_type>& cts,
+        std::vector<uint64_t>&                     ms,
+        unsigned int                               n_threads) const;
 
 private:
+    static GmppkePrivateKey parse_key(
+        const punct::punctured_key_type& punctured_key);
+    static GmppkePrivateKey parse_snapshot(
+        const std::vector<uint8_t>& snapshot);
+
+    // The snapshot starts with the number of keyshares, on 8 bytes (little
+    // endian), followed by the uncompressed keyshares
+    static constexpr size_t kSnapshotHeaderSize = sizeof(uint64_t);
+
     const Gmppke ppke_{};
 
-    GmppkePrivateKey sk_;
+    GmppkeDecryptionKey dk_;
 };
 
 PuncturableDecryption::PDecImpl::PDecImpl(
+    const punct::punctured_key_type& punctured_key,
+    bool                             fixed_base_tables)
+    : dk_(parse_key(punctured_key), fixed_base_tables)
+{
+}
+
+PuncturableDecryption::PDecImpl::PDecImpl(
+    const std::vector<uint8_t>& snapshot,
+    bool                        fixed_base_tables)
+    : dk_(parse_snapshot(snapshot), fixed_base_tables)
+{
+}
+
+GmppkePrivateKey PuncturableDecryption::PDecImpl::parse_key(
     const punct::punctured_key_type& punctured_key)
 {
     std::vector<GmppkePrivateKeyShare> shares(punctured_key.size());
@@ -149,20 +236,139 @@ PuncturableDecryption::PDecImpl::PDecImpl(
         shares[i] = GmppkePrivateKeyShare(punctured_key[i].data());
     }
 
-    sk_ = GmppkePrivateKey(shares);
+    return GmppkePrivateKey(std::move(shares));
+}
+
+GmppkePrivateKey PuncturableDecryption::PDecImpl::parse_snapshot(
+    const std::vector<uint8_t>& snapshot)
+{
+    constexpr size_t kShareSize
+        = GmppkePrivateKeyShare::kUncompressedByteSize;
+
+    if (snapshot.size() < kSnapshotHeaderSize) {
+        throw std::invalid_argument(
+            "Invalid snapshot: the snapshot is too small.");
+    }
+
+    uint64_t n_shares = 0;
+    for (size_t i = 0; i < kSnapshotHeaderSize; i++) {
+        n_shares |= static_cast<uint64_t>(snapshot[i]) << (8 * i);
+    }
+
+    if (n_shares == 0
+        || n_shares != (snapshot.size() - kSnapshotHeaderSize) / kShareSize
+        || (snapshot.size() - kSnapshotHeaderSize) % kShareSize != 0) {
+        throw std::invalid_argument(
+            "Invalid snapshot: the snapshot size does not match the number "
+            "of keyshares.");
+    }
+
+    // the points are not compressed: nothing guarantees that they are
+    // elements of G2 until they are checked
+    relicxx::PairingGroup group;
+
+    std::vector<GmppkePrivateKeyShare> shares(n_shares);
+    const uint8_t* bytes = snapshot.data() + kSnapshotHeaderSize;
+    for (size_t i = 0; i < n_shares; i++, bytes += kShareSize) {
+        shares[i] = GmppkePrivateKeyShare(bytes, false);
+        if (!shares[i].isValid(group)) {
+            throw std::invalid_argument(
+                "Invalid snapshot: a keyshare is not a valid group element.");
+        }
+    }
+
+    return GmppkePrivateKey(std::move(shares));
+}
+
+bool PuncturableDecryption::PDecImpl::is_punctured_on_tag(
+    const punct::tag_type& tag) const
+{
+    return dk_.isPuncturedOnTag(tag);
+}
+
+void PuncturableDecryption::PDecImpl::add_share(
+    const punct::key_share_type& share)
+{
+    dk_.addShare(GmppkePrivateKeyShare(share.data()));
+}
+
+std::vector<uint8_t> PuncturableDecryption::PDecImpl::snapshot() const
+{
+    constexpr size_t kShareSize
+        = GmppkePrivateKeyShare::kUncompressedByteSize;
+
+    const std::vector<GmppkePrivateKeyShare>& shares
+        = dk_.privateKey().keyShares();
+
+    std::vector<uint8_t> out(kSnapshotHeaderSize + shares.size() * kShareSize);
+
+    const uint64_t n_shares = shares.size();
+    for (size_t i = 0; i < kSnapshotHeaderSize; i++) {
+        out[i] = static_cast<uint8_t>(n_shares >> (8 * i));
+    }
+
+    uint8_t* bytes = out.data() + kSnapshotHeaderSize;
+    for (const auto& share : shares) {
+        share.writeBytes(bytes, false);
+        bytes += kShareSize;
+    }
+
+    return out;
 }
 
 bool PuncturableDecryption::PDecImpl::decrypt(
     const punct::ciphertext_type& ct_bytes,
-    uint64_t&                     m) const
+    uint64_t&                     m,
+    unsigned int                  n_threads) const
 {
-    return PPKE.decrypt(sk_, GmmppkeCT<uint64_t>(ct_bytes.data()), m);
+    return PPKE.decrypt(
+        dk_, GmmppkeCT<uint64_t>(ct_bytes.data()), m, n_threads);
+}
+
+std::vector<bool> PuncturableDecryption::PDecImpl::decrypt_batch(
+    const std::vector<punct::ciphertext_type>& cts,
+    std::vector<uint64_t>&                     ms,
+    unsigned int                               n_threads) const
+{
+    ms.assign(cts.size(), 0);
+    // std::vector<bool> cannot be written concurrently
+    std::vector<uint8_t> success(cts.size(), 0);
+
+    n_threads = worker_thread_count(n_threads);
+
+    if (n_threads <= 1 || cts.size() < n_threads) {
+        // few ciphertexts: parallelize every decryption over the key shares
+        for (size_t i = 0; i < cts.size(); i++) {
+            success[i] = decrypt(cts[i], ms[i], n_threads) ? 1 : 0;
+        }
+    } else {
+        RelicParallelChunks(
+            cts.size(),
+            n_threads,
+            [this, &cts, &ms, &success](unsigned int /*t*/,
+                                        size_t begin,
+                                        size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    success[i] = decrypt(cts[i], ms[i], 1) ? 1 : 0;
+                }
+            });
+    }
+
+    return std::vector<bool>(success.begin(), success.end());
 }
 
 
 PuncturableDecryption::PuncturableDecryption(
-    const punct::punctured_key_type& punctured_key)
-    : pdec_imp_(new PDecImpl(punctured_key))
+    const punct::punctured_key_type& punctured_key,
+    bool                             fixed_base_tables)
+    : pdec_imp_(new PDecImpl(punctured_key, fixed_base_tables))
+{
+}
+
+PuncturableDecryption::PuncturableDecryption(
+    const std::vector<uint8_t>& snapshot,
+    bool                        fixed_base_tables)
+    : pdec_imp_(new PDecImpl(snapshot, fixed_base_tables))
 {
 }
 
@@ -171,11 +377,50 @@ PuncturableDecryption::~PuncturableDecryption()
 {
 }
 
+void PuncturableDecryption::add_share(const punct::key_share_type& share)
+{
+    pdec_imp_->add_share(share);
+}
+
+void PuncturableDecryption::extend(const punct::punctured_key_type& shares)
+{
+    for (const auto& share : shares) {
+        pdec_imp_->add_share(share);
+    }
+}
+
+std::vector<uint8_t> PuncturableDecryption::snapshot() const
+{
+    return pdec_imp_->snapshot();
+}
+
+
+bool PuncturableDecryption::is_punctured_on_tag(
+    const punct::tag_type& tag) const
+{
+    return pdec_imp_->is_punctured_on_tag(tag);
+}
 
 bool PuncturableDecryption::decrypt(const punct::ciphertext_type& ct,
-                                    uint64_t&                     m)
+                                    uint64_t&                     m,
+                                    unsigned int                  n_threads)
+{
+    TraceSpan span("PuncturableDecryption::decrypt");
+    return pdec_imp_->decrypt(ct, m, n_threads);
+}
+
+std::vector<bool> PuncturableDecryption::decrypt_batch(
+    const std::vector<punct::ciphertext_type>& cts,
+    std::vector<uint64_t>&                     ms,
+    unsigned int                               n_threads)
+{
+    TraceSpan span("PuncturableDecryption::decrypt_batch");
+    return pdec_imp_->decrypt_batch(cts, ms, n_threads);
+}
+
+void PuncturableDecryption::set_min_shares_per_thread(size_t min_shares)
 {
-    return pdec_imp_->decrypt(ct, m);
+    Gmppke::setMinSharesPerThread(min_shares);
 }
 
 
@@ -20,15 +20,191 @@
 
 #include "random.hpp"
 
+#include <pthread.h>
+
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+
+#include <sodium/crypto_stream_chacha20.h>
 #include <sodium/randombytes.h>
+#include <sodium/utils.h>
 
 namespace sse {
 
 namespace crypto {
 
+namespace {
+
+std::atomic<uint8_t> g_random_source(
+    static_cast<uint8_t>(RandomSource::System));
+
+// Incremented in the child process after every fork, so that the
+// generators inherited from the parent are reseeded before being used.
+std::atomic<uint64_t> g_fork_generation(0);
+
+void on_fork_child()
+{
+    g_fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Per-thread ChaCha20 generator with fast key erasure: every refill
+// produces a new key followed by kBufferSize bytes of output, and the
+// previous key is discarded. Output bytes are wiped from the buffer as
+// soon as they are handed out, so a compromise of the state does not reveal
+// past outputs.
+// The key and the buffer are allocated with sodium_malloc: they are locked
+// in memory, excluded from core dumps, and surrounded by guard pages.
+class BufferedGenerator
+{
+public:
+    BufferedGenerator() = default;
+
+    ~BufferedGenerator()
+    {
+        // sodium_free erases the state
+        sodium_free(state_);
+    }
+
+    BufferedGenerator(const BufferedGenerator&) = delete;
+    BufferedGenerator& operator=(const BufferedGenerator&) = delete;
+
+    // Returns false if the state could not be allocated, in which case out
+    // is left untouched
+    bool generate(size_t byte_count, unsigned char* out) noexcept
+    {
+        if (state_ == nullptr) {
+            state_ = static_cast<State*>(sodium_malloc(sizeof(State)));
+            if (state_ == nullptr) {
+                return false; /* LCOV_EXCL_LINE */
+            }
+        }
+
+        if (!seeded_ || bytes_since_reseed_ >= kReseedInterval
+            || fork_generation_
+                   != g_fork_generation.load(std::memory_order_relaxed)) {
+            reseed();
+        }
+        bytes_since_reseed_ += byte_count;
+
+        if (byte_count > kDirectThreshold) {
+            // Large requests are directly filled with the stream of a
+            // single-use key, stored in the secure state
+            take(kKeySize, state_->subkey);
+            crypto_stream_chacha20(out, byte_count, kZeroNonce, state_->subkey);
+            sodium_memzero(state_->subkey, sizeof(state_->subkey));
+        } else {
+            take(byte_count, out);
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t kKeySize = crypto_stream_chacha20_KEYBYTES;
+
+    // Number of output bytes per refill
+    static constexpr size_t kBufferSize = 512;
+
+    // Requests larger than this are not served from the buffer
+    static constexpr size_t kDirectThreshold = 256;
+
+    // Number of output bytes after which the key is reseeded from the OS
+    static constexpr uint64_t kReseedInterval = 1UL << 20;
+
+    // Every key is used for a single stream: the nonce can be constant
+    static constexpr unsigned char kZeroNonce[crypto_stream_chacha20_NONCEBYTES]
+        = {0};
+
+    // Secret part of the generator
+    struct State
+    {
+        unsigned char key[kKeySize];
+        unsigned char block[kKeySize + kBufferSize];
+        unsigned char subkey[kKeySize];
+    };
+
+    void take(size_t byte_count, unsigned char* out) noexcept
+    {
+        while (byte_count > 0) {
+            if (available_ == 0) {
+                refill();
+            }
+            const size_t   n = std::min(byte_count, available_);
+            unsigned char* src
+                = state_->block + sizeof(state_->block) - available_;
+
+            memcpy(out, src, n);
+            sodium_memzero(src, n);
+
+            out += n;
+            byte_count -= n;
+            available_ -= n;
+        }
+    }
+
+    void refill() noexcept
+    {
+        crypto_stream_chacha20(state_->block,
+                               sizeof(state_->block),
+                               kZeroNonce,
+                               state_->key);
+        memcpy(state_->key, state_->block, kKeySize);
+        sodium_memzero(state_->block, kKeySize);
+        available_ = kBufferSize;
+    }
+
+    void reseed() noexcept
+    {
+        // Registered before the first generator is seeded
+        static const int atfork_registration
+            = pthread_atfork(nullptr, nullptr, &on_fork_child);
+        (void)atfork_registration;
+
+        fork_generation_ = g_fork_generation.load(std::memory_order_relaxed);
+        randombytes_buf(state_->key, sizeof(state_->key));
+        sodium_memzero(state_->block, sizeof(state_->block));
+        available_          = 0;
+        bytes_since_reseed_ = 0;
+        seeded_             = true;
+    }
+
+    State*   state_{nullptr};
+    size_t   available_{0};
+    uint64_t bytes_since_reseed_{0};
+    uint64_t fork_generation_{0};
+    bool     seeded_{false};
+};
+
+constexpr unsigned char
+    BufferedGenerator::kZeroNonce[crypto_stream_chacha20_NONCEBYTES];
+
+} // namespace
+
+void set_random_source(RandomSource source) noexcept
+{
+    g_random_source.store(static_cast<uint8_t>(source),
+                          std::memory_order_relaxed);
+}
+
+RandomSource random_source() noexcept
+{
+    return static_cast<RandomSource>(
+        g_random_source.load(std::memory_order_relaxed));
+}
+
 void random_bytes(const size_t byte_count, unsigned char* out) noexcept
 {
-    randombytes_buf(out, byte_count);
+    if (random_source() == RandomSource::System) {
+        randombytes_buf(out, byte_count);
+        return;
+    }
+
+    static thread_local BufferedGenerator generator;
+    if (!generator.generate(byte_count, out)) {
+        // no secure memory left for the generator
+        randombytes_buf(out, byte_count); /* LCOV_EXCL_LINE */
+    }
 }
 
 } // namespace crypto
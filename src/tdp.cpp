@@ -23,13 +23,16 @@
 #include "prf.hpp"
 #include "random.hpp"
 #include "tdp_impl/tdp_impl.hpp"
+#include "thread_pool.hpp"
 #include "utils.hpp"
 
 #include <cstring>
 
+#include <algorithm>
 #include <exception>
 #include <iomanip>
 #include <iostream>
+#include <thread>
 
 #define SSE_CRYPTO_TDP_IMPL_MBEDTLS 1
 #define SSE_CRYPTO_TDP_IMPL_OPENSSL 2
@@ -149,11 +152,13 @@ std::array<uint8_t, Tdp::kMessageSize> Tdp::generate_array(
 
 void Tdp::eval(const std::string& in, std::string& out) const
 {
+    TraceSpan span("Tdp::eval");
     tdp_imp_->eval(in, out);
 }
 
 std::string Tdp::eval(const std::string& in) const
 {
+    TraceSpan span("Tdp::eval");
     std::string out;
     tdp_imp_->eval(in, out);
 
@@ -163,9 +168,27 @@ std::string Tdp::eval(const std::string& in) const
 std::array<uint8_t, Tdp::kMessageSize> Tdp::eval(
     const std::array<uint8_t, kMessageSize>& in) const
 {
+    TraceSpan span("Tdp::eval");
     return tdp_imp_->eval(in);
 }
 
+std::array<uint8_t, Tdp::kMessageSize> Tdp::eval_iterated(
+    const std::array<uint8_t, kMessageSize>& in,
+    uint32_t                                 order) const
+{
+    TraceSpan span("Tdp::eval_iterated");
+    return tdp_imp_->eval_iterated(in, order, nullptr);
+}
+
+std::array<uint8_t, Tdp::kMessageSize> Tdp::eval_iterated(
+    const std::array<uint8_t, kMessageSize>& in,
+    uint32_t                                 order,
+    const iteration_callback_type&           callback) const
+{
+    TraceSpan span("Tdp::eval_iterated");
+    return tdp_imp_->eval_iterated(in, order, callback);
+}
+
 TdpInverse::TdpInverse() : tdp_inv_imp_(new TdpInverseImpl_Current())
 {
 }
@@ -245,11 +268,13 @@ std::array<uint8_t, TdpInverse::kMessageSize> TdpInverse::eval(
 
 void TdpInverse::invert(const std::string& in, std::string& out) const
 {
+    TraceSpan span("TdpInverse::invert");
     tdp_inv_imp_->invert(in, out);
 }
 
 std::string TdpInverse::invert(const std::string& in) const
 {
+    TraceSpan span("TdpInverse::invert");
     std::string out;
     tdp_inv_imp_->invert(in, out);
 
@@ -259,6 +284,7 @@ std::string TdpInverse::invert(const std::string& in) const
 std::array<uint8_t, TdpInverse::kMessageSize> TdpInverse::invert(
     const std::array<uint8_t, kMessageSize>& in) const
 {
+    TraceSpan span("TdpInverse::invert");
     return tdp_inv_imp_->invert(in);
 }
 
@@ -266,11 +292,13 @@ void TdpInverse::invert_mult(const std::string& in,
                              std::string&       out,
                              uint32_t           order) const
 {
+    TraceSpan span("TdpInverse::invert_mult");
     tdp_inv_imp_->invert_mult(in, out, order);
 }
 
 std::string TdpInverse::invert_mult(const std::string& in, uint32_t order) const
 {
+    TraceSpan span("TdpInverse::invert_mult");
     std::string out;
     tdp_inv_imp_->invert_mult(in, out, order);
 
@@ -281,9 +309,40 @@ std::array<uint8_t, TdpInverse::kMessageSize> TdpInverse::invert_mult(
     const std::array<uint8_t, kMessageSize>& in,
     uint32_t                                 order) const
 {
+    TraceSpan span("TdpInverse::invert_mult");
     return tdp_inv_imp_->invert_mult(in, order);
 }
 
+std::vector<std::array<uint8_t, TdpInverse::kMessageSize>> TdpInverse::
+    invert_batch(const std::vector<std::array<uint8_t, kMessageSize>>& in,
+                 unsigned int n_threads) const
+{
+    TraceSpan span("TdpInverse::invert_batch");
+    std::vector<std::array<uint8_t, kMessageSize>> out(in.size());
+
+    // at most one thread per element
+    n_threads = static_cast<unsigned int>(std::min(
+        static_cast<size_t>(worker_thread_count(n_threads)), in.size()));
+
+    if (n_threads <= 1) {
+        tdp_inv_imp_->invert_batch(in.data(), out.data(), in.size());
+        return out;
+    }
+
+    // split the batch in n_threads contiguous chunks. The implementations can
+    // be used concurrently without synchronization. The first chunk is
+    // inverted by the calling thread, and the other ones by persistent
+    // workers, whose blinding values are reused from one call to the next.
+    parallel_chunks(
+        in.size(),
+        n_threads,
+        [this, &in, &out](unsigned int /*t*/, size_t begin, size_t end) {
+            tdp_inv_imp_->invert_batch(
+                in.data() + begin, out.data() + begin, end - begin);
+        });
+
+    return out;
+}
 
 void TdpInverse::serialize(uint8_t* out) const
 {
@@ -395,11 +454,13 @@ void TdpMultPool::eval(const std::string& in,
                        std::string&       out,
                        uint8_t            order) const
 {
+    TraceSpan span("TdpMultPool::eval");
     tdp_pool_imp_->eval_pool(in, out, order);
 }
 
 std::string TdpMultPool::eval(const std::string& in, uint8_t order) const
 {
+    TraceSpan span("TdpMultPool::eval");
     std::string out;
     tdp_pool_imp_->eval_pool(in, out, order);
 
@@ -410,16 +471,19 @@ std::array<uint8_t, Tdp::kMessageSize> TdpMultPool::eval(
     const std::array<uint8_t, kMessageSize>& in,
     uint8_t                                  order) const
 {
+    TraceSpan span("TdpMultPool::eval");
     return tdp_pool_imp_->eval_pool(in, order);
 }
 
 void TdpMultPool::eval(const std::string& in, std::string& out) const
 {
+    TraceSpan span("TdpMultPool::eval");
     static_cast<TdpImpl*>(tdp_pool_imp_.get())->eval(in, out);
 }
 
 std::string TdpMultPool::eval(const std::string& in) const
 {
+    TraceSpan span("TdpMultPool::eval");
     std::string out;
     static_cast<TdpImpl*>(tdp_pool_imp_.get())->eval(in, out);
 
@@ -429,6 +493,7 @@ std::string TdpMultPool::eval(const std::string& in) const
 std::array<uint8_t, Tdp::kMessageSize> TdpMultPool::eval(
     const std::array<uint8_t, kMessageSize>& in) const
 {
+    TraceSpan span("TdpMultPool::eval");
     return static_cast<TdpImpl*>(tdp_pool_imp_.get())->eval(in);
 }
 
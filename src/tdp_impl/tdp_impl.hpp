@@ -48,6 +48,11 @@ public:
     virtual std::array<uint8_t, kMessageSpaceSize> eval(
         const std::array<uint8_t, kMessageSpaceSize>& in) const = 0;
 
+    virtual std::array<uint8_t, kMessageSpaceSize> eval_iterated(
+        const std::array<uint8_t, kMessageSpaceSize>& in,
+        uint32_t                                      order,
+        const Tdp::iteration_callback_type&           callback) const = 0;
+
     virtual std::string                            sample() const       = 0;
     virtual std::array<uint8_t, kMessageSpaceSize> sample_array() const = 0;
 
@@ -81,6 +86,12 @@ public:
     virtual void invert_mult(const std::string& in,
                              std::string&       out,
                              uint32_t           order) const = 0;
+
+    // Inverts count messages from in, and writes the results to out.
+    // Must be safe to call concurrently on the same object.
+    virtual void invert_batch(const std::array<uint8_t, kMessageSpaceSize>* in,
+                              std::array<uint8_t, kMessageSpaceSize>* out,
+                              size_t count) const = 0;
 };
 
 class TdpMultPoolImpl : virtual public TdpImpl
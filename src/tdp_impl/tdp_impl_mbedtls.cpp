@@ -25,12 +25,16 @@
 #include "mbedtls/rsa_io.h"
 #include "prf.hpp"
 #include "random.hpp"
+#include "utils.hpp"
 
 #include <cstring>
 
+#include <algorithm>
+#include <condition_variable>
 #include <exception>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 
 #include <sodium/utils.h>
 
@@ -44,6 +48,16 @@ namespace crypto {
 
 #define RSA_PK 0x10001L // RSA_F4 for OpenSSL
 
+// Size (in bytes) of the random multiple of p-1 and q-1 added to the private
+// exponents. Same value as in mbedtls/rsa.c
+#define RSA_EXPONENT_BLINDING 28
+
+// Number of messages whose exponentiations are interleaved by invert_batch
+#define RSA_BATCH_LANES 4
+
+// Window size (in bits) of the exponentiation used by invert_batch
+#define RSA_BATCH_WINDOW 5
+
 
 static void zeroize_rsa(mbedtls_rsa_context* rsa)
 {
@@ -62,6 +76,22 @@ static void zeroize_rsa(mbedtls_rsa_context* rsa)
     mbedtls_mpi_lset(&rsa->Vf, 0);
 }
 
+// Computes R^2 mod N, the constant needed by the Montgomery multiplication.
+// This is the value cached in the _RR argument of mbedtls_mpi_exp_mod
+static int compute_mont_rr(mbedtls_mpi* RR, const mbedtls_mpi* N)
+{
+    int ret = 0;
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(RR, 1));
+    MBEDTLS_MPI_CHK(
+        mbedtls_mpi_shift_l(RR, N->n * 2 * 8 * sizeof(mbedtls_mpi_uint)));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(RR, RR, N));
+
+// cppcheck-suppress unusedLabel
+cleanup:
+    return ret;
+}
+
 // mbedTLS implementation of the trapdoor permutation
 
 TdpImpl_mbedTLS::TdpImpl_mbedTLS()
@@ -87,6 +117,8 @@ TdpImpl_mbedTLS::TdpImpl_mbedTLS(const std::string& pk)
                                  "initialization");
         /* LCOV_EXCL_STOP */
     }
+
+    init_public_precomputations();
 }
 
 TdpImpl_mbedTLS::TdpImpl_mbedTLS(const TdpImpl_mbedTLS& tdp)
@@ -105,6 +137,17 @@ TdpImpl_mbedTLS::TdpImpl_mbedTLS(const TdpImpl_mbedTLS& tdp)
     }
 }
 
+void TdpImpl_mbedTLS::init_public_precomputations()
+{
+    // Precompute the Montgomery constant of the modulus, so that
+    // mbedtls_mpi_exp_mod only reads it: the key is never modified after the
+    // construction, and can be used concurrently without locking.
+    if (compute_mont_rr(&rsa_key_.RN, &rsa_key_.N) != 0) {
+        throw std::runtime_error(
+            "Failed Montgomery precomputation"); /* LCOV_EXCL_LINE */
+    }
+}
+
 inline size_t TdpImpl_mbedTLS::rsa_size() const
 {
     return rsa_key_.len;
@@ -201,21 +244,11 @@ std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> TdpImpl_mbedTLS::eval(
     // calling mbedtls_rsa_public is not ideal here as it would require us to
     // re-serialize the input
 
-#if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_lock(&rsa_key_->mutex) != 0)
-        throw std::runtime_error(
-            "Unable to lock the RSA context"); /* LCOV_EXCL_LINE */
-#endif
-
+    // RN was computed during the initialization, so the key is only read:
+    // there is no need to lock it
+    stats::count(&Statistics::mod_exps);
     ret = mbedtls_mpi_exp_mod(&x, &x, &rsa_key_.E, &rsa_key_.N, &rsa_key_.RN);
 
-
-#if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_unlock(&rsa_key_->mutex) != 0)
-        throw std::runtime_error(
-            "Unable to unlock the RSA context"); /* LCOV_EXCL_LINE */
-#endif
-
     if (ret != 0) {
         throw std::runtime_error(
             "Error during the modular exponentiation"); /* LCOV_EXCL_LINE */
@@ -228,6 +261,133 @@ std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> TdpImpl_mbedTLS::eval(
     return out;
 }
 
+// Raises X, given in Montgomery representation, to the power E modulo N. The
+// result is kept in Montgomery representation. base is used as a temporary
+// variable, and T must be large enough for mbedtls_mpi_montmul.
+// CAUTION: the exponent leaks through the timing of the square-and-multiply
+// loop. Only use this function with public exponents.
+static int mont_exp_public(mbedtls_mpi*       X,
+                           const mbedtls_mpi* E,
+                           const mbedtls_mpi* N,
+                           mbedtls_mpi_uint   mm,
+                           mbedtls_mpi*       base,
+                           const mbedtls_mpi* T)
+{
+    int          ret   = 0;
+    const size_t nbits = mbedtls_mpi_bitlen(E);
+
+    if (nbits == 0) {
+        return MBEDTLS_ERR_MPI_BAD_INPUT_DATA; /* LCOV_EXCL_LINE */
+    }
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_copy(base, X));
+
+    // for E = 65537, this is 16 squarings followed by a single multiplication
+    for (size_t i = nbits - 1; i > 0; i--) {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_montmul(X, X, N, mm, T));
+
+        if (mbedtls_mpi_get_bit(E, i - 1) == 1) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_montmul(X, base, N, mm, T));
+        }
+    }
+
+// cppcheck-suppress unusedLabel
+cleanup:
+    return ret;
+}
+
+std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> TdpImpl_mbedTLS::
+    eval_iterated(const std::array<uint8_t, kMessageSpaceSize>& in,
+                  uint32_t                                      order,
+                  const Tdp::iteration_callback_type&           callback) const
+{
+    if (order == 0) {
+        return in;
+    }
+
+    std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> out;
+    // buffer shared with the callback
+    std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> step;
+
+    // the exception thrown by the callback, if any
+    std::exception_ptr callback_exception;
+
+    const mbedtls_mpi* N       = &rsa_key_.N;
+    const size_t       n_limbs = N->n;
+
+    int              ret;
+    mbedtls_mpi_uint mm;
+    mbedtls_mpi      x, y, base, t;
+    mbedtls_mpi_init(&x);
+    mbedtls_mpi_init(&y);
+    mbedtls_mpi_init(&base);
+    mbedtls_mpi_init(&t);
+
+    mbedtls_mpi_montg_init(&mm, N);
+
+    // deserialize the integer, and reduce it in case we were given an input
+    // larger than the RSA modulus
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(&x, in.data(), in.size()));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&x, &x, N));
+
+    // the Montgomery multiplication needs some room
+    MBEDTLS_MPI_CHK(mbedtls_mpi_grow(&x, n_limbs + 1));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_grow(&y, n_limbs + 1));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_grow(&t, 2 * (n_limbs + 1)));
+
+    // switch to the Montgomery representation: x = x * R mod N
+    // (R^2 mod N was computed during the initialization)
+    MBEDTLS_MPI_CHK(mbedtls_mpi_montmul(&x, &rsa_key_.RN, N, mm, &t));
+
+    for (uint32_t i = 1; i <= order; i++) {
+        stats::count(&Statistics::mod_exps);
+        MBEDTLS_MPI_CHK(mont_exp_public(&x, &rsa_key_.E, N, mm, &base, &t));
+
+        // only go back to the regular representation when the caller needs
+        // the intermediate value
+        if (callback) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&y, &x));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_montred(&y, N, mm, &t));
+            MBEDTLS_MPI_CHK(
+                mbedtls_mpi_write_binary(&y, step.data(), step.size()));
+
+            try {
+                callback(i, step);
+            } catch (...) {
+                callback_exception = std::current_exception();
+                break;
+            }
+        }
+    }
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_montred(&x, N, mm, &t));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_write_binary(&x, out.data(), out.size()));
+
+    // cppcheck does not see the use of goto cleanup in the MBEDTLS_MPI_CHK
+    // macros
+// cppcheck-suppress unusedLabel
+cleanup:
+    // mbedtls_mpi_free erases the content of the integers
+    mbedtls_mpi_free(&x);
+    mbedtls_mpi_free(&y);
+    mbedtls_mpi_free(&base);
+    mbedtls_mpi_free(&t);
+    sodium_memzero(step.data(), step.size());
+
+    if (callback_exception) {
+        std::rethrow_exception(callback_exception);
+    }
+
+    if (ret != 0) {
+        /* LCOV_EXCL_START */
+        throw std::runtime_error(
+            "Error during the iterated modular exponentiation");
+        /* LCOV_EXCL_STOP */
+    }
+
+    return out;
+}
+
 
 std::string TdpImpl_mbedTLS::sample() const
 {
@@ -351,6 +511,356 @@ std::unique_ptr<TdpImpl> TdpImpl_mbedTLS::duplicate() const
     return std::unique_ptr<TdpImpl>(new TdpImpl_mbedTLS(*this));
 }
 
+/// Blinding values of the RSA private operation (see rsa_prepare_blinding in
+/// mbedtls/rsa.c). mbedTLS stores them in the RSA context, which therefore
+/// has to be locked during the private operation. Here, every thread has its
+/// own values, attached to the modulus they were generated for.
+class RsaBlinding
+{
+public:
+    RsaBlinding()
+    {
+        mbedtls_mpi_init(&N_);
+        mbedtls_mpi_init(&Vi_);
+        mbedtls_mpi_init(&Vf_);
+    }
+
+    ~RsaBlinding()
+    {
+        // mbedtls_mpi_free erases the content of the integers
+        mbedtls_mpi_free(&N_);
+        mbedtls_mpi_free(&Vi_);
+        mbedtls_mpi_free(&Vf_);
+    }
+
+    RsaBlinding(const RsaBlinding&) = delete;
+    RsaBlinding& operator=(const RsaBlinding&) = delete;
+
+    // Returns the blinding values of the calling thread
+    static RsaBlinding& thread_instance()
+    {
+        static thread_local RsaBlinding blinding;
+        return blinding;
+    }
+
+    // Updates the blinding values for the key: they are squared if they were
+    // generated for the same modulus, and regenerated otherwise.
+    int prepare(mbedtls_rsa_context* key)
+    {
+        int ret = 0;
+
+        if (Vf_.p != nullptr && mbedtls_mpi_cmp_mpi(&N_, &key->N) == 0) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&Vi_, &Vi_, &Vi_));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&Vi_, &Vi_, &key->N));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&Vf_, &Vf_, &Vf_));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&Vf_, &Vf_, &key->N));
+        } else {
+            // invalidate the current values until the new ones are ready
+            mbedtls_mpi_free(&Vf_);
+
+            // Unblinding value: Vf = random number, invertible mod N
+            int count = 0;
+            do {
+                if (count++ > 10) {
+                    return MBEDTLS_ERR_RSA_RNG_FAILED; /* LCOV_EXCL_LINE */
+                }
+
+                MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(
+                    &Vf_, key->len - 1, mbedTLS_rng_wrap, nullptr));
+                MBEDTLS_MPI_CHK(mbedtls_mpi_gcd(&Vi_, &Vf_, &key->N));
+            } while (mbedtls_mpi_cmp_int(&Vi_, 1) != 0);
+
+            // Blinding value: Vi =  Vf^(-e) mod N
+            MBEDTLS_MPI_CHK(mbedtls_mpi_inv_mod(&Vi_, &Vf_, &key->N));
+            stats::count(&Statistics::mod_exps);
+            MBEDTLS_MPI_CHK(mbedtls_mpi_exp_mod(
+                &Vi_, &Vi_, &key->E, &key->N, &key->RN));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&N_, &key->N));
+        }
+
+// cppcheck-suppress unusedLabel
+cleanup:
+        if (ret != 0) {
+            mbedtls_mpi_free(&Vf_); /* LCOV_EXCL_LINE */
+        }
+        return ret;
+    }
+
+    const mbedtls_mpi* vi() const
+    {
+        return &Vi_;
+    }
+
+    const mbedtls_mpi* vf() const
+    {
+        return &Vf_;
+    }
+
+private:
+    mbedtls_mpi N_; // modulus of the key the values were generated for
+    mbedtls_mpi Vi_, Vf_;
+};
+
+/// LRU cache of the CRT exponents (d_p, d_q) used by invert_mult.
+/// The exponents are stored in memory allocated with sodium_malloc, which is
+/// kept inaccessible when the cache is not used.
+/// The cache is guarded by a readers/writer scheme: lookups copy the
+/// exponents concurrently, outside of the mutex, and the storage stays
+/// accessible as long as one of them is running. Insertions are exclusive.
+class TdpInverseImpl_mbedTLS::CrtExponentCache
+{
+public:
+    static constexpr size_t kCapacity = 32;
+
+    explicit CrtExponentCache(size_t exponent_size)
+        : exponent_size_(exponent_size), storage_(nullptr)
+    {
+        // The storage is only allocated when the first entry is inserted: a
+        // TDP can be created before libsodium is initialized (e.g. as a
+        // static variable), and sodium_malloc cannot be called before that.
+        std::fill(last_use_.begin(), last_use_.end(), 0);
+    }
+
+    ~CrtExponentCache()
+    {
+        sodium_free(storage_);
+    }
+
+    CrtExponentCache(const CrtExponentCache&) = delete;
+    CrtExponentCache& operator=(const CrtExponentCache&) = delete;
+
+    // Looks the exponents for order up in the cache. Returns true and sets
+    // d_p and d_q if they were found, and false otherwise.
+    bool get(uint32_t order, mbedtls_mpi* d_p, mbedtls_mpi* d_q)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        // let the pending insertions go first
+        cv_.wait(lock, [this]() { return writers_ == 0; });
+
+        size_t i = 0;
+        for (; i < kCapacity; i++) {
+            if (last_use_[i] != 0 && orders_[i] == order) {
+                break;
+            }
+        }
+        if (i == kCapacity) {
+            return false;
+        }
+        last_use_[i] = ++clock_;
+
+        if (readers_++ == 0) {
+            unlock_storage();
+        }
+        lock.unlock();
+
+        // the entry cannot be modified while readers_ > 0
+        int ret = mbedtls_mpi_read_binary(d_p, entry(i), exponent_size_);
+        if (ret == 0) {
+            ret = mbedtls_mpi_read_binary(
+                d_q, entry(i) + exponent_size_, exponent_size_);
+        }
+
+        lock.lock();
+        if (--readers_ == 0) {
+            lock_storage();
+            cv_.notify_all();
+        }
+
+        return ret == 0;
+    }
+
+    // Inserts the exponents for order in the cache, evicting the least
+    // recently used entry if the cache is full.
+    void put(uint32_t order, const mbedtls_mpi* d_p, const mbedtls_mpi* d_q)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        writers_++;
+        cv_.wait(lock, [this]() { return readers_ == 0; });
+
+        struct WriterGuard
+        {
+            CrtExponentCache* cache;
+            ~WriterGuard()
+            {
+                if (--cache->writers_ == 0) {
+                    cache->cv_.notify_all();
+                }
+            }
+        } guard{this};
+
+        if (storage_ == nullptr) {
+            storage_ = static_cast<uint8_t*>(
+                sodium_allocarray(2 * kCapacity, exponent_size_));
+            stats::count(&Statistics::secure_allocations);
+
+            if (storage_ == nullptr) {
+                throw std::bad_alloc(); /* LCOV_EXCL_LINE */
+            }
+            lock_storage();
+        }
+
+        size_t slot = 0;
+        for (size_t i = 0; i < kCapacity; i++) {
+            if (last_use_[i] != 0 && orders_[i] == order) {
+                // another thread inserted the same exponents concurrently
+                return;
+            }
+            if (last_use_[i] < last_use_[slot]) {
+                slot = i;
+            }
+        }
+
+        unlock_storage();
+        int ret = mbedtls_mpi_write_binary(d_p, entry(slot), exponent_size_);
+        if (ret == 0) {
+            ret = mbedtls_mpi_write_binary(
+                d_q, entry(slot) + exponent_size_, exponent_size_);
+        }
+        lock_storage();
+
+        if (ret == 0) {
+            orders_[slot]   = order;
+            last_use_[slot] = ++clock_;
+        } else {
+            last_use_[slot] = 0; /* LCOV_EXCL_LINE */
+        }
+    }
+
+private:
+    uint8_t* entry(size_t i) const
+    {
+        return storage_ + 2 * i * exponent_size_;
+    }
+
+    void lock_storage() const
+    {
+#ifdef ENABLE_MEMORY_LOCK
+        stats::count(&Statistics::mprotects);
+        sodium_mprotect_noaccess(storage_);
+#endif
+    }
+
+    void unlock_storage() const
+    {
+#ifdef ENABLE_MEMORY_LOCK
+        stats::count(&Statistics::mprotects);
+        sodium_mprotect_readwrite(storage_);
+#endif
+    }
+
+    const size_t exponent_size_;
+    uint8_t*     storage_;
+
+    std::array<uint32_t, kCapacity> orders_;
+    std::array<uint64_t, kCapacity> last_use_; // 0 for empty entries
+    uint64_t                        clock_{0};
+
+    std::mutex              mtx_;
+    std::condition_variable cv_;
+    size_t                  readers_{0}; // running lookups
+    size_t                  writers_{0}; // running or pending insertions
+};
+
+TdpInverseImpl_mbedTLS::EvenModulus::EvenModulus()
+{
+    mbedtls_mpi_init(&odd_);
+    mbedtls_mpi_init(&pow2_);
+    mbedtls_mpi_init(&odd_inv_);
+    mbedtls_mpi_init(&rr_);
+}
+
+TdpInverseImpl_mbedTLS::EvenModulus::~EvenModulus()
+{
+    // mbedtls_mpi_free erases the content of the integers
+    mbedtls_mpi_free(&odd_);
+    mbedtls_mpi_free(&pow2_);
+    mbedtls_mpi_free(&odd_inv_);
+    mbedtls_mpi_free(&rr_);
+}
+
+void TdpInverseImpl_mbedTLS::EvenModulus::set(const mbedtls_mpi* M)
+{
+    int          ret = 0;
+    const size_t s   = mbedtls_mpi_lsb(M);
+
+    // M = 2^s * m
+    MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&odd_, M));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_shift_r(&odd_, s));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(&pow2_, 1));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_shift_l(&pow2_, s));
+
+    if (s > 0) {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_inv_mod(&odd_inv_, &odd_, &pow2_));
+    } else {
+        // M is odd: there is nothing to recombine
+        MBEDTLS_MPI_CHK(mbedtls_mpi_lset(&odd_inv_, 0)); /* LCOV_EXCL_LINE */
+    }
+
+    MBEDTLS_MPI_CHK(compute_mont_rr(&rr_, &odd_));
+
+// cppcheck-suppress unusedLabel
+cleanup:
+    if (ret != 0) {
+        throw std::runtime_error(
+            "Unable to split the even modulus. Error code: "
+            + std::to_string(ret)); /* LCOV_EXCL_LINE */
+    }
+}
+
+int TdpInverseImpl_mbedTLS::EvenModulus::exp_mod(mbedtls_mpi*       X,
+                                                 const mbedtls_mpi* A,
+                                                 uint32_t           e) const
+{
+    int         ret;
+    mbedtls_mpi E, x_odd, x_pow2, base, tmp;
+
+    mbedtls_mpi_init(&E);
+    mbedtls_mpi_init(&x_odd);
+    mbedtls_mpi_init(&x_pow2);
+    mbedtls_mpi_init(&base);
+    mbedtls_mpi_init(&tmp);
+
+    // modulo the odd part, use the (Montgomery-based) modular exponentiation
+    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(&E, e));
+    stats::count(&Statistics::mod_exps);
+    MBEDTLS_MPI_CHK(mbedtls_mpi_exp_mod(&x_odd, A, &E, &odd_, &rr_));
+
+    // modulo 2^s, the integers are tiny: use the square-and-multiply
+    // algorithm on the low bits
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&base, A, &pow2_));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(&x_pow2, 1));
+
+    for (uint32_t exp = e; exp > 0; exp >>= 1) {
+        if ((exp & 1) == 1) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&tmp, &x_pow2, &base));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&x_pow2, &tmp, &pow2_));
+        }
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&tmp, &base, &base));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&base, &tmp, &pow2_));
+    }
+
+    /*
+     * CRT recombination:
+     * X = x_odd + m * ((x_pow2 - x_odd) * (m^-1 mod 2^s) mod 2^s)
+     */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_sub_mpi(&tmp, &x_pow2, &x_odd));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&base, &tmp, &odd_inv_));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&tmp, &base, &pow2_));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&base, &tmp, &odd_));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(X, &x_odd, &base));
+
+// cppcheck-suppress unusedLabel
+cleanup:
+    // mbedtls_mpi_free erases the content of the integers
+    mbedtls_mpi_free(&E);
+    mbedtls_mpi_free(&x_odd);
+    mbedtls_mpi_free(&x_pow2);
+    mbedtls_mpi_free(&base);
+    mbedtls_mpi_free(&tmp);
+
+    return ret;
+}
+
 TdpInverseImpl_mbedTLS::TdpInverseImpl_mbedTLS()
 {
     int ret;
@@ -378,18 +888,7 @@ TdpInverseImpl_mbedTLS::TdpInverseImpl_mbedTLS()
             "initialization"); /* LCOV_EXCL_LINE */
     }
 
-    if (mbedtls_mpi_sub_int(&p_1_, &rsa_key_.P, 1) != 0) {
-        throw std::runtime_error(
-            "Failed MPI substraction"); /* LCOV_EXCL_LINE */
-    }
-    if (mbedtls_mpi_sub_int(&q_1_, &rsa_key_.Q, 1) != 0) {
-        throw std::runtime_error(
-            "Failed MPI substraction"); /* LCOV_EXCL_LINE */
-    }
-    if (mbedtls_mpi_mul_mpi(&phi_, &p_1_, &q_1_) != 0) {
-        throw std::runtime_error(
-            "Failed MPI multiplication"); /* LCOV_EXCL_LINE */
-    }
+    init_private_precomputations();
 }
 
 TdpInverseImpl_mbedTLS::TdpInverseImpl_mbedTLS(const std::string& sk)
@@ -422,6 +921,13 @@ TdpInverseImpl_mbedTLS::TdpInverseImpl_mbedTLS(const std::string& sk)
             "initialization from existing secret key"); /* LCOV_EXCL_LINE */
     }
 
+    init_private_precomputations();
+}
+
+void TdpInverseImpl_mbedTLS::init_private_precomputations()
+{
+    init_public_precomputations();
+
     if (mbedtls_mpi_sub_int(&p_1_, &rsa_key_.P, 1) != 0) {
         throw std::runtime_error(
             "Failed MPI substraction"); /* LCOV_EXCL_LINE */
@@ -434,6 +940,21 @@ TdpInverseImpl_mbedTLS::TdpInverseImpl_mbedTLS(const std::string& sk)
         throw std::runtime_error(
             "Failed MPI multiplication"); /* LCOV_EXCL_LINE */
     }
+
+    // Precompute the Montgomery constants of the CRT moduli, so that
+    // mbedtls_mpi_exp_mod only reads them: invert_mult does not have to lock
+    // the key
+    if (compute_mont_rr(&rsa_key_.RP, &rsa_key_.P) != 0
+        || compute_mont_rr(&rsa_key_.RQ, &rsa_key_.Q) != 0) {
+        throw std::runtime_error(
+            "Failed Montgomery precomputation"); /* LCOV_EXCL_LINE */
+    }
+
+    p_1_split_.set(&p_1_);
+    q_1_split_.set(&q_1_);
+
+    crt_cache_.reset(new CrtExponentCache(
+        std::max(mbedtls_mpi_size(&p_1_), mbedtls_mpi_size(&q_1_))));
 }
 
 TdpInverseImpl_mbedTLS::~TdpInverseImpl_mbedTLS()
@@ -467,6 +988,319 @@ std::string TdpInverseImpl_mbedTLS::private_key() const
 }
 
 
+int TdpInverseImpl_mbedTLS::rsa_private(const unsigned char* input,
+                                        unsigned char*       output) const
+{
+    int          ret;
+    mbedtls_mpi  T, T1, T2, R, DP_blind, DQ_blind;
+    RsaBlinding& blinding = RsaBlinding::thread_instance();
+
+    mbedtls_mpi_init(&T);
+    mbedtls_mpi_init(&T1);
+    mbedtls_mpi_init(&T2);
+    mbedtls_mpi_init(&R);
+    mbedtls_mpi_init(&DP_blind);
+    mbedtls_mpi_init(&DQ_blind);
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(&T, input, rsa_key_.len));
+    if (mbedtls_mpi_cmp_mpi(&T, &rsa_key_.N) >= 0) {
+        ret = MBEDTLS_ERR_MPI_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
+    /*
+     * Blinding
+     * T = T * Vi mod N
+     */
+    MBEDTLS_MPI_CHK(blinding.prepare(&rsa_key_));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&T1, &T, blinding.vi()));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&T, &T1, &rsa_key_.N));
+
+    /*
+     * Exponent blinding
+     * DP_blind = ( P - 1 ) * R + DP
+     * DQ_blind = ( Q - 1 ) * R + DQ
+     */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(
+        &R, RSA_EXPONENT_BLINDING, mbedTLS_rng_wrap, nullptr));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&DP_blind, &p_1_, &R));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&DP_blind, &DP_blind, &rsa_key_.DP));
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(
+        &R, RSA_EXPONENT_BLINDING, mbedTLS_rng_wrap, nullptr));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&DQ_blind, &q_1_, &R));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&DQ_blind, &DQ_blind, &rsa_key_.DQ));
+
+    /*
+     * T1 = T ^ DP_blind mod P
+     * T2 = T ^ DQ_blind mod Q
+     * RP and RQ were computed during the initialization: the key is only read.
+     */
+    stats::count(&Statistics::mod_exps, 2);
+    MBEDTLS_MPI_CHK(
+        mbedtls_mpi_exp_mod(&T1, &T, &DP_blind, &rsa_key_.P, &rsa_key_.RP));
+    MBEDTLS_MPI_CHK(
+        mbedtls_mpi_exp_mod(&T2, &T, &DQ_blind, &rsa_key_.Q, &rsa_key_.RQ));
+
+    /*
+     * T = (T1 - T2) * (Q^-1 mod P) mod P
+     */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_sub_mpi(&T, &T1, &T2));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&T1, &T, &rsa_key_.QP));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&T, &T1, &rsa_key_.P));
+
+    /*
+     * T = T2 + T * Q
+     */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&T1, &T, &rsa_key_.Q));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&T, &T2, &T1));
+
+    /*
+     * Unblind
+     * T = T * Vf mod N
+     */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&T1, &T, blinding.vf()));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&T, &T1, &rsa_key_.N));
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_write_binary(&T, output, rsa_key_.len));
+
+// cppcheck-suppress unusedLabel
+cleanup:
+    // mbedtls_mpi_free erases the content of the integers
+    mbedtls_mpi_free(&T);
+    mbedtls_mpi_free(&T1);
+    mbedtls_mpi_free(&T2);
+    mbedtls_mpi_free(&R);
+    mbedtls_mpi_free(&DP_blind);
+    mbedtls_mpi_free(&DQ_blind);
+
+    return ret;
+}
+
+// Computes X[l] = A[l]^E mod N for l < count, with count <= RSA_BATCH_LANES.
+// The exponentiations are interleaved: the exponent is scanned only once, and
+// every step is applied to all the lanes before moving to the next one, so
+// that the processor can overlap the independent Montgomery multiplications.
+// A fixed window is used: the sequence of multiplications does not depend on
+// the exponent. The A[l] must be reduced modulo N and can alias the X[l].
+// RR is R^2 mod N.
+static int exp_mod_interleaved(mbedtls_mpi*       X,
+                               const mbedtls_mpi* A,
+                               size_t             count,
+                               const mbedtls_mpi* E,
+                               const mbedtls_mpi* N,
+                               const mbedtls_mpi* RR)
+{
+    constexpr size_t kTableSize = 1 << RSA_BATCH_WINDOW;
+
+    if (count > RSA_BATCH_LANES) {
+        return MBEDTLS_ERR_MPI_BAD_INPUT_DATA; /* LCOV_EXCL_LINE */
+    }
+
+    int              ret     = 0;
+    const size_t     n_limbs = N->n;
+    const size_t     n_windows
+        = (mbedtls_mpi_bitlen(E) + RSA_BATCH_WINDOW - 1) / RSA_BATCH_WINDOW;
+    mbedtls_mpi_uint mm;
+    mbedtls_mpi      T;
+    mbedtls_mpi      W[RSA_BATCH_LANES][kTableSize];
+
+    mbedtls_mpi_init(&T);
+    for (size_t l = 0; l < count; l++) {
+        for (size_t k = 0; k < kTableSize; k++) {
+            mbedtls_mpi_init(&W[l][k]);
+        }
+    }
+
+    mbedtls_mpi_montg_init(&mm, N);
+    MBEDTLS_MPI_CHK(mbedtls_mpi_grow(&T, 2 * (n_limbs + 1)));
+
+    // W[l][k] = A[l]^k * R mod N
+    for (size_t l = 0; l < count; l++) {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_lset(&W[l][0], 1));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_grow(&W[l][0], n_limbs + 1));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_montmul(&W[l][0], RR, N, mm, &T));
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&W[l][1], &A[l]));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_grow(&W[l][1], n_limbs + 1));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_montmul(&W[l][1], RR, N, mm, &T));
+
+        for (size_t k = 2; k < kTableSize; k++) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&W[l][k], &W[l][k - 1]));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_grow(&W[l][k], n_limbs + 1));
+            MBEDTLS_MPI_CHK(
+                mbedtls_mpi_montmul(&W[l][k], &W[l][1], N, mm, &T));
+        }
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&X[l], &W[l][0]));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_grow(&X[l], n_limbs + 1));
+    }
+
+    for (size_t w = n_windows; w > 0; w--) {
+        size_t index = 0;
+        for (size_t b = 1; b <= RSA_BATCH_WINDOW; b++) {
+            index = (index << 1)
+                    | mbedtls_mpi_get_bit(E, w * RSA_BATCH_WINDOW - b);
+        }
+
+        for (size_t b = 0; b < RSA_BATCH_WINDOW; b++) {
+            for (size_t l = 0; l < count; l++) {
+                MBEDTLS_MPI_CHK(mbedtls_mpi_montmul(&X[l], &X[l], N, mm, &T));
+            }
+        }
+        for (size_t l = 0; l < count; l++) {
+            MBEDTLS_MPI_CHK(
+                mbedtls_mpi_montmul(&X[l], &W[l][index], N, mm, &T));
+        }
+    }
+
+    // back to the regular representation
+    for (size_t l = 0; l < count; l++) {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_montred(&X[l], N, mm, &T));
+    }
+
+// cppcheck-suppress unusedLabel
+cleanup:
+    // mbedtls_mpi_free erases the content of the integers
+    mbedtls_mpi_free(&T);
+    for (size_t l = 0; l < count; l++) {
+        for (size_t k = 0; k < kTableSize; k++) {
+            mbedtls_mpi_free(&W[l][k]);
+        }
+    }
+
+    return ret;
+}
+
+int TdpInverseImpl_mbedTLS::rsa_private_lanes(
+    const std::array<uint8_t, kMessageSpaceSize>* in,
+    std::array<uint8_t, kMessageSpaceSize>*       out,
+    size_t                                        count) const
+{
+    if (count > RSA_BATCH_LANES) {
+        return MBEDTLS_ERR_MPI_BAD_INPUT_DATA; /* LCOV_EXCL_LINE */
+    }
+
+    int          ret = 0;
+    mbedtls_mpi  T[RSA_BATCH_LANES], T1[RSA_BATCH_LANES], T2[RSA_BATCH_LANES];
+    mbedtls_mpi  Vf[RSA_BATCH_LANES];
+    mbedtls_mpi  R, DP_blind, DQ_blind, tmp;
+    RsaBlinding& blinding = RsaBlinding::thread_instance();
+
+    for (size_t l = 0; l < count; l++) {
+        mbedtls_mpi_init(&T[l]);
+        mbedtls_mpi_init(&T1[l]);
+        mbedtls_mpi_init(&T2[l]);
+        mbedtls_mpi_init(&Vf[l]);
+    }
+    mbedtls_mpi_init(&R);
+    mbedtls_mpi_init(&DP_blind);
+    mbedtls_mpi_init(&DQ_blind);
+    mbedtls_mpi_init(&tmp);
+
+    for (size_t l = 0; l < count; l++) {
+        MBEDTLS_MPI_CHK(
+            mbedtls_mpi_read_binary(&T[l], in[l].data(), in[l].size()));
+        if (mbedtls_mpi_cmp_mpi(&T[l], &rsa_key_.N) >= 0) {
+            ret = MBEDTLS_ERR_MPI_BAD_INPUT_DATA;
+            goto cleanup;
+        }
+
+        /*
+         * Blinding, with different values for every message
+         * T = T * Vi mod N
+         */
+        MBEDTLS_MPI_CHK(blinding.prepare(&rsa_key_));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&tmp, &T[l], blinding.vi()));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&T[l], &tmp, &rsa_key_.N));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&Vf[l], blinding.vf()));
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&T1[l], &T[l], &rsa_key_.P));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&T2[l], &T[l], &rsa_key_.Q));
+    }
+
+    /*
+     * Exponent blinding, shared by all the lanes
+     * DP_blind = ( P - 1 ) * R + DP
+     * DQ_blind = ( Q - 1 ) * R + DQ
+     */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(
+        &R, RSA_EXPONENT_BLINDING, mbedTLS_rng_wrap, nullptr));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&DP_blind, &p_1_, &R));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&DP_blind, &DP_blind, &rsa_key_.DP));
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(
+        &R, RSA_EXPONENT_BLINDING, mbedTLS_rng_wrap, nullptr));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&DQ_blind, &q_1_, &R));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&DQ_blind, &DQ_blind, &rsa_key_.DQ));
+
+    /*
+     * T1 = T ^ DP_blind mod P
+     * T2 = T ^ DQ_blind mod Q
+     */
+    stats::count(&Statistics::mod_exps, 2 * count);
+    MBEDTLS_MPI_CHK(exp_mod_interleaved(
+        T1, T1, count, &DP_blind, &rsa_key_.P, &rsa_key_.RP));
+    MBEDTLS_MPI_CHK(exp_mod_interleaved(
+        T2, T2, count, &DQ_blind, &rsa_key_.Q, &rsa_key_.RQ));
+
+    for (size_t l = 0; l < count; l++) {
+        /*
+         * T = T2 + ((T1 - T2) * (Q^-1 mod P) mod P) * Q
+         */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_mpi(&tmp, &T1[l], &T2[l]));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&T[l], &tmp, &rsa_key_.QP));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&tmp, &T[l], &rsa_key_.P));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&T[l], &tmp, &rsa_key_.Q));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&T[l], &T[l], &T2[l]));
+
+        /*
+         * Unblind
+         * T = T * Vf mod N
+         */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&tmp, &T[l], &Vf[l]));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&T[l], &tmp, &rsa_key_.N));
+
+        MBEDTLS_MPI_CHK(
+            mbedtls_mpi_write_binary(&T[l], out[l].data(), out[l].size()));
+    }
+
+// cppcheck-suppress unusedLabel
+cleanup:
+    // mbedtls_mpi_free erases the content of the integers
+    for (size_t l = 0; l < count; l++) {
+        mbedtls_mpi_free(&T[l]);
+        mbedtls_mpi_free(&T1[l]);
+        mbedtls_mpi_free(&T2[l]);
+        mbedtls_mpi_free(&Vf[l]);
+    }
+    mbedtls_mpi_free(&R);
+    mbedtls_mpi_free(&DP_blind);
+    mbedtls_mpi_free(&DQ_blind);
+    mbedtls_mpi_free(&tmp);
+
+    return ret;
+}
+
+void TdpInverseImpl_mbedTLS::invert_batch(
+    const std::array<uint8_t, kMessageSpaceSize>* in,
+    std::array<uint8_t, kMessageSpaceSize>*       out,
+    size_t                                        count) const
+{
+    for (size_t start = 0; start < count; start += RSA_BATCH_LANES) {
+        const size_t lanes
+            = std::min(static_cast<size_t>(RSA_BATCH_LANES), count - start);
+
+        int ret = rsa_private_lanes(in + start, out + start, lanes);
+
+        if (ret != 0) {
+            throw std::invalid_argument(
+                "Error during the RSA private key operation. Code: "
+                + std::to_string(ret));
+        }
+    }
+}
+
 void TdpInverseImpl_mbedTLS::invert(const std::string& in,
                                     std::string&       out) const
 {
@@ -478,11 +1312,8 @@ void TdpInverseImpl_mbedTLS::invert(const std::string& in,
                                     "be kMessageSpaceSize bytes long.");
     }
 
-    ret = mbedtls_rsa_private(&rsa_key_,
-                              mbedTLS_rng_wrap,
-                              nullptr,
-                              reinterpret_cast<const unsigned char*>(in.data()),
-                              rsa_out);
+    ret = rsa_private(reinterpret_cast<const unsigned char*>(in.data()),
+                      rsa_out);
 
     if (ret != 0) {
         throw std::invalid_argument(
@@ -500,8 +1331,7 @@ std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> TdpInverseImpl_mbedTLS::
 {
     std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> out;
 
-    int ret = mbedtls_rsa_private(
-        &rsa_key_, mbedTLS_rng_wrap, nullptr, in.data(), out.data());
+    int ret = rsa_private(in.data(), out.data());
 
     if (ret != 0) {
         throw std::invalid_argument(
@@ -512,40 +1342,25 @@ std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> TdpInverseImpl_mbedTLS::
     return out;
 }
 
-// returns X = A^E mod N, even when N is even
-// CAUTION!!!!: be aware that a timing attack would reveal E,
-// contrary to mbedtls_mpi_exp_mod
-static int insecure_mod_exp(mbedtls_mpi*       X,
-                            const mbedtls_mpi* A,
-                            const uint64_t     E,
-                            const mbedtls_mpi* N)
+void TdpInverseImpl_mbedTLS::crt_exponents(uint32_t     order,
+                                           mbedtls_mpi* d_p,
+                                           mbedtls_mpi* d_q) const
 {
-    int      ret = 0;
-    uint64_t exp = E;
-
-    mbedtls_mpi base;
-    mbedtls_mpi_init(&base);
-
-    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(X, 1));
-
-
-    MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&base, A));
-    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&base, &base, N));
+    if (crt_cache_->get(order, d_p, d_q)) {
+        return;
+    }
 
-    while (exp > 0) {
-        if (exp % 2 == 1) {
-            MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(X, X, &base));
-            MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(X, X, N));
-        }
-        exp >>= 1;
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&base, &base, &base));
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&base, &base, N));
+    // mbedTLS mpi library does not allow for a modular exponentiation
+    // where the module is even, and p-1 and q-1 are even: EvenModulus splits
+    // the computation between the odd part (where Montgomery exponentiation
+    // is used) and the power of 2 part.
+    if (p_1_split_.exp_mod(d_p, &rsa_key_.DP, order) != 0
+        || q_1_split_.exp_mod(d_q, &rsa_key_.DQ, order) != 0) {
+        throw std::runtime_error(
+            "Error when computing the CRT exponents"); /* LCOV_EXCL_LINE */
     }
 
-// cppcheck-suppress unusedLabel
-cleanup:
-    mbedtls_mpi_free(&base);
-    return ret;
+    crt_cache_->put(order, d_p, d_q);
 }
 
 std::array<uint8_t, TdpInverseImpl_mbedTLS::kMessageSpaceSize>
@@ -571,11 +1386,10 @@ TdpInverseImpl_mbedTLS::invert_mult(
     }
 
     int         ret;
-    mbedtls_mpi x, mpi_order, d_p, d_q;
+    mbedtls_mpi x, d_p, d_q;
     mbedtls_mpi y_p, y_q;
     mbedtls_mpi y;
     mbedtls_mpi_init(&x);
-    mbedtls_mpi_init(&mpi_order);
     mbedtls_mpi_init(&d_p);
     mbedtls_mpi_init(&d_q);
     mbedtls_mpi_init(&y_p);
@@ -585,40 +1399,17 @@ TdpInverseImpl_mbedTLS::invert_mult(
     // deserialize the integer
     ret = mbedtls_mpi_read_binary(&x, in.data(), in.size());
 
-    // in case we were given an input larger than the RSA modulus
-    //    ret = mbedtls_mpi_mod_mpi(&x,&x,&rsa_key_.N);
-    //    if (ret != 0) {
-    //        throw std::runtime_error("Error when reducing the RSA input mod
-    //        N"); /* LCOV_EXCL_LINE */
-    //    }
-
     if (ret != 0) {
         throw std::runtime_error(
             "Unable to read the TDP input"); /* LCOV_EXCL_LINE */
     }
 
-    // load the order
-    mbedtls_mpi_lset(&mpi_order, order);
-
-#if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_lock(&rsa_key_->mutex) != 0)
-        throw std::runtime_error(
-            "Unable to lock the RSA context"); /* LCOV_EXCL_LINE */
-#endif
-
-    // there is an issue with the following code:
-    // mbedTLS mpi library does not allow for a modular exponentiation
-    // where the module is even. And we were actually relying on that
-    // to compute the adjusted exponent
-    //    mbedtls_mpi_exp_mod(&d_p, &rsa_key_.DP, &mpi_order, &p_1_, nullptr);
-    //    mbedtls_mpi_exp_mod(&d_q, &rsa_key_.DQ, &mpi_order, &q_1_, nullptr);
-
-    // instead, we implemented the insecure_mod_exp function
-    // it is definitely less secure than mbedtls_mpi_exp_mod
-    // but it works with even modulis
-    MBEDTLS_MPI_CHK(insecure_mod_exp(&d_p, &rsa_key_.DP, order, &p_1_));
-    MBEDTLS_MPI_CHK(insecure_mod_exp(&d_q, &rsa_key_.DQ, order, &q_1_));
+    // get the exponents d_p = DP^order mod (p-1) and d_q = DQ^order mod (q-1)
+    crt_exponents(order, &d_p, &d_q);
 
+    // The key is only read from now on (the Montgomery constants RP and RQ
+    // were computed during the initialization): there is no need to lock it.
+    stats::count(&Statistics::mod_exps, 2);
     MBEDTLS_MPI_CHK(
         mbedtls_mpi_exp_mod(&y_p, &x, &d_p, &rsa_key_.P, &rsa_key_.RP));
     MBEDTLS_MPI_CHK(
@@ -638,28 +1429,6 @@ TdpInverseImpl_mbedTLS::invert_mult(
     MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&y_p, &y, &rsa_key_.Q));
     MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&y, &y_q, &y_p));
 
-    ////    BN_mod_sub(h, y_p, y_q, get_rsa_key()->p, ctx);
-    //    mbedtls_mpi_sub_mpi(&h, &y_p, &y_q);
-    //    mbedtls_mpi_mod_mpi(&h, &h, &rsa_key_.P);
-    //
-    ////    BN_mod_mul(h, h, get_rsa_key()->iqmp, get_rsa_key()->p, ctx);
-    //    mbedtls_mpi_mul_mpi(&h, &h, &rsa_key_.QP);
-    //    mbedtls_mpi_mod_mpi(&h, &h, &rsa_key_.P);
-    //
-    //
-    //    mbedtls_mpi_mul_mpi(&y, &h, &rsa_key_.Q);
-    //    mbedtls_mpi_add_mpi(&y, &y, &y_q);
-
-
-    // calling mbedtls_rsa_public is not ideal here as it would require us to
-    // re-serialize the input
-
-#if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_unlock(&rsa_key_->mutex) != 0)
-        throw std::runtime_error(
-            "Unable to unlock the RSA context"); /* LCOV_EXCL_LINE */
-#endif
-
     if (mbedtls_mpi_write_binary(&y, out.data(), out.size()) != 0) {
         throw std::runtime_error("Error while writing RSA result to the out "
                                  "buffer"); /* LCOV_EXCL_LINE
@@ -676,14 +1445,12 @@ cleanup:
     mbedtls_mpi_lset(&d_q, 0);
     mbedtls_mpi_lset(&y_p, 0);
     mbedtls_mpi_lset(&y_q, 0);
-    mbedtls_mpi_lset(&mpi_order, 0);
 
     mbedtls_mpi_free(&x);
     mbedtls_mpi_free(&d_p);
     mbedtls_mpi_free(&d_q);
     mbedtls_mpi_free(&y_p);
     mbedtls_mpi_free(&y_q);
-    mbedtls_mpi_free(&mpi_order);
 
     if (ret != 0) {
         throw std::runtime_error(
@@ -714,97 +1481,32 @@ void TdpInverseImpl_mbedTLS::invert_mult(const std::string& in,
 
 TdpMultPoolImpl_mbedTLS::TdpMultPoolImpl_mbedTLS(const std::string& sk,
                                                  const uint8_t      size)
-    : TdpImpl_mbedTLS(sk), keys_count_(size - 1)
+    : TdpImpl_mbedTLS(sk), maximum_order_(size)
 {
     if (size == 0) {
         throw std::invalid_argument(
             "Invalid Multiple TDP pool input size. Pool size should be > 0.");
     }
-
-    keys_ = new mbedtls_rsa_context[keys_count_];
-
-    mbedtls_rsa_init(keys_, 0, 0);
-    mbedtls_rsa_copy(keys_, &rsa_key_);
-
-    mbedtls_mpi_mul_int(&keys_[0].E, &keys_[0].E, RSA_PK);
-
-    if (mbedtls_rsa_check_pubkey(&keys_[0]) != 0) {
-        throw std::runtime_error("Invalid public key generated during the TDP "
-                                 "pool initialization"); /* LCOV_EXCL_LINE */
-    }
-
-    for (uint8_t i = 1; i < keys_count_; i++) {
-        mbedtls_rsa_init(&keys_[i], 0, 0);
-        mbedtls_rsa_copy(&keys_[i], &keys_[i - 1]);
-
-        mbedtls_mpi_mul_int(&keys_[i].E, &keys_[i - 1].E, RSA_PK);
-
-        if (mbedtls_rsa_check_pubkey(&keys_[i]) != 0) {
-            throw std::runtime_error(
-                "Invalid public key generated during the TDP pool "
-                "initialization"); /* LCOV_EXCL_LINE */
-        }
-    }
 }
 
 TdpMultPoolImpl_mbedTLS::TdpMultPoolImpl_mbedTLS(
     const TdpMultPoolImpl_mbedTLS& pool_impl)
-    : TdpImpl_mbedTLS(pool_impl), keys_count_(pool_impl.keys_count_)
+    : TdpImpl_mbedTLS(pool_impl), maximum_order_(pool_impl.maximum_order_)
 {
-    keys_ = new mbedtls_rsa_context[keys_count_];
-
-    for (uint8_t i = 0; i < keys_count_; i++) {
-        mbedtls_rsa_init(&keys_[i], 0, 0);
-
-        mbedtls_rsa_copy(&keys_[i], &pool_impl.keys_[i]);
-
-
-        if (mbedtls_rsa_check_pubkey(&keys_[i]) != 0) {
-            throw std::runtime_error(
-                "Invalid public key generated by the TDP pool copy "
-                "constructor"); /* LCOV_EXCL_LINE */
-        }
-    }
 }
 
 TdpMultPoolImpl_mbedTLS& TdpMultPoolImpl_mbedTLS::operator=(
     const TdpMultPoolImpl_mbedTLS& t)
 {
     if (this != &t) {
-        for (uint8_t i = 0; i < keys_count_; i++) {
-            zeroize_rsa(&keys_[i]);
-            mbedtls_rsa_free(&keys_[i]);
-        }
-
-        if (keys_count_ != t.keys_count_) {
-            // realloc the key array
-            delete[] keys_;
-            keys_count_ = t.keys_count_;
-            keys_       = new mbedtls_rsa_context[keys_count_];
-        }
-
-        for (uint8_t i = 0; i < keys_count_; i++) {
-            mbedtls_rsa_init(&keys_[i], 0, 0);
-
-            mbedtls_rsa_copy(&keys_[i], &t.keys_[i]);
-
-            if (mbedtls_rsa_check_pubkey(&keys_[i]) != 0) {
-                throw std::runtime_error(
-                    "Invalid public key generated by the TDP pool assignment "
-                    "operator"); /* LCOV_EXCL_LINE */
-            }
-        }
+        TdpImpl_mbedTLS::operator=(t);
+        maximum_order_ = t.maximum_order_;
     }
     return *this;
 }
 
 TdpMultPoolImpl_mbedTLS::~TdpMultPoolImpl_mbedTLS()
 {
-    for (uint8_t i = 0; i < keys_count_; i++) {
-        zeroize_rsa(&keys_[i]);
-        mbedtls_rsa_free(&keys_[i]);
-    }
-    delete[] keys_;
 }
 
 std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize>
@@ -812,77 +1514,18 @@ TdpMultPoolImpl_mbedTLS::eval_pool(
     const std::array<uint8_t, kMessageSpaceSize>& in,
     const uint8_t                                 order) const
 {
-    std::array<uint8_t, TdpImpl_mbedTLS::kMessageSpaceSize> out;
-    mbedtls_rsa_context*                                    key;
-    if (order == 1) {
-        // regular eval
-        key = &rsa_key_;
-
-    } else if (order <= maximum_order()) {
-        // get the right RSA context, i.e. the one in keys_[order-1]
-        key = &keys_[order - 2];
-    } else {
+    if (order == 0 || order > maximum_order()) {
         throw std::invalid_argument(
             "Invalid order for this TDP pool. The input order must be less "
             "than the maximum order supported by the pool, and strictly "
             "positive.");
     }
 
-
-    if (in.size() != rsa_size()) {
-        throw std::runtime_error(
-            "Invalid TDP input size. Input size should be kMessageSpaceSize "
-            "bytes long."); /* LCOV_EXCL_LINE */
-    }
-
-    int         ret;
-    mbedtls_mpi x;
-    mbedtls_mpi_init(&x);
-
-    // deserialize the integer
-    ret = mbedtls_mpi_read_binary(&x, in.data(), in.size());
-
-    if (ret != 0) {
-        throw std::runtime_error(
-            "Unable to read the TDP input"); /* LCOV_EXCL_LINE */
-    }
-
-    // in case we were given an input larger than the RSA modulus
-    //    ret = mbedtls_mpi_mod_mpi(&x,&x,&key->N);
-    //    if (ret != 0) {
-    //        throw std::runtime_error("Error when reducing the RSA input mod
-    //        N"); /* LCOV_EXCL_LINE */
-    //    }
-
-    // calling mbedtls_rsa_public is not ideal here as it would require us to
-    // re-serialize the input
-
-#if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_lock(key->mutex) != 0)
-        throw std::runtime_error(
-            "Unable to lock the RSA context"); /* LCOV_EXCL_LINE */
-#endif
-
-    ret = mbedtls_mpi_exp_mod(&x, &x, &key->E, &key->N, &key->RN);
-
-
-#if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_unlock(key->mutex) != 0)
-        throw std::runtime_error(
-            "Unable to unlock the RSA context"); /* LCOV_EXCL_LINE */
-#endif
-
-    if (ret != 0) {
-        throw std::runtime_error(
-            "Error during the modular exponentiation"); /* LCOV_EXCL_LINE */
-    }
-
-    mbedtls_mpi_write_binary(&x, out.data(), out.size());
-
-    mbedtls_mpi_lset(&x, 0);
-    mbedtls_mpi_free(&x);
-
-    return out;
+    // x^(RSA_PK^order) is computed as order successive evaluations, each of
+    // them being 16 squarings and a multiplication in Montgomery form. This
+    // is faster than a generic modular exponentiation with the exponent
+    // RSA_PK^order, and only needs the modulus and its Montgomery constant.
+    return eval_iterated(in, order, nullptr);
 }
 
 
@@ -907,7 +1550,7 @@ void TdpMultPoolImpl_mbedTLS::eval_pool(const std::string& in,
 
 uint8_t TdpMultPoolImpl_mbedTLS::maximum_order() const
 {
-    return keys_count_ + 1;
+    return maximum_order_;
 }
 
 
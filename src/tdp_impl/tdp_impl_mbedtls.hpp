@@ -31,6 +31,7 @@
 #include <cstdint>
 
 #include <array>
+#include <memory>
 #include <string>
 
 namespace sse {
@@ -56,6 +57,10 @@ public:
     void eval(const std::string& in, std::string& out) const override;
     std::array<uint8_t, kMessageSpaceSize> eval(
         const std::array<uint8_t, kMessageSpaceSize>& in) const override;
+    std::array<uint8_t, kMessageSpaceSize> eval_iterated(
+        const std::array<uint8_t, kMessageSpaceSize>& in,
+        uint32_t                                      order,
+        const Tdp::iteration_callback_type&           callback) const override;
 
     std::string                            sample() const override;
     std::array<uint8_t, kMessageSpaceSize> sample_array() const override;
@@ -76,6 +81,10 @@ public:
 protected:
     TdpImpl_mbedTLS();
 
+    // Precomputes the Montgomery constant of the modulus. Must be called once
+    // the key is set.
+    void init_public_precomputations();
+
     // mbedTLS APIs don't seem to be really const-correct.
     // for the moment, use a mutable member instead of const_cast everywhere
     mutable mbedtls_rsa_context rsa_key_;
@@ -105,8 +114,67 @@ public:
                      std::string&       out,
                      uint32_t           order) const override;
 
+    void invert_batch(const std::array<uint8_t, kMessageSpaceSize>* in,
+                      std::array<uint8_t, kMessageSpaceSize>*       out,
+                      size_t count) const override;
+
 private:
+    // Cache of the CRT exponents used by invert_mult, indexed by order.
+    // Defined in tdp_impl_mbedtls.cpp
+    class CrtExponentCache;
+
+    // Even modulus M = 2^s * m, with m odd, used to compute the
+    // exponentiations modulo p-1 and q-1: the computation is done modulo m
+    // using the Montgomery exponentiation, and modulo 2^s separately.
+    class EvenModulus
+    {
+    public:
+        EvenModulus();
+        ~EvenModulus();
+
+        EvenModulus(const EvenModulus&) = delete;
+        EvenModulus& operator=(const EvenModulus&) = delete;
+
+        // Sets the modulus. Throws a std::runtime_error on failure.
+        void set(const mbedtls_mpi* M);
+
+        // Computes X = A^e mod M
+        int exp_mod(mbedtls_mpi* X, const mbedtls_mpi* A, uint32_t e) const;
+
+    private:
+        mbedtls_mpi odd_;     // m
+        mbedtls_mpi pow2_;    // 2^s
+        mbedtls_mpi odd_inv_; // m^-1 mod 2^s
+
+        // cached R^2 mod m. It is always computed by set(), so
+        // mbedtls_mpi_exp_mod never modifies it
+        mutable mbedtls_mpi rr_;
+    };
+
+    // Common initialization code of the constructors
+    void init_private_precomputations();
+
+    // RSA private operation, with blinding. Unlike mbedtls_rsa_private, it
+    // does not modify the key: the blinding values are kept per thread.
+    int rsa_private(const unsigned char* input, unsigned char* output) const;
+
+    // Same as rsa_private, for at most RSA_BATCH_LANES messages whose
+    // exponentiations are interleaved. See invert_batch.
+    int rsa_private_lanes(const std::array<uint8_t, kMessageSpaceSize>* in,
+                          std::array<uint8_t, kMessageSpaceSize>*       out,
+                          size_t count) const;
+
+    // Computes d_p = DP^order mod (p-1) and d_q = DQ^order mod (q-1), or
+    // fetch them from the cache
+    void crt_exponents(uint32_t     order,
+                       mbedtls_mpi* d_p,
+                       mbedtls_mpi* d_q) const;
+
     mbedtls_mpi phi_, p_1_, q_1_;
+
+    EvenModulus p_1_split_, q_1_split_;
+
+    std::unique_ptr<CrtExponentCache> crt_cache_;
 };
 
 class TdpMultPoolImpl_mbedTLS : public TdpImpl_mbedTLS,
@@ -132,9 +200,10 @@ public:
     std::unique_ptr<TdpMultPoolImpl> duplicate_pool() const override;
 
 private:
-    mbedtls_rsa_context* keys_;
-
-    uint8_t keys_count_;
+    // All the pool exponents are powers of RSA_PK, and share the modulus of
+    // rsa_key_: eval_pool iterates the evaluation instead of storing one RSA
+    // context per order.
+    uint8_t maximum_order_;
 };
 
 
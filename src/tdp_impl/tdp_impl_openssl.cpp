@@ -25,6 +25,7 @@
 
 #include "prf.hpp"
 #include "random.hpp"
+#include "utils.hpp"
 
 #include <cstring>
 
@@ -217,6 +218,7 @@ std::array<uint8_t, TdpImpl_OpenSSL::kMessageSpaceSize> TdpImpl_OpenSSL::eval(
 
     BIGNUM* y = BN_new();
 
+    stats::count(&Statistics::mod_exps);
     BN_mod_exp(y, x, get_rsa_key()->e, get_rsa_key()->n, ctx);
 
     // Unless there is a bug in OpenSSL, the number of bytes used by y, should
@@ -236,6 +238,24 @@ std::array<uint8_t, TdpImpl_OpenSSL::kMessageSpaceSize> TdpImpl_OpenSSL::eval(
     return out;
 }
 
+std::array<uint8_t, TdpImpl_OpenSSL::kMessageSpaceSize> TdpImpl_OpenSSL::
+    eval_iterated(const std::array<uint8_t, kMessageSpaceSize>& in,
+                  uint32_t                                      order,
+                  const Tdp::iteration_callback_type& callback) const
+{
+    // the OpenSSL implementation is deprecated: simply iterate eval
+    std::array<uint8_t, TdpImpl_OpenSSL::kMessageSpaceSize> out = in;
+
+    for (uint32_t i = 1; i <= order; i++) {
+        out = eval(out);
+        if (callback) {
+            callback(i, out);
+        }
+    }
+
+    return out;
+}
+
 
 std::string TdpImpl_OpenSSL::sample() const
 {
@@ -502,6 +522,8 @@ void TdpInverseImpl_OpenSSL::invert(const std::string& in,
                                     "be kMessageSpaceSize bytes long.");
     }
 
+    // RSA_private_decrypt uses the CRT: two exponentiations
+    stats::count(&Statistics::mod_exps, 2);
     ret = RSA_private_decrypt(static_cast<int>(in.size()),
                               reinterpret_cast<const unsigned char*>(in.data()),
                               rsa_out.data(),
@@ -524,6 +546,7 @@ std::array<uint8_t, TdpImpl_OpenSSL::kMessageSpaceSize> TdpInverseImpl_OpenSSL::
 {
     std::array<uint8_t, TdpImpl_OpenSSL::kMessageSpaceSize> out;
 
+    stats::count(&Statistics::mod_exps, 2);
     RSA_private_decrypt(static_cast<int>(in.size()),
                         in.data(),
                         out.data(),
@@ -557,6 +580,7 @@ TdpInverseImpl_OpenSSL::invert_mult(
     BIGNUM* d_q      = BN_new();
     BN_set_word(bn_order, order);
 
+    stats::count(&Statistics::mod_exps, 4);
     BN_mod_exp(d_p, get_rsa_key()->d, bn_order, p_1_, ctx);
     BN_mod_exp(d_q, get_rsa_key()->d, bn_order, q_1_, ctx);
 
@@ -610,6 +634,18 @@ void TdpInverseImpl_OpenSSL::invert_mult(const std::string& in,
     out = std::string(out_array.begin(), out_array.end());
 }
 
+void TdpInverseImpl_OpenSSL::invert_batch(
+    const std::array<uint8_t, kMessageSpaceSize>* in,
+    std::array<uint8_t, kMessageSpaceSize>*       out,
+    size_t                                        count) const
+{
+    // OpenSSL already amortizes the blinding: simply invert the messages one
+    // by one
+    for (size_t i = 0; i < count; i++) {
+        out[i] = invert(in[i]);
+    }
+}
+
 
 TdpMultPoolImpl_OpenSSL::TdpMultPoolImpl_OpenSSL(const std::string& sk,
                                                  const uint8_t      size)
@@ -696,6 +732,7 @@ TdpMultPoolImpl_OpenSSL::eval_pool(
             "positive.");
     }
 
+    stats::count(&Statistics::mod_exps);
     RSA_public_encrypt(static_cast<int>(in.size()),
                        in.data(),
                        out.data(),
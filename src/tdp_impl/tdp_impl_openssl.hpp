@@ -57,6 +57,10 @@ public:
     void eval(const std::string& in, std::string& out) const override;
     std::array<uint8_t, kMessageSpaceSize> eval(
         const std::array<uint8_t, kMessageSpaceSize>& in) const override;
+    std::array<uint8_t, kMessageSpaceSize> eval_iterated(
+        const std::array<uint8_t, kMessageSpaceSize>& in,
+        uint32_t                                      order,
+        const Tdp::iteration_callback_type&           callback) const override;
 
     std::string                            sample() const override;
     std::array<uint8_t, kMessageSpaceSize> sample_array() const override;
@@ -105,6 +109,10 @@ public:
                      std::string&       out,
                      uint32_t           order) const override;
 
+    void invert_batch(const std::array<uint8_t, kMessageSpaceSize>* in,
+                      std::array<uint8_t, kMessageSpaceSize>*       out,
+                      size_t count) const override;
+
 private:
     BIGNUM *phi_, *p_1_, *q_1_;
 };
@@ -0,0 +1,172 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "thread_pool.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace sse {
+
+namespace crypto {
+
+namespace {
+
+unsigned int hardware_threads()
+{
+    return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+// Persistent worker threads used by run_tasks. A worker keeps its
+// thread_local state (e.g. its RELIC context) until the end of the process:
+// parallel operations pay neither for the creation of threads nor for the
+// initialization of that state. There are at most as many workers as
+// hardware threads.
+class WorkerPool
+{
+public:
+    void run(std::vector<std::function<void()>>& tasks)
+    {
+        if (tasks.empty()) {
+            return;
+        }
+
+        Batch  batch;
+        size_t queued = 1;
+        batch.remaining = tasks.size();
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            add_workers(tasks.size() - 1);
+            try {
+                for (; queued < tasks.size(); queued++) {
+                    queue_.push_back(Task{&tasks[queued], &batch});
+                }
+            } catch (...) {
+                // out of memory: the tasks that could not be queued are run
+                // by the calling thread
+            }
+        }
+        for (size_t i = 1; i < queued; i++) {
+            work_cv_.notify_one();
+        }
+
+        tasks[0]();
+        for (size_t i = queued; i < tasks.size(); i++) {
+            tasks[i](); /* LCOV_EXCL_LINE */
+        }
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        batch.remaining -= 1 + (tasks.size() - queued);
+
+        // Help with the queued tasks, then wait for the ones that other
+        // threads are running. This way, the tasks are completed even if no
+        // worker is available (e.g. if they could not be started, or in a
+        // forked child), and nested batches cannot deadlock: when the caller
+        // waits, all the tasks of its batch are running.
+        while (!queue_.empty()) {
+            run_front(lock);
+        }
+        batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+    }
+
+private:
+    struct Batch
+    {
+        // number of tasks of the batch that are not done yet
+        size_t                  remaining{0};
+        std::condition_variable done;
+    };
+
+    struct Task
+    {
+        std::function<void()>* function;
+        Batch*                 batch;
+    };
+
+    // Starts workers until there are at least n of them, within the
+    // hardware limit. Called with mtx_ held.
+    void add_workers(size_t n) noexcept
+    {
+        n = std::min(n, static_cast<size_t>(hardware_threads()));
+        try {
+            workers_.reserve(n);
+            while (workers_.size() < n) {
+                workers_.emplace_back(&WorkerPool::worker_loop, this);
+            }
+        } catch (...) {
+            // no more threads: make do with the existing ones
+        }
+    }
+
+    // Runs the first queued task. Called with the lock held, which is
+    // released while the task runs.
+    void run_front(std::unique_lock<std::mutex>& lock)
+    {
+        const Task task = queue_.front();
+        queue_.pop_front();
+
+        lock.unlock();
+        (*task.function)();
+        lock.lock();
+
+        if (--task.batch->remaining == 0) {
+            // only the caller of run() waits on this variable
+            task.batch->done.notify_one();
+        }
+    }
+
+    void worker_loop()
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (true) {
+            work_cv_.wait(lock, [this]() { return !queue_.empty(); });
+            run_front(lock);
+        }
+    }
+
+    std::mutex               mtx_;
+    std::condition_variable  work_cv_;
+    std::deque<Task>         queue_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace
+
+unsigned int worker_thread_count(const unsigned int n_threads)
+{
+    const unsigned int max_threads = hardware_threads();
+    if (n_threads == 0) {
+        return max_threads;
+    }
+    return std::min(n_threads, max_threads);
+}
+
+void run_tasks(std::vector<std::function<void()>>& tasks)
+{
+    // The pool is never destroyed: its workers wait for tasks until the
+    // process exits.
+    static WorkerPool* pool = new WorkerPool;
+    pool->run(tasks);
+}
+
+} // namespace crypto
+} // namespace sse
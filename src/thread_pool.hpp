@@ -0,0 +1,88 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+#pragma once
+
+#include <cstddef>
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <vector>
+
+namespace sse {
+
+namespace crypto {
+
+/// Number of threads used by a parallel operation asking for n_threads
+/// threads: the number of hardware threads if n_threads is 0, and at most
+/// the number of hardware threads otherwise.
+unsigned int worker_thread_count(const unsigned int n_threads);
+
+/// Runs all the tasks, and returns once they are done. The first task runs
+/// in the calling thread, the other ones in a pool of worker threads (at
+/// most one per hardware thread) which persist from one call to the next:
+/// the thread_local state of the tasks (RELIC contexts, RSA blinding
+/// values, ...) is reused by the following calls.
+/// The tasks must not throw.
+void run_tasks(std::vector<std::function<void()>>& tasks);
+
+/// Splits [0, n) in n_threads contiguous chunks and calls f(t, begin, end) on
+/// the t-th chunk, in parallel (see run_tasks). If some calls throw, the
+/// first exception (in chunk order) is rethrown once all the chunks are done.
+template<class F>
+void parallel_chunks(const size_t n, unsigned int n_threads, F f)
+{
+    n_threads = static_cast<unsigned int>(
+        std::min(static_cast<size_t>(n_threads), n));
+    if (n_threads == 0) {
+        return;
+    }
+
+    std::vector<std::function<void()>> tasks;
+    std::vector<std::exception_ptr>    exceptions(n_threads);
+    const size_t                       chunk = n / n_threads;
+    const size_t                       rem   = n % n_threads;
+
+    tasks.reserve(n_threads);
+    size_t begin = 0;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        const size_t end = begin + chunk + ((t < rem) ? 1 : 0);
+
+        tasks.emplace_back([&f, &exceptions, t, begin, end]() {
+            try {
+                f(t, begin, end);
+            } catch (...) {
+                exceptions[t] = std::current_exception();
+            }
+        });
+        begin = end;
+    }
+
+    run_tasks(tasks);
+
+    for (const auto& e : exceptions) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+} // namespace crypto
+} // namespace sse
@@ -0,0 +1,445 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "utils.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace sse {
+namespace crypto {
+
+namespace trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+// Timestamps are read with RDTSC when available: the TSC is invariant on
+// the CPUs we target, and is much cheaper to read than the system clocks.
+// The ticks are converted to microseconds when the trace is dumped.
+inline uint64_t read_timestamp() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+inline int64_t clock_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct TraceEvent
+{
+    const char* name;
+    uint64_t    start;
+    uint64_t    end;
+};
+
+// Fixed capacity ring buffer of the spans recorded by a thread. It is only
+// written by its thread, without any lock, but it can be read (and cleared)
+// by any thread.
+// Every slot is protected by a sequence number: a reader skips the events
+// that are overwritten or being written while it reads them.
+class TraceRing
+{
+public:
+    TraceRing(uint32_t tid, size_t capacity)
+        : tid_(tid), capacity_(capacity), slots_(new Slot[capacity])
+    {
+    }
+
+    // Only called by the thread owning the ring
+    void push(const TraceEvent& event) noexcept
+    {
+        const uint64_t index = head_.load(std::memory_order_relaxed);
+        Slot&          slot  = slots_[index % capacity_];
+
+        // an odd sequence number marks a slot being written
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.name.store(event.name, std::memory_order_relaxed);
+        slot.start.store(event.start, std::memory_order_relaxed);
+        slot.end.store(event.end, std::memory_order_relaxed);
+
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+        head_.store(index + 1, std::memory_order_release);
+    }
+
+    // Recorded events, from the oldest to the most recent one
+    std::vector<TraceEvent> events() const
+    {
+        const uint64_t head  = head_.load(std::memory_order_acquire);
+        uint64_t       first = cleared_.load(std::memory_order_relaxed);
+        if (head - first > capacity_) {
+            first = head - capacity_;
+        }
+
+        std::vector<TraceEvent> result;
+        result.reserve(head - first);
+        for (uint64_t index = first; index < head; index++) {
+            const Slot&    slot = slots_[index % capacity_];
+            const uint64_t seq  = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * index + 2) {
+                // overwritten by a more recent event
+                continue;
+            }
+
+            TraceEvent event;
+            event.name  = slot.name.load(std::memory_order_relaxed);
+            event.start = slot.start.load(std::memory_order_relaxed);
+            event.end   = slot.end.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) {
+                // overwritten while it was read: the event might be torn
+                continue;
+            }
+            result.push_back(event);
+        }
+        return result;
+    }
+
+    // Hides the events recorded so far
+    void clear() noexcept
+    {
+        cleared_.store(head_.load(std::memory_order_acquire),
+                       std::memory_order_relaxed);
+    }
+
+    uint32_t tid() const noexcept
+    {
+        return tid_;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t>    seq{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t>    start{0};
+        std::atomic<uint64_t>    end{0};
+    };
+
+    const uint32_t          tid_;
+    const size_t            capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    // number of events pushed since the creation of the ring
+    std::atomic<uint64_t> head_{0};
+    // events before this index were cleared
+    std::atomic<uint64_t> cleared_{0};
+};
+
+// The rings of all the threads, so that they can be dumped from any thread,
+// even after their thread has exited. The registry holds the only reference
+// to the ring of an exited thread: such a ring is dropped once it has been
+// dumped, and at most kMaxExitedRings of them are kept (the oldest ones are
+// dropped first), so that the memory used by the registry does not grow
+// with the number of threads created by the process.
+struct TraceRegistry
+{
+    static constexpr size_t kMaxExitedRings = 64;
+
+    std::mutex                              mtx;
+    std::vector<std::shared_ptr<TraceRing>> rings;
+    uint32_t                                next_tid{1};
+
+    // Called with mtx held. Drops the rings of exited threads beyond
+    // kMaxExitedRings.
+    void prune_exited_rings()
+    {
+        size_t exited = 0;
+        for (const auto& ring : rings) {
+            exited += (ring.use_count() == 1) ? 1 : 0;
+        }
+        if (exited <= kMaxExitedRings) {
+            return;
+        }
+
+        size_t to_drop = exited - kMaxExitedRings;
+        auto   keep    = [&to_drop](const std::shared_ptr<TraceRing>& ring) {
+            if (to_drop > 0 && ring.use_count() == 1) {
+                to_drop--;
+                return false;
+            }
+            return true;
+        };
+        // the rings are in registration order: drop the oldest ones
+        rings.erase(std::stable_partition(rings.begin(), rings.end(), keep),
+                    rings.end());
+    }
+};
+
+constexpr size_t TraceRegistry::kMaxExitedRings;
+
+TraceRegistry& registry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+std::atomic<uint32_t> g_sampling_period{1};
+std::atomic<size_t>   g_events_per_thread{4096};
+
+// Reference points used to convert the timestamps to microseconds
+std::atomic<uint64_t> g_timestamp_origin{0};
+std::atomic<int64_t>  g_clock_origin{0};
+
+struct ThreadState
+{
+    std::shared_ptr<TraceRing> ring;
+    // number of started and not yet ended spans
+    uint32_t depth{0};
+    // number of top-level spans started by the thread
+    uint64_t roots{0};
+    // is the current top-level span sampled?
+    bool root_sampled{false};
+};
+
+thread_local ThreadState tls_state;
+
+std::shared_ptr<TraceRing> register_thread()
+{
+    TraceRegistry&              reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+
+    reg.prune_exited_rings();
+
+    std::shared_ptr<TraceRing> ring = std::make_shared<TraceRing>(
+        reg.next_tid++, g_events_per_thread.load(std::memory_order_relaxed));
+    reg.rings.push_back(ring);
+    return ring;
+}
+
+void write_json_string(std::ostream& out, const char* str)
+{
+    out << '"';
+    for (; *str != '\0'; str++) {
+        const char c = *str;
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+bool begin_span(uint64_t&  start,
+                const bool nested_only,
+                bool&      sampled) noexcept
+{
+    ThreadState& state = tls_state;
+    sampled            = false;
+
+    if (nested_only && state.depth == 0) {
+        return false;
+    }
+    if (state.depth++ == 0) {
+        const uint32_t period
+            = g_sampling_period.load(std::memory_order_relaxed);
+        state.root_sampled = (state.roots++ % period) == 0;
+    }
+    if (!state.root_sampled) {
+        return true;
+    }
+    if (!state.ring) {
+        try {
+            state.ring = register_thread();
+        } catch (...) {
+            /* LCOV_EXCL_START */
+            return true;
+            /* LCOV_EXCL_STOP */
+        }
+    }
+    start   = read_timestamp();
+    sampled = true;
+    return true;
+}
+
+void end_span(const char*    name,
+              const uint64_t start,
+              const bool     sampled) noexcept
+{
+    ThreadState& state = tls_state;
+
+    if (sampled) {
+        const uint64_t end = read_timestamp();
+        state.ring->push({name, start, end});
+    }
+    if (state.depth > 0) {
+        state.depth--;
+    }
+}
+
+} // namespace trace
+
+void enable_tracing(const uint32_t sampling_period,
+                    const size_t   events_per_thread)
+{
+    if (sampling_period == 0) {
+        throw std::invalid_argument("Invalid sampling period: 0");
+    }
+    if (events_per_thread == 0) {
+        throw std::invalid_argument("Invalid ring buffer capacity: 0");
+    }
+
+    trace::g_sampling_period.store(sampling_period);
+    trace::g_events_per_thread.store(events_per_thread);
+
+    // The conversion of the timestamps is more accurate when the reference
+    // points are far apart: only set them once
+    uint64_t expected = 0;
+    if (trace::g_timestamp_origin.compare_exchange_strong(
+            expected, trace::read_timestamp())) {
+        trace::g_clock_origin.store(trace::clock_ns());
+    }
+
+    trace::g_enabled.store(true);
+}
+
+void disable_tracing() noexcept
+{
+    trace::g_enabled.store(false);
+}
+
+bool tracing_enabled() noexcept
+{
+    return trace::g_enabled.load();
+}
+
+void dump_trace(std::ostream& out)
+{
+    trace::TraceRegistry& reg = trace::registry();
+
+    std::vector<std::shared_ptr<trace::TraceRing>> rings;
+    // rings of exited threads, which cannot record events anymore: they are
+    // dropped once dumped
+    std::vector<const trace::TraceRing*> exited;
+    {
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        rings = reg.rings;
+        for (const auto& ring : rings) {
+            // referenced by the registry and by rings only
+            if (ring.use_count() == 2) {
+                exited.push_back(ring.get());
+            }
+        }
+    }
+
+    // Estimate the frequency of the timestamps counter
+    const uint64_t timestamp_origin = trace::g_timestamp_origin.load();
+    const int64_t  clock_origin     = trace::g_clock_origin.load();
+    const uint64_t timestamp_now    = trace::read_timestamp();
+    const int64_t  clock_now        = trace::clock_ns();
+
+    double ticks_per_us = 1000.;
+    if (clock_now > clock_origin && timestamp_now > timestamp_origin) {
+        ticks_per_us
+            = 1000. * static_cast<double>(timestamp_now - timestamp_origin)
+              / static_cast<double>(clock_now - clock_origin);
+    }
+
+    const std::ios::fmtflags flags     = out.flags();
+    const std::streamsize    precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& ring : rings) {
+        for (const trace::TraceEvent& event : ring->events()) {
+            const double ts
+                = static_cast<double>(
+                      static_cast<int64_t>(event.start - timestamp_origin))
+                  / ticks_per_us;
+            const double dur
+                = static_cast<double>(event.end - event.start) / ticks_per_us;
+
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            trace::write_json_string(out, event.name);
+            out << ",\"cat\":\"sse_crypto\",\"ph\":\"X\",\"pid\":" << getpid()
+                << ",\"tid\":" << ring->tid() << ",\"ts\":" << ts
+                << ",\"dur\":" << dur << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+
+    if (!exited.empty()) {
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        auto                        dumped
+            = [&exited](const std::shared_ptr<trace::TraceRing>& ring) {
+                  return std::find(exited.begin(), exited.end(), ring.get())
+                         != exited.end();
+              };
+        reg.rings.erase(
+            std::remove_if(reg.rings.begin(), reg.rings.end(), dumped),
+            reg.rings.end());
+    }
+}
+
+void clear_trace()
+{
+    trace::TraceRegistry&       reg = trace::registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+
+    std::vector<std::shared_ptr<trace::TraceRing>> live_rings;
+    for (auto& ring : reg.rings) {
+        // the registry holds the only reference to the rings of the threads
+        // that exited: drop them
+        if (ring.use_count() > 1) {
+            ring->clear();
+            live_rings.push_back(std::move(ring));
+        }
+    }
+    reg.rings = std::move(live_rings);
+}
+
+} // namespace crypto
+} // namespace sse
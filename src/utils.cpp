@@ -20,6 +20,7 @@
 
 #include "utils.hpp"
 
+#include "hash/sha512.hpp"
 #include "ppke/relic_wrapper/relic_api.h"
 #include "prp.hpp"
 
@@ -223,6 +224,7 @@ void init_crypto_lib()
     sodium_set_misuse_handler(sodium_misuse_handler);
 
     Prp::compute_is_available();
+    hash::sha512::compute_x4_implementation();
 }
 
 void cleanup_crypto_lib()
@@ -233,6 +235,24 @@ void cleanup_crypto_lib()
     kill_locks();
 }
 
+namespace stats {
+Statistics& thread_statistics() noexcept
+{
+    thread_local Statistics statistics;
+    return statistics;
+}
+} // namespace stats
+
+Statistics statistics_snapshot() noexcept
+{
+    return stats::thread_statistics();
+}
+
+void reset_statistics() noexcept
+{
+    stats::thread_statistics() = Statistics();
+}
+
 // The next function is a clone of strstr with strong bounds guarantee,
 // similarly to strncmp vs. strcmp
 // Solution copied from https://stackoverflow.com/a/13451104
@@ -20,7 +20,15 @@
 
 #include "wrapper.hpp"
 
+#include "utils.hpp"
+
+#include <cstring>
+
+#include <algorithm>
+#include <new>
+
 #include <sodium/crypto_stream_chacha20.h>
+#include <sodium/utils.h>
 
 namespace sse {
 namespace crypto {
@@ -50,5 +58,78 @@ Wrapper::Wrapper(Key<kKeySize>&& key)
     derivation_input[0] = 0x02;
     encryption_key_     = kdf.derive_key(derivation_input);
 }
+
+std::array<uint8_t, Wrapper::kTagSize> Wrapper::metadata_tag(
+    const uint8_t* in,
+    const size_t   in_size) const
+{
+    static constexpr uint8_t kLabel[kRandomIVSize] = {'w', 'r', 'a', 'p',
+                                                      'p', 'e', 'r', ' ',
+                                                      'm', 'e', 't', 'a',
+                                                      'd', 'a', 't', 'a'};
+
+    std::vector<uint8_t> buffer(kRandomIVSize + 1 + in_size);
+    memcpy(buffer.data(), kLabel, kRandomIVSize);
+    buffer[kRandomIVSize] = kDefaultTypeByte;
+    if (in_size > 0) {
+        memcpy(buffer.data() + kRandomIVSize + 1, in, in_size);
+    }
+
+    return tag_generator_.prf(buffer.data(), buffer.size());
+}
+
+namespace {
+// Secure buffer, grown on demand, used as the staging buffer of the wrapping
+// operations of a thread
+class ScratchArena
+{
+public:
+    ScratchArena() = default;
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    ~ScratchArena()
+    {
+        // sodium_free wipes the memory
+        sodium_free(buffer_);
+    }
+
+    uint8_t* get(const size_t size)
+    {
+        if (size > capacity_) {
+            const size_t new_capacity
+                = std::max(size, std::max(2 * capacity_, kMinCapacity));
+
+            auto* buffer = static_cast<uint8_t*>(sodium_malloc(new_capacity));
+            stats::count(&Statistics::secure_allocations);
+            if (buffer == nullptr) {
+                /* LCOV_EXCL_START */
+                throw std::bad_alloc();
+                /* LCOV_EXCL_STOP */
+            }
+            sodium_free(buffer_);
+            buffer_   = buffer;
+            capacity_ = new_capacity;
+        }
+        return buffer_;
+    }
+
+private:
+    static constexpr size_t kMinCapacity = 256;
+
+    uint8_t* buffer_{nullptr};
+    size_t   capacity_{0};
+};
+
+constexpr size_t ScratchArena::kMinCapacity;
+} // namespace
+
+uint8_t* Wrapper::scratch_buffer(const size_t size)
+{
+    thread_local ScratchArena arena;
+    return arena.get(size);
+}
+
 } // namespace crypto
 } // namespace sse
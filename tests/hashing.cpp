@@ -32,6 +32,9 @@
 
 #include <sse/crypto/hash.hpp>
 
+#include <cstring>
+
+#include <algorithm>
 #include <array>
 #include <iomanip>
 #include <iostream>
@@ -198,6 +201,114 @@ TEST(blake2, blake2b)
     }
 }
 
+// Hash the input in chunks of chunk_len bytes with the incremental interface
+template<class H>
+static string incremental_hash(const uint8_t* in,
+                               const size_t   len,
+                               const size_t   chunk_len)
+{
+    typename H::state_type state;
+    uint8_t                digest[H::kDigestSize];
+
+    H::init(state);
+    for (size_t offset = 0; offset < len; offset += chunk_len) {
+        H::update(state, in + offset, std::min(chunk_len, len - offset));
+    }
+    H::final(state, digest);
+
+    return string(reinterpret_cast<const char*>(digest), H::kDigestSize);
+}
+
+template<class H>
+static void test_incremental_hash()
+{
+    constexpr size_t IN_LENGTH = 1000;
+
+    uint8_t in[IN_LENGTH];
+    uint8_t hash[H::kDigestSize];
+
+    for (size_t i = 0; i < sizeof(in); ++i) {
+        in[i] = static_cast<uint8_t>(i);
+    }
+
+    for (size_t len : {0, 1, 127, 128, 129, 1000}) {
+        H::hash(in, len, hash);
+        string ref(reinterpret_cast<const char*>(hash), H::kDigestSize);
+
+        for (size_t chunk_len : {1, 7, 64, 128, 1000}) {
+            ASSERT_EQ(ref, incremental_hash<H>(in, len, chunk_len));
+        }
+    }
+}
+
+TEST(sha_512, incremental)
+{
+    test_incremental_hash<sse::crypto::hash::sha512>();
+}
+
+TEST(sha_512, multi_buffer)
+{
+    using sse::crypto::hash::sha512;
+
+    constexpr size_t IN_LENGTH = 1000;
+
+    uint8_t in[sha512::kLanes][IN_LENGTH];
+    uint8_t hash[sha512::kLanes][sha512::kDigestSize];
+    uint8_t ref[sha512::kDigestSize];
+
+    const unsigned char* in_ptrs[sha512::kLanes];
+    unsigned char*       hash_ptrs[sha512::kLanes];
+
+    for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+        for (size_t i = 0; i < IN_LENGTH; ++i) {
+            in[lane][i] = static_cast<uint8_t>(i * (lane + 1));
+        }
+        in_ptrs[lane]   = in[lane];
+        hash_ptrs[lane] = hash[lane];
+    }
+
+    for (auto impl : {sha512::x4_implementation::portable,
+                      sha512::x4_implementation::avx2}) {
+        if (!sha512::set_x4_implementation(impl)) {
+            continue;
+        }
+        ASSERT_EQ(impl, sha512::get_x4_implementation());
+
+        for (size_t len : {0, 1, 111, 112, 127, 128, 129, 256, 1000}) {
+            sha512::hash_x4(in_ptrs, len, hash_ptrs);
+
+            for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+                sha512::hash(in[lane], len, ref);
+                ASSERT_EQ(0, memcmp(ref, hash[lane], sha512::kDigestSize));
+            }
+
+            // fragmented input
+            sha512::state_x4_type state;
+            sha512::init_x4(state);
+            for (size_t offset = 0; offset < len; offset += 7) {
+                const unsigned char* chunk[sha512::kLanes];
+                for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+                    chunk[lane] = in[lane] + offset;
+                }
+                sha512::update_x4(
+                    state, chunk, std::min<size_t>(7, len - offset));
+            }
+            sha512::final_x4(state, hash_ptrs);
+
+            for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+                sha512::hash(in[lane], len, ref);
+                ASSERT_EQ(0, memcmp(ref, hash[lane], sha512::kDigestSize));
+            }
+        }
+    }
+
+    sha512::compute_x4_implementation();
+}
+
+TEST(blake2, incremental)
+{
+    test_incremental_hash<sse::crypto::hash::blake2b>();
+}
 
 TEST(hash, consistency)
 {
@@ -263,3 +374,62 @@ TEST(hash, exceptions)
                                 NULL),
         std::invalid_argument);
 }
+
+TEST(hash, state)
+{
+    const std::string prefix  = "common prefix of the messages ";
+    const std::string suffix1 = "first suffix";
+    const std::string suffix2 = "second suffix";
+
+    sse::crypto::Hash::State empty_state;
+    ASSERT_EQ(sse::crypto::Hash::hash(""), empty_state.final());
+
+    sse::crypto::Hash::State prefix_state;
+    prefix_state.update(prefix.substr(0, 10));
+    prefix_state.update(nullptr, 0);
+    prefix_state.update(prefix.substr(10));
+
+    // clone the state to hash two messages sharing the same prefix
+    sse::crypto::Hash::State state1(prefix_state);
+    sse::crypto::Hash::State state2 = prefix_state;
+    state1.update(suffix1);
+    state2.update(reinterpret_cast<const uint8_t*>(suffix2.data()),
+                  suffix2.size());
+
+    ASSERT_EQ(sse::crypto::Hash::hash(prefix + suffix1), state1.final());
+    ASSERT_EQ(sse::crypto::Hash::hash(prefix + suffix2), state2.final());
+    ASSERT_EQ(sse::crypto::Hash::hash(prefix), prefix_state.final());
+
+    // truncated outputs
+    for (size_t i = 0; i <= sse::crypto::Hash::kDigestSize; i++) {
+        std::array<uint8_t, sse::crypto::Hash::kDigestSize> out;
+        sse::crypto::Hash::State                            state;
+        state.update(prefix);
+        state.final(out.data(), i);
+
+        ASSERT_EQ(sse::crypto::Hash::hash(prefix, i),
+                  std::string(out.begin(), out.begin() + i));
+    }
+
+    // reset
+    state1.reset();
+    state1.update(suffix1);
+    ASSERT_EQ(sse::crypto::Hash::hash(suffix1), state1.final());
+}
+
+TEST(hash, state_exceptions)
+{
+    std::array<uint8_t, sse::crypto::Hash::kDigestSize> out;
+    sse::crypto::Hash::State                            state;
+
+    ASSERT_THROW(state.update(nullptr, 1), std::invalid_argument);
+    ASSERT_THROW(state.final(nullptr), std::invalid_argument);
+    ASSERT_THROW(state.final(out.data(), sse::crypto::Hash::kDigestSize + 1),
+                 std::invalid_argument);
+
+    state.final(out.data());
+
+    ASSERT_THROW(state.update("abc"), std::runtime_error);
+    ASSERT_THROW(state.final(out.data()), std::runtime_error);
+    ASSERT_THROW(state.final(), std::runtime_error);
+}
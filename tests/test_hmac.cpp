@@ -35,6 +35,8 @@
 #include <sse/crypto/hmac.hpp>
 #include <sse/crypto/key.hpp>
 
+#include <algorithm>
+#include <array>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -69,6 +71,17 @@ TEST(hmac_sha_512, test_vector_1)
 
 
     ASSERT_EQ(result_64, reference);
+
+    // same evaluation, with a raw key (the Key constructor erased k)
+    k.fill(0x0b);
+    array<uint8_t, 64> raw_result;
+    HMAC_SHA512<20>::hmac_raw_key(
+        k.data(),
+        reinterpret_cast<const unsigned char*>(in.data()),
+        in.size(),
+        raw_result.data(),
+        raw_result.size());
+    ASSERT_EQ(raw_result, reference);
 }
 
 // Comment the next test as HMac explicitely takes keys larger than 16 bytes
@@ -172,4 +185,70 @@ TEST(hmac, exception)
     ASSERT_THROW(hmac.hmac(&c, 1, nullptr), std::invalid_argument);
     ASSERT_THROW(hmac.hmac(&c, 1, &c, HMAC_SHA512<25>::kDigestSize + 10),
                  std::invalid_argument);
+
+    array<uint8_t, 25> k;
+    k.fill(0x00);
+    ASSERT_THROW(HMAC_SHA512<25>::hmac_raw_key(nullptr, &c, 1, &c, 1),
+                 std::invalid_argument);
+    ASSERT_THROW(HMAC_SHA512<25>::hmac_raw_key(k.data(), nullptr, 0, &c, 1),
+                 std::invalid_argument);
+    ASSERT_THROW(HMAC_SHA512<25>::hmac_raw_key(k.data(), &c, 1, nullptr, 1),
+                 std::invalid_argument);
+    ASSERT_THROW(HMAC_SHA512<25>::hmac_raw_key(
+                     k.data(), &c, 1, &c, HMAC_SHA512<25>::kDigestSize + 1),
+                 std::invalid_argument);
+}
+
+TEST(hmac, multi_buffer)
+{
+    using sse::crypto::hash::sha512;
+
+    HMAC_SHA512<25> hmac;
+
+    for (auto impl : {sha512::x4_implementation::portable,
+                      sha512::x4_implementation::avx2}) {
+        if (!sha512::set_x4_implementation(impl)) {
+            continue;
+        }
+
+        for (size_t len : {0, 1, 64, 111, 112, 128, 1000}) {
+            string               inputs[sha512::kLanes];
+            const unsigned char* in[sha512::kLanes];
+            array<uint8_t, 64>   results[sha512::kLanes];
+            unsigned char*       out[sha512::kLanes];
+
+            for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+                inputs[lane] = string(len, static_cast<char>('a' + lane));
+                in[lane]     = reinterpret_cast<const unsigned char*>(
+                    inputs[lane].data());
+                out[lane] = results[lane].data();
+            }
+
+            hmac.hmac_x4(in, len, out);
+
+            for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+                ASSERT_EQ(hmac.hmac(inputs[lane]), results[lane]);
+            }
+
+            // truncated outputs
+            hmac.hmac_x4(in, len, out, 10);
+            for (size_t lane = 0; lane < sha512::kLanes; lane++) {
+                auto ref = hmac.hmac(inputs[lane]);
+                ASSERT_TRUE(
+                    std::equal(ref.begin(), ref.begin() + 10, out[lane]));
+            }
+        }
+    }
+    sha512::compute_x4_implementation();
+
+    uint8_t              c;
+    const unsigned char* in[sha512::kLanes]  = {&c, &c, &c, nullptr};
+    unsigned char*       out[sha512::kLanes] = {&c, &c, &c, &c};
+    ASSERT_THROW(hmac.hmac_x4(in, 1, out), std::invalid_argument);
+    in[3]  = &c;
+    out[0] = nullptr;
+    ASSERT_THROW(hmac.hmac_x4(in, 1, out), std::invalid_argument);
+    out[0] = &c;
+    ASSERT_THROW(hmac.hmac_x4(in, 1, out, HMAC_SHA512<25>::kDigestSize + 1),
+                 std::invalid_argument);
 }
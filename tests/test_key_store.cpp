@@ -0,0 +1,300 @@
+//
+// libsse_crypto - An abstraction layer for high level cryptographic features.
+// Copyright (C) 2015-2017 Raphael Bost
+//
+// This file is part of libsse_crypto.
+//
+// libsse_crypto is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as
+// published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// libsse_crypto is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <sse/crypto/key_store.hpp>
+#include <sse/crypto/prf.hpp>
+#include <sse/crypto/prg.hpp>
+#include <sse/crypto/wrapper.hpp>
+
+#include <cstdio>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace tests {
+
+constexpr size_t kStorePrfCount = 50;
+constexpr size_t kStorePrgCount = 5;
+
+// Writes a store with kStorePrfCount Prf<32> objects, followed by
+// kStorePrgCount Prg objects, and returns the objects' outputs on input
+static std::vector<std::string> build_test_store(
+    const sse::crypto::Wrapper& wrapper,
+    const std::string&          path,
+    const std::string&          input)
+{
+    std::vector<std::string> outputs;
+
+    sse::crypto::WrappedKeyStoreBuilder builder(wrapper);
+    for (size_t i = 0; i < kStorePrfCount; i++) {
+        sse::crypto::Prf<32> prf;
+        EXPECT_EQ(i, builder.add(prf));
+
+        auto out = prf.prf(input);
+        outputs.emplace_back(out.begin(), out.end());
+    }
+    for (size_t i = 0; i < kStorePrgCount; i++) {
+        sse::crypto::Prg prg((sse::crypto::Key<sse::crypto::Prg::kKeySize>()));
+        builder.add(prg);
+
+        outputs.push_back(prg.derive(32));
+    }
+    EXPECT_EQ(kStorePrfCount + kStorePrgCount, builder.size());
+
+    builder.write(path);
+
+    return outputs;
+}
+
+static void write_file(const std::string& path, const std::string& content)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+static std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+}
+
+} // namespace tests
+
+TEST(key_store, lazy_unwrapping)
+{
+    const std::string path  = "test_key_store.bin";
+    const std::string input = "input";
+
+    sse::crypto::Wrapper wrapper(
+        (sse::crypto::Key<sse::crypto::Wrapper::kKeySize>()));
+
+    const std::vector<std::string> outputs
+        = tests::build_test_store(wrapper, path, input);
+
+    const size_t                 capacity = 8;
+    sse::crypto::WrappedKeyStore store(path, wrapper, capacity);
+
+    ASSERT_EQ(outputs.size(), store.size());
+    ASSERT_EQ(0U, store.cached_count());
+
+    for (size_t i = 0; i < tests::kStorePrfCount; i++) {
+        auto prf = store.get<sse::crypto::Prf<32>>(i);
+        auto out = prf->prf(input);
+        ASSERT_EQ(outputs[i], std::string(out.begin(), out.end()));
+        ASSERT_LE(store.cached_count(), capacity);
+    }
+    for (size_t i = tests::kStorePrfCount; i < store.size(); i++) {
+        auto prg = store.get<sse::crypto::Prg>(i);
+        ASSERT_EQ(outputs[i], prg->derive(32));
+    }
+    ASSERT_EQ(capacity, store.cached_count());
+
+    // released objects are handed out again instead of being unwrapped
+    const sse::crypto::Prg* released = nullptr;
+    {
+        auto last = store.get<sse::crypto::Prg>(store.size() - 1);
+        released  = last.get();
+    }
+    auto last = store.get<sse::crypto::Prg>(store.size() - 1);
+    ASSERT_EQ(released, last.get());
+    ASSERT_EQ(capacity - 1, store.cached_count());
+
+    // an object is never handed out to two callers at the same time
+    auto other = store.get<sse::crypto::Prg>(store.size() - 1);
+    ASSERT_NE(last, other);
+    ASSERT_EQ(outputs.back(), other->derive(32));
+    last.reset();
+    other.reset();
+    ASSERT_EQ(capacity, store.cached_count());
+
+    // evicted objects are unwrapped again when needed
+    for (size_t i = 1; i <= capacity; i++) {
+        store.get<sse::crypto::Prf<32>>(i);
+    }
+    auto first = store.get<sse::crypto::Prf<32>>(0);
+    ASSERT_EQ(capacity, store.cached_count());
+    auto out_first = first->prf(input);
+    ASSERT_EQ(outputs[0], std::string(out_first.begin(), out_first.end()));
+
+    // the objects stay valid when the store is destroyed
+    {
+        sse::crypto::WrappedKeyStore short_lived(path, wrapper, capacity);
+        first = short_lived.get<sse::crypto::Prf<32>>(0);
+    }
+    ASSERT_EQ(out_first, first->prf(input));
+
+    // without cache
+    sse::crypto::WrappedKeyStore uncached_store(path, wrapper, 0);
+    auto prf = uncached_store.get<sse::crypto::Prf<32>>(3);
+    auto out = prf->prf(input);
+    ASSERT_EQ(outputs[3], std::string(out.begin(), out.end()));
+    ASSERT_EQ(0U, uncached_store.cached_count());
+
+    std::remove(path.c_str());
+}
+
+TEST(key_store, concurrent_access)
+{
+    const std::string path  = "test_key_store_concurrent.bin";
+    const std::string input = "input";
+
+    sse::crypto::Wrapper wrapper(
+        (sse::crypto::Key<sse::crypto::Wrapper::kKeySize>()));
+
+    const std::vector<std::string> outputs
+        = tests::build_test_store(wrapper, path, input);
+
+    sse::crypto::WrappedKeyStore store(path, wrapper, 4);
+
+    // every thread gets its own objects, and can use them right away
+    constexpr size_t kThreads = 4;
+    constexpr size_t kQueries = 200;
+
+    std::vector<std::thread> threads;
+    std::vector<size_t>      mismatches(kThreads, 0);
+    for (size_t t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (size_t j = 0; j < kQueries; j++) {
+                const size_t i   = (t * 7 + j * 3) % tests::kStorePrfCount;
+                auto         prf = store.get<sse::crypto::Prf<32>>(i);
+                auto         out = prf->prf(input);
+                if (outputs[i] != std::string(out.begin(), out.end())) {
+                    mismatches[t]++;
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    for (size_t t = 0; t < kThreads; t++) {
+        ASSERT_EQ(0U, mismatches[t]);
+    }
+    ASSERT_LE(store.cached_count(), 4U);
+
+    std::remove(path.c_str());
+}
+
+TEST(key_store, exceptions)
+{
+    const std::string path = "test_key_store_exceptions.bin";
+
+    sse::crypto::Wrapper wrapper(
+        (sse::crypto::Key<sse::crypto::Wrapper::kKeySize>()));
+    tests::build_test_store(wrapper, path, "input");
+
+    {
+        sse::crypto::WrappedKeyStore store(path, wrapper);
+
+        ASSERT_THROW(store.get<sse::crypto::Prf<32>>(store.size()),
+                     std::out_of_range);
+        // wrong class
+        ASSERT_THROW(store.get<sse::crypto::Prg>(0), std::invalid_argument);
+        // same type byte, but different public context
+        ASSERT_THROW(store.get<sse::crypto::Prf<16>>(0), std::runtime_error);
+        store.get<sse::crypto::Prf<32>>(0);
+        ASSERT_THROW(store.get<sse::crypto::Prf<16>>(0),
+                     std::invalid_argument);
+
+        // another wrapper cannot open the store
+        sse::crypto::Wrapper other_wrapper(
+            (sse::crypto::Key<sse::crypto::Wrapper::kKeySize>()));
+        ASSERT_THROW(sse::crypto::WrappedKeyStore(path, other_wrapper),
+                     std::runtime_error);
+    }
+
+    const std::string content = tests::read_file(path);
+
+    // invalid files
+    ASSERT_THROW(sse::crypto::WrappedKeyStore("does_not_exist.bin", wrapper),
+                 std::runtime_error);
+
+    tests::write_file(path, content.substr(0, 10));
+    ASSERT_THROW(sse::crypto::WrappedKeyStore(path, wrapper),
+                 std::invalid_argument);
+
+    std::string bad_magic = content;
+    bad_magic[0]          = 'X';
+    tests::write_file(path, bad_magic);
+    ASSERT_THROW(sse::crypto::WrappedKeyStore(path, wrapper),
+                 std::invalid_argument);
+
+    std::string bad_version = content;
+    bad_version[4]          = 0x7F;
+    tests::write_file(path, bad_version);
+    ASSERT_THROW(sse::crypto::WrappedKeyStore(path, wrapper),
+                 std::invalid_argument);
+
+    // the index does not fit in the file
+    tests::write_file(path, content.substr(0, 16 + 16 * 3));
+    ASSERT_THROW(sse::crypto::WrappedKeyStore(path, wrapper),
+                 std::invalid_argument);
+
+    // the last entry does not fit in the file
+    tests::write_file(path, content.substr(0, content.size() - 1));
+    ASSERT_THROW(sse::crypto::WrappedKeyStore(path, wrapper),
+                 std::invalid_argument);
+
+    // the index is authenticated: swapping two entries of the same class,
+    // or changing the type or the length of an entry, is detected
+    constexpr size_t kEntrySize = 16;
+    std::string      swapped    = content;
+    for (size_t i = 0; i < kEntrySize; i++) {
+        std::swap(swapped[16 + i], swapped[16 + kEntrySize + i]);
+    }
+    tests::write_file(path, swapped);
+    ASSERT_THROW(sse::crypto::WrappedKeyStore(path, wrapper),
+                 std::runtime_error);
+
+    std::string bad_type = content;
+    bad_type[16 + 12] ^= 0x01;
+    tests::write_file(path, bad_type);
+    ASSERT_THROW(sse::crypto::WrappedKeyStore(path, wrapper),
+                 std::runtime_error);
+
+    std::string bad_length = content;
+    bad_length[16 + 8] ^= 0x01;
+    tests::write_file(path, bad_length);
+    ASSERT_THROW(sse::crypto::WrappedKeyStore(path, wrapper),
+                 std::runtime_error);
+
+    // the destination of write() must be writable
+    sse::crypto::WrappedKeyStoreBuilder builder(wrapper);
+    ASSERT_THROW(builder.write("does_not_exist/test_key_store.bin"),
+                 std::runtime_error);
+
+    // corrupted objects are only detected when they are unwrapped
+    std::string corrupted = content;
+    corrupted[corrupted.size() - 1] ^= 0x01;
+    tests::write_file(path, corrupted);
+    sse::crypto::WrappedKeyStore store(path, wrapper);
+    store.get<sse::crypto::Prf<32>>(0);
+    ASSERT_THROW(store.get<sse::crypto::Prg>(store.size() - 1),
+                 std::runtime_error);
+
+    std::remove(path.c_str());
+}
@@ -21,11 +21,16 @@
 #include "ppke/GMPpke.hpp"
 
 #include <sse/crypto/puncturable_enc.hpp>
+#include <sse/crypto/utils.hpp>
 
+#include <cstring>
+
+#include <atomic>
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include "gtest/gtest.h"
 
@@ -124,6 +129,30 @@ static sse::crypto::tag_type test_encryption_tag(uint64_t i)
     return tag;
 }
 
+// Master key whose i-th byte is factor * i
+static sse::crypto::punct::master_key_type test_master_key(uint8_t factor)
+{
+    std::array<uint8_t, sse::crypto::punct::kMasterKeySize> master_key;
+    for (size_t i = 0; i < master_key.size(); i++) {
+        master_key[i] = static_cast<uint8_t>(factor * i);
+    }
+    return sse::crypto::punct::master_key_type(master_key.data());
+}
+
+// Key punctured on test_punctured_tag(0), ..., test_punctured_tag(p_count-1)
+static sse::crypto::punct::punctured_key_type test_punctured_key(
+    sse::crypto::PuncturableEncryption& encryptor,
+    const size_t                        p_count)
+{
+    sse::crypto::punct::punctured_key_type punctured_key;
+    punctured_key.push_back(encryptor.initial_keyshare(p_count));
+    for (size_t p = 0; p < p_count; p++) {
+        punctured_key.push_back(
+            encryptor.inc_puncture(p + 1, test_punctured_tag(p)));
+    }
+    return punctured_key;
+}
+
 TEST(relic, serialization_ZR)
 {
     for (size_t i = 0; i < SERIALIZATION_TEST_COUNT; i++) {
@@ -430,6 +459,122 @@ TEST(relic, pairing)
     }
 }
 
+TEST(relic, fixed_base_exponentiation)
+{
+    relicxx::PairingGroup group;
+
+    std::vector<relicxx::ZR> exponents = {relicxx::ZR(0), relicxx::ZR(1)};
+    for (size_t i = 0; i < ARITHMETIC_TEST_COUNT; i++) {
+        exponents.push_back(group.randomZR());
+    }
+
+    const relicxx::G2      g2 = group.randomG2();
+    const relicxx::GT      gt = group.randomGT();
+    const relicxx::G2Table g2_table(g2);
+    const relicxx::GTTable gt_table(gt);
+
+    for (const auto& r : exponents) {
+        ASSERT_EQ(group.exp(group.generatorG1(), r), group.expGeneratorG1(r));
+        ASSERT_EQ(group.exp(group.generatorG2(), r), group.expGeneratorG2(r));
+        ASSERT_EQ(group.exp(group.generatorGT(), r), group.expGeneratorGT(r));
+
+        ASSERT_EQ(group.exp(g2, r), group.exp(g2_table, r));
+        ASSERT_EQ(group.exp(gt, r), group.exp(gt_table, r));
+    }
+}
+
+TEST(relic, multi_pairing)
+{
+    relicxx::PairingGroup group;
+
+    for (size_t n : {1, 2, 5, 17}) {
+        std::vector<relicxx::G1> g1(n);
+        std::vector<relicxx::G2> g2(n);
+        relicxx::GT              prod;
+
+        for (size_t i = 0; i < n; i++) {
+            g1[i] = group.randomG1();
+            g2[i] = group.randomG2();
+            prod  = group.mul(prod, group.pair(g1[i], g2[i]));
+        }
+        ASSERT_EQ(prod, group.multiPair(g1, g2));
+
+        // division using negated points
+        relicxx::G1 a = group.randomG1();
+        relicxx::G2 b = group.randomG2();
+        g1.push_back(group.inv(a));
+        g2.push_back(b);
+        ASSERT_EQ(group.div(prod, group.pair(a, b)), group.multiPair(g1, g2));
+    }
+
+    ASSERT_EQ(relicxx::GT(), group.multiPair({}, {}));
+    ASSERT_THROW(group.multiPair({group.randomG1()}, {}),
+                 std::invalid_argument);
+}
+
+TEST(relic, batch_inverse)
+{
+    relicxx::PairingGroup group;
+
+    for (size_t n : {1, 2, 3, 16}) {
+        std::vector<relicxx::ZR> values(n);
+        for (auto& v : values) {
+            v = group.randomZR();
+        }
+
+        std::vector<relicxx::ZR> inverses = values;
+        sse::crypto::BatchInverse(group, inverses);
+
+        for (size_t i = 0; i < n; i++) {
+            ASSERT_EQ(group.inv(values[i]), inverses[i]);
+        }
+
+        // a zero value is rejected, and the values are left untouched
+        values[n / 2] = relicxx::ZR(0);
+
+        std::vector<relicxx::ZR> with_zero = values;
+        ASSERT_THROW(sse::crypto::BatchInverse(group, with_zero),
+                     std::logic_error);
+        ASSERT_EQ(values, with_zero);
+    }
+
+    std::vector<relicxx::ZR> empty;
+    sse::crypto::BatchInverse(group, empty);
+    ASSERT_TRUE(empty.empty());
+}
+
+TEST(relic, operation_counters)
+{
+    relicxx::PairingGroup group;
+
+    const relicxx::G1 g1 = group.randomG1();
+    const relicxx::G2 g2 = group.randomG2();
+    const relicxx::ZR r  = group.randomZR();
+
+    std::vector<uint8_t> bytes = g2.getBytes(true);
+
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+
+    group.pair(g1, g2);
+    group.multiPair({g1, g1, g1}, {g2, g2, g2});
+    group.exp(g1, r);
+    group.exp(g2, r);
+    group.expGeneratorG2(r);
+    relicxx::G2 compressed(bytes.data(), true);
+
+    const sse::crypto::Statistics after = sse::crypto::statistics_snapshot();
+
+    ASSERT_EQ(g2, compressed);
+    if (sse::crypto::statistics_enabled()) {
+        ASSERT_EQ(4U, after.pairings - before.pairings);
+        ASSERT_EQ(3U, after.exponentiations - before.exponentiations);
+        ASSERT_EQ(1U, after.decompressions - before.decompressions);
+    } else {
+        ASSERT_EQ(0U, after.pairings + after.exponentiations
+                          + after.decompressions);
+    }
+}
+
 TEST(ppke, serialization)
 {
     //    std::array<uint8_t, sse::crypto::Gmppke::kPRFKeySize> master_key;
@@ -529,6 +674,8 @@ TEST(ppke, probabilitic_correctness)
             }
         }
 
+        const sse::crypto::GmppkeDecryptionKey dk(sk);
+
         for (size_t i = 0; i < ENCRYPTION_TEST_COUNT; i++) {
             M_type M;
 
@@ -539,8 +686,8 @@ TEST(ppke, probabilitic_correctness)
 
             auto   ct     = ppke.encrypt<M_type>(pk, M, tag);
             auto   ct2    = ppke.encrypt<M_type>(sp, M, tag);
-            M_type dec_M  = ppke.decrypt(sk, ct2);
-            M_type dec_M2 = ppke.decrypt(sk, ct2);
+            M_type dec_M  = ppke.decrypt(dk, ct2);
+            M_type dec_M2 = ppke.decrypt(dk, ct2);
 
             ASSERT_EQ(M, dec_M);
             ASSERT_EQ(M, dec_M2);
@@ -548,6 +695,119 @@ TEST(ppke, probabilitic_correctness)
     }
 }
 
+TEST(ppke, decryption_key)
+{
+    sse::crypto::Gmppke                 ppke;
+    sse::crypto::GmppkePublicKey        pk;
+    sse::crypto::GmppkePrivateKey       sk;
+    sse::crypto::GmppkeSecretParameters sp;
+
+    ppke.keygen(pk, sk, sp);
+
+    typedef uint64_t M_type;
+
+    // enough shares to use several threads
+    const size_t p_count = 2 * sse::crypto::Gmppke::kMinSharesPerThread + 1;
+    for (size_t p = 0; p < p_count; p++) {
+        ppke.puncture(pk, sk, test_punctured_tag(p));
+    }
+
+    const sse::crypto::GmppkeDecryptionKey dk(sk);
+    const sse::crypto::GmppkeDecryptionKey dk_tables(sk, true);
+
+    ASSERT_EQ(sk, dk.privateKey());
+    ASSERT_FALSE(dk.hasFixedBaseTables());
+    ASSERT_TRUE(dk_tables.hasFixedBaseTables());
+
+    for (size_t i = 0; i < ENCRYPTION_TEST_COUNT; i++) {
+        M_type M;
+
+        sse::crypto::random_bytes(sizeof(M_type),
+                                  reinterpret_cast<uint8_t*>(&M));
+
+        sse::crypto::tag_type tag = test_encryption_tag(i);
+
+        auto ct = ppke.encrypt<M_type>(pk, M, tag);
+
+        const relicxx::GT blind = ppke.recoverBlind(dk, ct);
+
+        for (unsigned int n_threads : {1U, 3U}) {
+            ASSERT_EQ(blind, ppke.recoverBlind(dk, ct, n_threads));
+            ASSERT_EQ(blind, ppke.recoverBlind(dk_tables, ct, n_threads));
+
+            M_type dec_M = 0;
+            ASSERT_TRUE(ppke.decrypt(dk_tables, ct, dec_M, n_threads));
+            ASSERT_EQ(M, dec_M);
+        }
+    }
+
+    M_type tmp;
+    auto   ct = ppke.encrypt<M_type>(pk, 0, test_punctured_tag(0));
+    ASSERT_FALSE(ppke.decrypt(dk, ct, tmp));
+    ASSERT_FALSE(ppke.decrypt(dk_tables, ct, tmp));
+}
+
+TEST(ppke, punctured_tags)
+{
+    sse::crypto::Gmppke                 ppke;
+    sse::crypto::GmppkePublicKey        pk;
+    sse::crypto::GmppkePrivateKey       sk;
+    sse::crypto::GmppkeSecretParameters sp;
+
+    ppke.keygen(pk, sk, sp);
+
+    // puncture the key on random (unsorted) tags
+    std::vector<sse::crypto::tag_type> tags(SERIALIZATION_PUNCT_COUNT);
+    for (auto& tag : tags) {
+        sse::crypto::random_bytes(tag.size(), tag.data());
+        ASSERT_FALSE(sk.isPuncturedOnTag(tag));
+
+        ppke.puncture(pk, sk, tag);
+        ASSERT_TRUE(sk.isPuncturedOnTag(tag));
+    }
+
+    ASSERT_TRUE(sk.isPuncturedOnTag(sse::crypto::Gmppke::NULLTAG));
+    for (const auto& tag : tags) {
+        ASSERT_TRUE(sk.isPuncturedOnTag(tag));
+
+        // flip one bit
+        sse::crypto::tag_type other_tag = tag;
+        other_tag[0] ^= 0x01;
+        ASSERT_FALSE(sk.isPuncturedOnTag(other_tag));
+    }
+}
+
+TEST(ppke, tag_hmac)
+{
+    for (size_t i = 0; i < ARITHMETIC_TEST_COUNT; i++) {
+        sse::crypto::tag_type tag;
+        sse::crypto::random_bytes(tag.size(), tag.data());
+
+        std::vector<uint8_t> in(i + 1);
+        sse::crypto::random_bytes(in.size(), in.data());
+
+        std::array<uint8_t, sse::crypto::Hash::kDigestSize> out;
+        std::array<uint8_t, sse::crypto::Hash::kDigestSize> expected;
+
+        sse::crypto::tag_type key_copy = tag;
+        sse::crypto::HMac<sse::crypto::Hash, sse::crypto::kTagSize> hmac(
+            sse::crypto::Key<sse::crypto::kTagSize>(key_copy.data()));
+        hmac.hmac(in.data(), in.size(), expected.data(), expected.size());
+
+        sse::crypto::tagHMac(tag, in.data(), in.size(), out.data(), out.size());
+        ASSERT_EQ(expected, out);
+
+        // truncated outputs are prefixes of the full output
+        uint64_t mask = 0;
+        sse::crypto::tagHMac(tag,
+                             in.data(),
+                             in.size(),
+                             reinterpret_cast<uint8_t*>(&mask),
+                             sizeof(mask));
+        ASSERT_EQ(0, memcmp(&mask, expected.data(), sizeof(mask)));
+    }
+}
+
 TEST(ppke, deterministic_correctness)
 {
     sse::crypto::Prf<sse::crypto::kPPKEPrfOutputSize> key_prf;
@@ -585,6 +845,9 @@ TEST(ppke, deterministic_correctness)
             keyshares[0] = ppke.sk0Gen(key_prf, sp, current_p_count);
         }
 
+        const sse::crypto::GmppkeDecryptionKey dk(
+            (sse::crypto::GmppkePrivateKey(keyshares)));
+
         for (size_t i = 0; i < ENCRYPTION_TEST_COUNT; i++) {
             M_type M;
 
@@ -595,16 +858,17 @@ TEST(ppke, deterministic_correctness)
 
             auto   ct  = ppke.encrypt<M_type>(pk, M, tag);
             auto   ct2 = ppke.encrypt<M_type>(sp, M, tag);
-            M_type dec_M
-                = ppke.decrypt(sse::crypto::GmppkePrivateKey(keyshares), ct2);
-            M_type dec_M2
-                = ppke.decrypt(sse::crypto::GmppkePrivateKey(keyshares), ct2);
+            M_type dec_M  = ppke.decrypt(dk, ct2);
+            M_type dec_M2 = ppke.decrypt(dk, ct2);
 
             ASSERT_EQ(M, dec_M);
             ASSERT_EQ(M, dec_M2);
         }
     }
 
+    const sse::crypto::GmppkeDecryptionKey dk(
+        (sse::crypto::GmppkePrivateKey(keyshares)));
+
     for (auto share : keyshares) {
         if (share.get_tag()
             == sse::crypto::Gmppke::NULLTAG) { // first key share
@@ -613,9 +877,8 @@ TEST(ppke, deterministic_correctness)
         } else {
             auto ct = ppke.encrypt<M_type>(pk, 0, share.get_tag());
 
-            ASSERT_THROW(
-                ppke.decrypt(sse::crypto::GmppkePrivateKey(keyshares), ct),
-                sse::crypto::PuncturedCiphertext);
+            ASSERT_THROW(ppke.decrypt(dk, ct),
+                         sse::crypto::PuncturedCiphertext);
         }
     }
 }
@@ -659,6 +922,8 @@ TEST(puncturable, correctness)
         sse::crypto::tag_type tag = test_encryption_tag(i);
         tag[8]                    = 0xCC;
 
+        ASSERT_FALSE(decryptor.is_punctured_on_tag(tag));
+
         auto ct      = encryptor.encrypt(M, tag);
         bool success = decryptor.decrypt(ct, dec_M);
 
@@ -678,7 +943,293 @@ TEST(puncturable, correctness)
 
             M_type tmp;
 
+            ASSERT_TRUE(decryptor.is_punctured_on_tag(
+                sse::crypto::punct::extract_tag(share)));
             ASSERT_FALSE(decryptor.decrypt(ct, tmp));
         }
     }
 }
+
+TEST(puncturable, parallel_decryption)
+{
+    sse::crypto::PuncturableEncryption encryptor(test_master_key(3));
+
+    // enough punctures to split the shares between several threads
+    const size_t p_count = 5 * sse::crypto::Gmppke::kMinSharesPerThread;
+
+    sse::crypto::punct::punctured_key_type punctured_key
+        = test_punctured_key(encryptor, p_count);
+
+    sse::crypto::PuncturableDecryption decryptor(punctured_key);
+    sse::crypto::PuncturableDecryption decryptor_tables(punctured_key, true);
+
+    std::vector<sse::crypto::punct::ciphertext_type> cts;
+    std::vector<uint64_t>                            plaintexts;
+    std::vector<bool>                                expected_success;
+
+    for (size_t i = 0; i < ENCRYPTION_TEST_COUNT; i++) {
+        sse::crypto::tag_type tag = test_encryption_tag(i);
+        tag[8]                    = 0xCC;
+
+        cts.push_back(encryptor.encrypt(i, tag));
+        plaintexts.push_back(i);
+        expected_success.push_back(true);
+    }
+    // add a few ciphertexts whose tags are punctured
+    for (size_t p = 0; p < 3; p++) {
+        cts.push_back(encryptor.encrypt(p, test_punctured_tag(p)));
+        plaintexts.push_back(0);
+        expected_success.push_back(false);
+    }
+
+    // thread counts above the number of hardware threads are capped
+    for (unsigned int n_threads : {1U, 2U, 3U, 0U, 10000U}) {
+        for (size_t i = 0; i < cts.size(); i++) {
+            uint64_t   m        = 0;
+            const bool expected = expected_success[i];
+            ASSERT_EQ(expected, decryptor.decrypt(cts[i], m, n_threads));
+            if (expected) {
+                ASSERT_EQ(plaintexts[i], m);
+            }
+            m = 0;
+            ASSERT_EQ(expected,
+                      decryptor_tables.decrypt(cts[i], m, n_threads));
+            if (expected) {
+                ASSERT_EQ(plaintexts[i], m);
+            }
+        }
+    }
+
+    // batches larger and smaller than the number of threads
+    for (unsigned int n_threads :
+         {1U, 4U, 0U, 2U * ENCRYPTION_TEST_COUNT, 10000U}) {
+        std::vector<uint64_t> ms;
+        std::vector<bool>     success
+            = decryptor.decrypt_batch(cts, ms, n_threads);
+
+        ASSERT_EQ(expected_success, success);
+        ASSERT_EQ(plaintexts, ms);
+    }
+
+    // a thread per share
+    sse::crypto::PuncturableDecryption::set_min_shares_per_thread(1);
+    for (size_t i = 0; i < cts.size(); i++) {
+        uint64_t m = 0;
+        ASSERT_EQ(expected_success[i], decryptor.decrypt(cts[i], m, 0));
+        if (expected_success[i]) {
+            ASSERT_EQ(plaintexts[i], m);
+        }
+    }
+    sse::crypto::PuncturableDecryption::set_min_shares_per_thread(
+        sse::crypto::Gmppke::kMinSharesPerThread);
+
+    ASSERT_THROW(
+        sse::crypto::PuncturableDecryption::set_min_shares_per_thread(0),
+        std::invalid_argument);
+
+    std::vector<uint64_t> ms(3, 1);
+    ASSERT_TRUE(decryptor.decrypt_batch({}, ms, 4).empty());
+    ASSERT_TRUE(ms.empty());
+}
+
+TEST(puncturable, incremental_decryption)
+{
+    sse::crypto::PuncturableEncryption encryptor(test_master_key(7));
+
+    const size_t p_count = 5;
+
+    sse::crypto::punct::punctured_key_type punctured_key;
+    punctured_key.push_back(encryptor.initial_keyshare(0));
+
+    sse::crypto::PuncturableDecryption decryptor(punctured_key);
+    sse::crypto::PuncturableDecryption decryptor_tables(punctured_key, true);
+
+    for (size_t p = 0; p < p_count; p++) {
+        const sse::crypto::tag_type tag = test_punctured_tag(p);
+
+        auto initial_share = encryptor.initial_keyshare(p + 1);
+        auto share         = encryptor.inc_puncture(p + 1, tag);
+
+        punctured_key[0] = initial_share;
+        punctured_key.push_back(share);
+
+        decryptor.add_share(initial_share);
+        decryptor.add_share(share);
+        decryptor_tables.extend({initial_share, share});
+
+        ASSERT_TRUE(decryptor.is_punctured_on_tag(tag));
+        ASSERT_TRUE(decryptor_tables.is_punctured_on_tag(tag));
+    }
+
+    // the incremental decryptors match the one built from the full key
+    sse::crypto::PuncturableDecryption full_decryptor(punctured_key);
+    ASSERT_EQ(full_decryptor.snapshot(), decryptor.snapshot());
+    ASSERT_EQ(full_decryptor.snapshot(), decryptor_tables.snapshot());
+
+    for (size_t i = 0; i < ENCRYPTION_TEST_COUNT; i++) {
+        sse::crypto::tag_type tag = test_encryption_tag(i);
+        tag[8]                    = 0xCC;
+
+        auto     ct = encryptor.encrypt(i, tag);
+        uint64_t m  = 0;
+        ASSERT_TRUE(decryptor.decrypt(ct, m));
+        ASSERT_EQ(i, m);
+        m = 0;
+        ASSERT_TRUE(decryptor_tables.decrypt(ct, m));
+        ASSERT_EQ(i, m);
+    }
+    for (size_t p = 0; p < p_count; p++) {
+        auto     ct = encryptor.encrypt(p, test_punctured_tag(p));
+        uint64_t m  = 0;
+        ASSERT_FALSE(decryptor.decrypt(ct, m));
+        ASSERT_FALSE(decryptor_tables.decrypt(ct, m));
+    }
+}
+
+TEST(puncturable, snapshot)
+{
+    sse::crypto::PuncturableEncryption encryptor(test_master_key(11));
+
+    const size_t p_count = 3;
+
+    sse::crypto::punct::punctured_key_type punctured_key
+        = test_punctured_key(encryptor, p_count);
+
+    sse::crypto::PuncturableDecryption decryptor(punctured_key);
+    const std::vector<uint8_t>         snapshot = decryptor.snapshot();
+
+    sse::crypto::PuncturableDecryption reloaded(snapshot);
+    sse::crypto::PuncturableDecryption reloaded_tables(snapshot, true);
+    ASSERT_EQ(snapshot, reloaded.snapshot());
+
+    for (size_t i = 0; i < ENCRYPTION_TEST_COUNT; i++) {
+        auto     ct = encryptor.encrypt(i, test_encryption_tag(i));
+        uint64_t m  = 0;
+        ASSERT_TRUE(reloaded.decrypt(ct, m));
+        ASSERT_EQ(i, m);
+        m = 0;
+        ASSERT_TRUE(reloaded_tables.decrypt(ct, m));
+        ASSERT_EQ(i, m);
+    }
+    for (size_t p = 0; p < p_count; p++) {
+        ASSERT_TRUE(reloaded.is_punctured_on_tag(test_punctured_tag(p)));
+    }
+
+    // malformed snapshots
+    ASSERT_THROW(sse::crypto::PuncturableDecryption(std::vector<uint8_t>(3)),
+                 std::invalid_argument);
+    ASSERT_THROW(sse::crypto::PuncturableDecryption(std::vector<uint8_t>(8)),
+                 std::invalid_argument);
+
+    std::vector<uint8_t> truncated(snapshot.begin(), snapshot.end() - 1);
+    ASSERT_THROW(sse::crypto::PuncturableDecryption{truncated},
+                 std::invalid_argument);
+
+    std::vector<uint8_t> wrong_count = snapshot;
+    wrong_count[0]++;
+    ASSERT_THROW(sse::crypto::PuncturableDecryption{wrong_count},
+                 std::invalid_argument);
+
+    // a point of the last keyshare is not on the curve anymore
+    std::vector<uint8_t> invalid_point = snapshot;
+    invalid_point[invalid_point.size() - sse::crypto::kTagSize - 1] ^= 0x01;
+    ASSERT_THROW(sse::crypto::PuncturableDecryption{invalid_point},
+                 std::invalid_argument);
+}
+
+TEST(puncturable, concurrent_use)
+{
+    sse::crypto::PuncturableEncryption encryptor(test_master_key(13));
+
+    const size_t p_count = 4;
+
+    sse::crypto::punct::punctured_key_type punctured_key
+        = test_punctured_key(encryptor, p_count);
+    sse::crypto::PuncturableDecryption decryptor(punctured_key);
+
+    const unsigned int n_threads = 4;
+    const size_t       n_ops     = ENCRYPTION_TEST_COUNT;
+
+    // The threads share the encryptor and the decryptor, and also use
+    // objects of their own. Their RELIC contexts are created lazily.
+    std::atomic<size_t>      successes{0};
+    std::atomic<size_t>      failures{0};
+    std::vector<std::thread> threads;
+
+    for (unsigned int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t]() {
+            try {
+                sse::crypto::Gmppke                 ppke;
+                sse::crypto::GmppkePublicKey        pk;
+                sse::crypto::GmppkePrivateKey       sk;
+                sse::crypto::GmppkeSecretParameters sp;
+                ppke.keygen(pk, sk, sp);
+                const sse::crypto::GmppkeDecryptionKey dk(sk);
+
+                for (size_t i = 0; i < n_ops; i++) {
+                    const uint64_t        m   = t * n_ops + i;
+                    sse::crypto::tag_type tag = test_encryption_tag(m);
+
+                    uint64_t dec_m = 0;
+                    auto     ct    = encryptor.encrypt(m, tag);
+                    bool     ok = decryptor.decrypt(ct, dec_m) && dec_m == m;
+
+                    dec_m = 0;
+                    auto ppke_ct = ppke.encrypt<uint64_t>(pk, m, tag);
+                    ok = ok && ppke.decrypt(dk, ppke_ct, dec_m) && dec_m == m;
+
+                    if (ok) {
+                        successes++;
+                    } else {
+                        failures++;
+                    }
+                }
+            } catch (...) {
+                failures++;
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    ASSERT_EQ(0U, failures.load());
+    ASSERT_EQ(n_threads * n_ops, successes.load());
+}
+
+TEST(puncturable, batch_encryption)
+{
+    sse::crypto::PuncturableEncryption encryptor(test_master_key(5));
+
+    const size_t p_count = 3;
+
+    sse::crypto::punct::punctured_key_type punctured_key
+        = test_punctured_key(encryptor, p_count);
+    sse::crypto::PuncturableDecryption decryptor(punctured_key);
+
+    std::vector<std::pair<uint64_t, sse::crypto::punct::tag_type>> messages;
+    for (size_t i = 0; i < ENCRYPTION_TEST_COUNT; i++) {
+        messages.emplace_back(3 * i + 1, test_encryption_tag(i));
+    }
+    messages.emplace_back(42, test_punctured_tag(1));
+
+    for (unsigned int n_threads : {1U, 3U, 0U}) {
+        std::vector<sse::crypto::punct::ciphertext_type> cts
+            = encryptor.encrypt_batch(messages, n_threads);
+        ASSERT_EQ(messages.size(), cts.size());
+
+        for (size_t i = 0; i < ENCRYPTION_TEST_COUNT; i++) {
+            uint64_t m = 0;
+            ASSERT_TRUE(decryptor.decrypt(cts[i], m));
+            ASSERT_EQ(messages[i].first, m);
+        }
+        uint64_t m = 0;
+        ASSERT_FALSE(decryptor.decrypt(cts.back(), m));
+    }
+
+    ASSERT_TRUE(encryptor.encrypt_batch({}, 4).empty());
+
+    // the NULL tag is rejected for the whole batch
+    messages.emplace_back(0, sse::crypto::Gmppke::NULLTAG);
+    ASSERT_THROW(encryptor.encrypt_batch(messages, 2), std::invalid_argument);
+}
@@ -23,19 +23,25 @@
 #include <sse/crypto/random.hpp>
 #include <sse/crypto/wrapper.hpp>
 
+#include <cstring>
+
 #include <iomanip>
 #include <iostream>
 #include <string>
 
+#include <sodium/crypto_generichash_blake2b.h>
+
 #include "gtest/gtest.h"
 
 using namespace std;
 namespace tests {
 
-template<size_t N>
+using DefaultPrfBase = sse::crypto::HMac<sse::crypto::Hash, 32>;
+
+template<size_t N, class PrfBase = DefaultPrfBase>
 void test_prf_consistency(size_t input_size)
 {
-    sse::crypto::Prf<N> prf;
+    sse::crypto::Prf<N, PrfBase> prf;
 
     string in_s  = sse::crypto::random_string(input_size);
     auto   out_s = prf.prf(in_s);
@@ -106,7 +112,7 @@ void test_key_derivation_consistency_array()
     out_key.lock();
 }
 
-template<size_t N>
+template<size_t N, class PrfBase = DefaultPrfBase>
 void test_wrapping()
 {
     constexpr size_t kNTests = 1000;
@@ -115,15 +121,15 @@ void test_wrapping()
         (sse::crypto::Key<sse::crypto::Wrapper::kKeySize>()));
 
     // Create a Prg object
-    sse::crypto::Prf<N> base_prf;
+    sse::crypto::Prf<N, PrfBase> base_prf;
 
 
     // wrap the object
     auto prf_rep = wrapper.wrap(base_prf);
 
     // unwrap the object
-    sse::crypto::Prf<N> unwrapped_prf
-        = wrapper.unwrap<sse::crypto::Prf<N>>(prf_rep);
+    sse::crypto::Prf<N, PrfBase> unwrapped_prf
+        = wrapper.unwrap<sse::crypto::Prf<N, PrfBase>>(prf_rep);
 
 
     for (size_t i = 1; i < kNTests + 1; i++) {
@@ -182,6 +188,136 @@ TEST(prf, wrapping)
     tests::test_wrapping<2000>();
 }
 
+TEST(prf, keyed_blake2b)
+{
+    using sse::crypto::KeyedBlake2b;
+
+    for (size_t i = 1; i <= 2 * KeyedBlake2b::kDigestSize + 20; i++) {
+        tests::test_prf_consistency<1, KeyedBlake2b>(i);
+        tests::test_prf_consistency<64, KeyedBlake2b>(i);
+        tests::test_prf_consistency<1024, KeyedBlake2b>(i);
+    }
+    tests::test_wrapping<32, KeyedBlake2b>();
+    tests::test_wrapping<1024, KeyedBlake2b>();
+
+    // compare to Blake2b in keyed mode
+    std::array<uint8_t, KeyedBlake2b::kKeySize> key;
+    for (size_t i = 0; i < key.size(); i++) {
+        key[i] = static_cast<uint8_t>(i);
+    }
+    std::array<uint8_t, KeyedBlake2b::kKeySize> key_copy = key;
+
+    sse::crypto::Prf<128, KeyedBlake2b> prf(
+        sse::crypto::Key<KeyedBlake2b::kKeySize>(key_copy.data()));
+
+    const std::string in = "input";
+    auto              out = prf.prf(in);
+
+    // the first block is Blake2b(key, in || 0), the second one
+    // Blake2b(key, in || 1)
+    for (uint8_t block = 0; block < 2; block++) {
+        std::string block_in = in + static_cast<char>(block);
+        uint8_t     ref[KeyedBlake2b::kDigestSize];
+        crypto_generichash_blake2b(
+            ref,
+            sizeof(ref),
+            reinterpret_cast<const uint8_t*>(block_in.data()),
+            block_in.size(),
+            key.data(),
+            key.size());
+        ASSERT_EQ(0,
+                  memcmp(ref,
+                         out.data() + block * KeyedBlake2b::kDigestSize,
+                         KeyedBlake2b::kDigestSize));
+    }
+
+    // the keyed constructions have different type bytes, which are
+    // authenticated when unwrapping
+    sse::crypto::Wrapper wrapper(
+        (sse::crypto::Key<sse::crypto::Wrapper::kKeySize>()));
+    auto rep = wrapper.wrap(prf);
+    ASSERT_THROW(wrapper.unwrap<sse::crypto::Prf<128>>(rep),
+                 std::runtime_error);
+
+    // exceptions
+    key_copy = key;
+    KeyedBlake2b h(sse::crypto::Key<KeyedBlake2b::kKeySize>(key_copy.data()));
+    uint8_t      c;
+    ASSERT_THROW(h.evaluate(nullptr, 0, &c, 1), std::invalid_argument);
+    ASSERT_THROW(h.evaluate(&c, 1, nullptr, 1), std::invalid_argument);
+    ASSERT_THROW(h.evaluate(&c, 1, &c, KeyedBlake2b::kDigestSize + 1),
+                 std::invalid_argument);
+
+    sse::crypto::Key<KeyedBlake2b::kKeySize> k1;
+    sse::crypto::Key<KeyedBlake2b::kKeySize> k2(std::move(k1));
+    ASSERT_THROW(KeyedBlake2b h2(std::move(k1)), std::invalid_argument);
+}
+
+TEST(prf, wrapping_buffers)
+{
+    constexpr size_t kNKeys = 100;
+
+    sse::crypto::Wrapper wrapper(
+        (sse::crypto::Key<sse::crypto::Wrapper::kKeySize>()));
+
+    // wrap_into / unwrap_from
+    sse::crypto::Prf<32> base_prf;
+
+    const size_t size = sse::crypto::Wrapper::wrapped_size(base_prf);
+    ASSERT_EQ(wrapper.wrap(base_prf).size(), size);
+
+    std::vector<uint8_t> buffer(size + 10, 0xFF);
+    ASSERT_THROW(wrapper.wrap_into(base_prf, buffer.data(), size - 1),
+                 std::invalid_argument);
+    ASSERT_EQ(size, wrapper.wrap_into(base_prf, buffer.data(), buffer.size()));
+    // the end of the buffer is untouched
+    ASSERT_EQ(0xFF, buffer[size]);
+
+    sse::crypto::Prf<32> unwrapped_prf
+        = wrapper.unwrap_from<sse::crypto::Prf<32>>(buffer.data(), size);
+    ASSERT_EQ(base_prf.prf("input"), unwrapped_prf.prf("input"));
+
+    // the input is not wiped, and can be unwrapped again
+    unwrapped_prf
+        = wrapper.unwrap_from<sse::crypto::Prf<32>>(buffer.data(), size);
+    ASSERT_EQ(base_prf.prf("input"), unwrapped_prf.prf("input"));
+
+    ASSERT_THROW(wrapper.unwrap_from<sse::crypto::Prf<32>>(
+                     buffer.data(), sse::crypto::Wrapper::kCiphertextExpansion),
+                 std::invalid_argument);
+
+    // wrap_many / unwrap_many
+    std::vector<sse::crypto::Prf<32>> prfs(kNKeys);
+
+    std::vector<std::vector<uint8_t>> reps = wrapper.wrap_many(prfs);
+    ASSERT_EQ(kNKeys, reps.size());
+
+    std::vector<sse::crypto::Prf<32>> unwrapped_prfs
+        = wrapper.unwrap_many<sse::crypto::Prf<32>>(reps);
+    ASSERT_EQ(kNKeys, unwrapped_prfs.size());
+
+    for (size_t i = 0; i < kNKeys; i++) {
+        std::string in = sse::crypto::random_string(10 + i);
+        ASSERT_EQ(prfs[i].prf(in), unwrapped_prfs[i].prf(in));
+
+        // the batch and the single-object functions are compatible
+        unwrapped_prf = wrapper.unwrap<sse::crypto::Prf<32>>(reps[i]);
+        ASSERT_EQ(prfs[i].prf(in), unwrapped_prf.prf(in));
+    }
+
+    ASSERT_TRUE(wrapper.wrap_many(std::vector<sse::crypto::Prf<32>>()).empty());
+
+    // a single corrupted representation makes the whole batch fail
+    reps = wrapper.wrap_many(prfs);
+    reps[kNKeys / 2][0] ^= 0x01;
+    ASSERT_THROW(wrapper.unwrap_many<sse::crypto::Prf<32>>(reps),
+                 std::runtime_error);
+
+    // the wrapper is still usable after a failure
+    reps[kNKeys / 2] = wrapper.wrap(prfs[kNKeys / 2]);
+    ASSERT_EQ(kNKeys, wrapper.unwrap_many<sse::crypto::Prf<32>>(reps).size());
+}
+
 TEST(prf, exceptions)
 {
     sse::crypto::Prf<20> prf;
@@ -22,11 +22,14 @@
 #include "tdp_impl/tdp_impl_openssl.hpp"
 
 #include <sse/crypto/tdp.hpp>
+#include <sse/crypto/utils.hpp>
 #include <sse/crypto/wrapper.hpp>
 
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -48,8 +51,17 @@ using namespace std;
 
 #define TDP_IMPL_DET_GEN_TEST_COUNT 30
 
+#define TDP_IMPL_ITERATED_EVAL_TEST_COUNT 10
+
 #define POOL_COUNT 20
 #define INV_MULT_COUNT 100
+#define ITERATED_EVAL_COUNT 100
+
+#define INVERT_BATCH_SIZE 37 // not a multiple of the number of lanes
+#define TDP_IMPL_INVERT_BATCH_TEST_COUNT 3
+
+#define CONCURRENT_THREAD_COUNT 4
+#define CONCURRENT_TEST_COUNT 10
 
 // static_if does not exist, so we use a workaround using template
 // specialization
@@ -411,6 +423,50 @@ static void test_tdp_impl_multiple_eval(const size_t string_test_count,
 }
 
 
+template<typename TDP,
+         typename TDP_INV,
+         typename TDP_POOL,
+         bool is_implementation>
+static void test_tdp_impl_iterated_eval(const size_t test_count)
+{
+    using message_type = std::array<uint8_t, sse::crypto::Tdp::kMessageSize>;
+
+    for (size_t i = 0; i < test_count; i++) {
+        TDP_INV tdp_inv;
+        TDP     tdp(tdp_inv.public_key());
+
+        const uint32_t order  = ITERATED_EVAL_COUNT;
+        message_type   sample = tdp.sample_array();
+        message_type   v      = sample;
+        uint32_t       count  = 0;
+
+        auto callback = [&tdp, &v, &count](uint32_t            index,
+                                           const message_type& value) {
+            v = tdp.eval(v);
+            count++;
+
+            ASSERT_EQ(count, index);
+            ASSERT_EQ(v, value);
+        };
+
+        message_type res = tdp.eval_iterated(sample, order, callback);
+
+        ASSERT_EQ(count, order);
+        ASSERT_EQ(v, res);
+
+        // without any callback
+        ASSERT_EQ(res, tdp.eval_iterated(sample, order, nullptr));
+
+        // inverting the TDP as many times gives back the original sample
+        ASSERT_EQ(sample, tdp_inv.invert_mult(res, order));
+
+        // order 0 is the identity, and does not call the callback
+        count = 0;
+        ASSERT_EQ(sample, tdp.eval_iterated(sample, 0, callback));
+        ASSERT_EQ(count, 0U);
+    }
+}
+
 template<typename TDP,
          typename TDP_INV,
          typename TDP_POOL,
@@ -677,6 +733,43 @@ static void test_tdp_impl_exceptions()
                  std::invalid_argument);
 }
 
+template<typename TDP_INV>
+static void test_tdp_impl_invert_batch(const size_t test_count)
+{
+    using message_type
+        = std::array<uint8_t, TDP_INV::kMessageSpaceSize>;
+
+    TDP_INV tdp_inv;
+
+    for (size_t i = 0; i < test_count; i++) {
+        std::vector<message_type> in(INVERT_BATCH_SIZE);
+        std::vector<message_type> out(INVERT_BATCH_SIZE);
+
+        for (auto& m : in) {
+            m = tdp_inv.sample_array();
+        }
+
+        // batches of every size, from the full batch to a single message
+        for (size_t n = INVERT_BATCH_SIZE; n > 0; n /= 2) {
+            tdp_inv.invert_batch(in.data(), out.data(), n);
+
+            for (size_t j = 0; j < n; j++) {
+                ASSERT_EQ(tdp_inv.invert(in[j]), out[j]);
+            }
+        }
+
+        // in place inversion
+        out = in;
+        tdp_inv.invert_batch(out.data(), out.data(), out.size());
+        for (size_t j = 0; j < out.size(); j++) {
+            ASSERT_EQ(in[j], tdp_inv.eval(out[j]));
+        }
+    }
+
+    // no message
+    tdp_inv.invert_batch(nullptr, nullptr, 0);
+}
+
 // Instantiate all the previous test templates
 #ifdef WITH_OPENSSL
 TEST(tdp_openssl_impl, correctness)
@@ -765,6 +858,32 @@ TEST(tdp, multiple_eval)
                                        TDP_TEST_COUNT - TDP_TEST_COUNT / 2);
 }
 
+#ifdef WITH_OPENSSL
+TEST(tdp_openssl_impl, iterated_eval)
+{
+    test_tdp_impl_iterated_eval<sse::crypto::TdpImpl_OpenSSL,
+                                sse::crypto::TdpInverseImpl_OpenSSL,
+                                sse::crypto::TdpMultPoolImpl_OpenSSL,
+                                true>(TDP_IMPL_ITERATED_EVAL_TEST_COUNT);
+}
+#endif
+
+TEST(tdp_mbedtls_impl, iterated_eval)
+{
+    test_tdp_impl_iterated_eval<sse::crypto::TdpImpl_mbedTLS,
+                                sse::crypto::TdpInverseImpl_mbedTLS,
+                                sse::crypto::TdpMultPoolImpl_mbedTLS,
+                                true>(TDP_IMPL_ITERATED_EVAL_TEST_COUNT);
+}
+
+TEST(tdp, iterated_eval)
+{
+    test_tdp_impl_iterated_eval<sse::crypto::Tdp,
+                                sse::crypto::TdpInverse,
+                                sse::crypto::TdpMultPool,
+                                false>(TDP_TEST_COUNT);
+}
+
 #ifdef WITH_OPENSSL
 TEST(tdp_openssl_impl, multiple_inverse_1)
 {
@@ -817,6 +936,136 @@ TEST(tdp, multiple_inverse_2)
                                      false>(TDP_TEST_COUNT);
 }
 
+#ifdef WITH_OPENSSL
+TEST(tdp_openssl_impl, invert_batch)
+{
+    test_tdp_impl_invert_batch<sse::crypto::TdpInverseImpl_OpenSSL>(
+        TDP_IMPL_INVERT_BATCH_TEST_COUNT);
+}
+#endif
+
+TEST(tdp_mbedtls_impl, invert_batch)
+{
+    test_tdp_impl_invert_batch<sse::crypto::TdpInverseImpl_mbedTLS>(
+        TDP_IMPL_INVERT_BATCH_TEST_COUNT);
+}
+
+TEST(tdp, invert_batch)
+{
+    sse::crypto::TdpInverse tdp_inv;
+
+    std::vector<std::array<uint8_t, sse::crypto::Tdp::kMessageSize>> in(
+        INVERT_BATCH_SIZE);
+    for (auto& m : in) {
+        m = tdp_inv.sample_array();
+    }
+
+    for (unsigned int n_threads :
+         {1U, 3U, 0U, 2U * INVERT_BATCH_SIZE, 10000U}) {
+        auto out = tdp_inv.invert_batch(in, n_threads);
+
+        ASSERT_EQ(in.size(), out.size());
+        for (size_t j = 0; j < in.size(); j++) {
+            ASSERT_EQ(in[j], tdp_inv.eval(out[j]));
+        }
+    }
+
+    ASSERT_TRUE(tdp_inv.invert_batch({}).empty());
+
+    // an invalid input (larger than the modulus) in the batch
+    in[INVERT_BATCH_SIZE / 2].fill(0xFF);
+    ASSERT_THROW(tdp_inv.invert_batch(in), std::invalid_argument);
+    ASSERT_THROW(tdp_inv.invert_batch(in, 4), std::invalid_argument);
+}
+
+// Check that the cache of CRT exponents used by invert_mult is consistent,
+// including when entries are evicted
+TEST(tdp_mbedtls_impl, invert_mult_cache)
+{
+    constexpr uint32_t kMaxOrder = 80;
+
+    sse::crypto::TdpInverseImpl_mbedTLS tdp_inv;
+
+    auto sample = tdp_inv.sample_array();
+
+    std::vector<std::array<uint8_t, sse::crypto::Tdp::kMessageSize>> expected(
+        kMaxOrder + 1);
+    expected[0] = sample;
+    for (uint32_t j = 1; j <= kMaxOrder; j++) {
+        expected[j] = tdp_inv.invert(expected[j - 1]);
+    }
+
+    // fill the cache, and evict entries
+    for (uint32_t j = 1; j <= kMaxOrder; j++) {
+        ASSERT_EQ(expected[j], tdp_inv.invert_mult(sample, j));
+    }
+    // a mix of cached and evicted orders, several times
+    for (size_t round = 0; round < 3; round++) {
+        for (uint32_t k = 0; k < kMaxOrder; k += 3) {
+            const uint32_t j = kMaxOrder - k;
+            ASSERT_EQ(expected[j], tdp_inv.invert_mult(sample, j));
+        }
+    }
+}
+
+// Iterated evaluations count one modular exponentiation per iteration
+TEST(tdp_mbedtls_impl, statistics)
+{
+    sse::crypto::TdpInverseImpl_mbedTLS   tdp_inv;
+    sse::crypto::TdpImpl_mbedTLS          tdp(tdp_inv.public_key());
+    sse::crypto::TdpMultPoolImpl_mbedTLS pool(tdp_inv.public_key(), 6);
+
+    auto sample = tdp.sample_array();
+
+    const sse::crypto::Statistics before = sse::crypto::statistics_snapshot();
+    tdp.eval_iterated(sample, 5, nullptr);
+    pool.eval_pool(sample, 6);
+    const sse::crypto::Statistics after = sse::crypto::statistics_snapshot();
+
+    if (sse::crypto::statistics_enabled()) {
+        ASSERT_EQ(5U + 6U, after.mod_exps - before.mod_exps);
+    } else {
+        ASSERT_EQ(0U, after.mod_exps);
+    }
+}
+
+// Use a single TDP from several threads, without any synchronization
+TEST(tdp_mbedtls_impl, concurrent_use)
+{
+    const sse::crypto::TdpInverseImpl_mbedTLS tdp_inv;
+    const sse::crypto::TdpImpl_mbedTLS        tdp(tdp_inv.public_key());
+    const sse::crypto::TdpMultPoolImpl_mbedTLS pool(tdp_inv.public_key(), 3);
+
+    auto worker = [&tdp_inv, &tdp, &pool](size_t t) {
+        for (size_t i = 0; i < CONCURRENT_TEST_COUNT; i++) {
+            auto sample = tdp_inv.sample_array();
+
+            auto inv = tdp_inv.invert(sample);
+            EXPECT_EQ(sample, tdp.eval(inv));
+            EXPECT_EQ(sample, tdp_inv.eval(inv));
+
+            auto inv_2 = tdp_inv.invert_mult(sample, 2);
+            EXPECT_EQ(inv, tdp.eval(inv_2));
+            EXPECT_EQ(sample, pool.eval_pool(inv_2, 2));
+
+            // enough different orders to insert in, and evict from, the
+            // cache of CRT exponents while other threads read it
+            const uint32_t order
+                = static_cast<uint32_t>(3 + (7 * t + i) % 40);
+            auto inv_k = tdp_inv.invert_mult(sample, order);
+            EXPECT_EQ(inv_k, tdp.eval(tdp_inv.invert_mult(sample, order + 1)));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < CONCURRENT_THREAD_COUNT; t++) {
+        threads.emplace_back(worker, t);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
 #ifdef WITH_OPENSSL
 TEST(tdp_openssl_impl, copy)
 {
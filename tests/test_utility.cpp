@@ -18,11 +18,26 @@
 // along with libsse_crypto.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <sse/crypto/hash.hpp>
+#include <sse/crypto/hmac.hpp>
+#include <sse/crypto/prf.hpp>
+#include <sse/crypto/prg.hpp>
+#include <sse/crypto/random.hpp>
+#include <sse/crypto/rcprf.hpp>
 #include <sse/crypto/utils.hpp>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <cstring>
 
+#include <array>
+#include <atomic>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -88,3 +103,286 @@ TEST(utility, strstrn)
     EXPECT_TRUE(test_strstrn("abab", "bb"));
     EXPECT_TRUE(test_strstrn("aabb", "bb"));
 }
+
+TEST(utility, random_sources)
+{
+    const sse::crypto::RandomSource default_source
+        = sse::crypto::random_source();
+    ASSERT_EQ(sse::crypto::RandomSource::System, default_source);
+
+    for (auto source : {sse::crypto::RandomSource::System,
+                        sse::crypto::RandomSource::BufferedChaCha20}) {
+        sse::crypto::set_random_source(source);
+        ASSERT_EQ(source, sse::crypto::random_source());
+
+        // small requests, spanning several refills of the buffer, and large
+        // requests, served directly
+        std::set<std::string> outputs;
+        for (size_t length : {1, 16, 33, 256, 257, 4096}) {
+            for (size_t i = 0; i < 100; i++) {
+                const std::string out = sse::crypto::random_string(length);
+                ASSERT_EQ(length, out.size());
+                outputs.insert(out);
+            }
+        }
+        // a few collisions are expected for 1-byte outputs
+        ASSERT_GT(outputs.size(), 5 * 100U);
+
+        // a large output should not be constant
+        const std::string large = sse::crypto::random_string(4096);
+        ASSERT_NE(std::string(large.size(), large[0]), large);
+    }
+
+    sse::crypto::set_random_source(default_source);
+}
+
+TEST(utility, random_fork)
+{
+    const sse::crypto::RandomSource default_source
+        = sse::crypto::random_source();
+    sse::crypto::set_random_source(
+        sse::crypto::RandomSource::BufferedChaCha20);
+
+    // make sure the generator of this thread is seeded and buffered
+    sse::crypto::random_bytes<uint8_t, 16>();
+
+    int pipe_fds[2];
+    ASSERT_EQ(0, pipe(pipe_fds));
+
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+
+    if (pid == 0) {
+        // child process
+        auto out = sse::crypto::random_bytes<uint8_t, 16>();
+        ssize_t written = write(pipe_fds[1], out.data(), out.size());
+        _exit(written == static_cast<ssize_t>(out.size()) ? 0 : 1);
+    }
+
+    auto parent_out = sse::crypto::random_bytes<uint8_t, 16>();
+
+    std::array<uint8_t, 16> child_out;
+    ASSERT_EQ(static_cast<ssize_t>(child_out.size()),
+              read(pipe_fds[0], child_out.data(), child_out.size()));
+
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+
+    // the child must not replay the parent's buffered bytes
+    ASSERT_NE(parent_out, child_out);
+
+    sse::crypto::set_random_source(default_source);
+}
+
+TEST(utility, statistics)
+{
+    using sse::crypto::Statistics;
+
+    sse::crypto::reset_statistics();
+    Statistics stats = sse::crypto::statistics_snapshot();
+    ASSERT_EQ(0U, stats.mprotects);
+    ASSERT_EQ(0U, stats.secure_allocations);
+    ASSERT_EQ(0U, stats.prg_blocks);
+    ASSERT_EQ(0U, stats.hash_compressions);
+
+    {
+        sse::crypto::HMac<sse::crypto::Hash, 32> hmac;
+        sse::crypto::Prg prg(sse::crypto::Key<sse::crypto::Prg::kKeySize>{});
+
+        // 128 bytes of key pad and 1000 bytes of input in the inner hash,
+        // 128 bytes of key pad and 64 bytes of digest in the outer one
+        hmac.hmac(std::string(1000, 'a'));
+        // 16 ChaCha20 blocks, and 17 when the output is not aligned
+        prg.derive(1000);
+        prg.derive(60, 1000);
+    }
+
+    stats = sse::crypto::statistics_snapshot();
+    if (sse::crypto::statistics_enabled()) {
+        ASSERT_EQ(2U, stats.secure_allocations);
+        ASSERT_EQ(11U, stats.hash_compressions);
+        ASSERT_EQ(16U + 17U, stats.prg_blocks);
+#ifdef ENABLE_MEMORY_LOCK
+        ASSERT_GT(stats.mprotects, 0U);
+#endif
+    } else {
+        ASSERT_EQ(0U, stats.mprotects);
+        ASSERT_EQ(0U, stats.secure_allocations);
+        ASSERT_EQ(0U, stats.prg_blocks);
+        ASSERT_EQ(0U, stats.hash_compressions);
+    }
+
+    // the counters are per thread
+    std::thread other([]() {
+        EXPECT_EQ(0U, sse::crypto::statistics_snapshot().secure_allocations);
+    });
+    other.join();
+
+    sse::crypto::reset_statistics();
+    ASSERT_EQ(0U, sse::crypto::statistics_snapshot().prg_blocks);
+}
+
+static size_t count_occurrences(const std::string& str, const std::string& pat)
+{
+    size_t count = 0;
+    for (size_t pos = str.find(pat); pos != std::string::npos;
+         pos     = str.find(pat, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+TEST(utility, tracing)
+{
+    ASSERT_FALSE(sse::crypto::tracing_enabled());
+
+    sse::crypto::RCPrf<16> rc_prf(
+        sse::crypto::Key<sse::crypto::RCPrfParams::kKeySize>(), 5);
+    auto callback = [](uint64_t, std::array<uint8_t, 16>) {};
+
+    // nothing is recorded while tracing is disabled
+    sse::crypto::clear_trace();
+    rc_prf.eval_range(0, 10, callback);
+
+    std::ostringstream out;
+    sse::crypto::dump_trace(out);
+    ASSERT_EQ(0U, count_occurrences(out.str(), "\"ph\":\"X\""));
+
+    // every span is recorded
+    sse::crypto::enable_tracing();
+    ASSERT_TRUE(sse::crypto::tracing_enabled());
+
+    auto constrained_prf = rc_prf.constrain(3, 12);
+    constrained_prf.eval_range(3, 12, callback);
+
+    out.str("");
+    sse::crypto::dump_trace(out);
+    const std::string trace = out.str();
+    EXPECT_EQ(0U, trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    EXPECT_EQ(1U, count_occurrences(trace, "\"name\":\"RCPrf::constrain\""));
+    EXPECT_EQ(1U,
+              count_occurrences(
+                  trace, "\"name\":\"ConstrainedRCPrf::eval_range\""));
+    EXPECT_EQ(0U, count_occurrences(trace, "\"name\":\"RCPrf::eval_range\""));
+
+    // the key operations are not recorded outside of another span
+    sse::crypto::clear_trace();
+    {
+        // the PRF unlocks and locks its key, outside of any traced operation
+        sse::crypto::Prf<16> prf;
+        prf.prf(std::string("input"));
+    }
+    out.str("");
+    sse::crypto::dump_trace(out);
+    EXPECT_EQ(0U, count_occurrences(out.str(), "\"name\":\"Key::"));
+
+    // one top-level span out of 5 is recorded, with the spans nested in it
+    sse::crypto::clear_trace();
+    sse::crypto::enable_tracing(5);
+    std::thread sampled_thread([&rc_prf, &callback]() {
+        for (size_t i = 0; i < 10; i++) {
+            rc_prf.eval_range(0, 10, callback);
+        }
+    });
+    sampled_thread.join();
+
+    out.str("");
+    sse::crypto::dump_trace(out);
+    EXPECT_EQ(2U,
+              count_occurrences(out.str(), "\"name\":\"RCPrf::eval_range\""));
+
+    // the oldest spans are overwritten when the ring buffer is full
+    sse::crypto::clear_trace();
+    sse::crypto::enable_tracing(1, 2);
+    std::thread small_ring_thread([&rc_prf, &callback]() {
+        for (size_t i = 0; i < 10; i++) {
+            rc_prf.eval_range(0, 10, callback);
+        }
+    });
+    small_ring_thread.join();
+
+    out.str("");
+    sse::crypto::dump_trace(out);
+    EXPECT_EQ(2U, count_occurrences(out.str(), "\"ph\":\"X\""));
+
+    // the spans of the exited threads are only dumped once, and the
+    // buffers of at most 64 exited threads (plus the last one) are kept
+    sse::crypto::clear_trace();
+    sse::crypto::enable_tracing(1, 2);
+    for (size_t t = 0; t < 100; t++) {
+        std::thread short_lived_thread([&rc_prf, &callback]() {
+            rc_prf.eval_range(0, 10, callback);
+        });
+        short_lived_thread.join();
+    }
+
+    out.str("");
+    sse::crypto::dump_trace(out);
+    EXPECT_EQ(65U,
+              count_occurrences(out.str(), "\"name\":\"RCPrf::eval_range\""));
+
+    out.str("");
+    sse::crypto::dump_trace(out);
+    EXPECT_EQ(0U, count_occurrences(out.str(), "\"ph\":\"X\""));
+
+    sse::crypto::disable_tracing();
+    sse::crypto::clear_trace();
+
+    EXPECT_THROW(sse::crypto::enable_tracing(0), std::invalid_argument);
+    EXPECT_THROW(sse::crypto::enable_tracing(1, 0), std::invalid_argument);
+    EXPECT_FALSE(sse::crypto::tracing_enabled());
+}
+
+// The trace can be dumped and cleared while other threads record spans
+TEST(utility, tracing_concurrent_dump)
+{
+    constexpr size_t kRingSize = 16;
+
+    sse::crypto::clear_trace();
+    sse::crypto::enable_tracing(1, kRingSize);
+
+    std::atomic<bool>        stop{false};
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < 2; t++) {
+        writers.emplace_back([&stop]() {
+            // keyed objects cannot be shared between threads
+            sse::crypto::RCPrf<16> rc_prf(
+                sse::crypto::Key<sse::crypto::RCPrfParams::kKeySize>(), 5);
+            auto callback = [](uint64_t, std::array<uint8_t, 16>) {};
+
+            while (!stop.load()) {
+                rc_prf.eval_range(0, 10, callback);
+            }
+        });
+    }
+
+    for (size_t i = 0; i < 200; i++) {
+        std::ostringstream out;
+        sse::crypto::dump_trace(out);
+
+        // every dumped event is complete
+        const std::string trace  = out.str();
+        const size_t      events = count_occurrences(trace, "\"ph\":\"X\"");
+        EXPECT_LE(events, 2 * kRingSize);
+        EXPECT_EQ(events,
+                  count_occurrences(trace, "\"name\":\"RCPrf::eval_range\"")
+                      + count_occurrences(trace, "\"name\":\"Key::"));
+
+        if (i % 10 == 0) {
+            sse::crypto::clear_trace();
+        }
+    }
+
+    stop.store(true);
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    sse::crypto::disable_tracing();
+    sse::crypto::clear_trace();
+}